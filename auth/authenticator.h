@@ -32,6 +32,11 @@ public:
    * This method is thread-safe */
   virtual QString authenticate(QString login, QString password,
                                ParamSet ctxt = ParamSet()) const = 0;
+
+signals:
+  /** Emitted when users or passwords change, e.g. to invalidate caches of
+   * verified credentials. */
+  void changed();
 };
 
 #endif // AUTHENTICATOR_H
@@ -15,6 +15,9 @@
 #include <QMutexLocker>
 #include <QRegularExpression>
 #include <QCryptographicHash>
+#include <QPasswordDigestor>
+#include <QRandomGenerator>
+#include <QMessageAuthenticationCode>
 
 /*
  Examples of encoded passwords:
@@ -54,6 +57,8 @@ public:
           encoding = Md5Base64;
         else if (algo == "CLEARTEXT")
           encoding = Plain;
+        else if (algo == "PBKDF2-SHA256")
+          encoding = Pbkdf2Sha256;
         else // LATER RFC 2307 also define {CRYPT} algorithm
           encoding = Unknown;
         /*Log::fatal() << "login:" << userId << " password:" << encodedPassword
@@ -70,6 +75,8 @@ public:
       d = other.d;
     return *this;
   }
+  /** true if password check is deliberately slow */
+  bool isSlow() const { return d && d->_encoding == Pbkdf2Sha256; }
   bool authenticate(QString password) const {
     if (d) {
       QByteArray hash, salt;
@@ -77,6 +84,7 @@ public:
       switch(d->_encoding) {
       case Plain:
       case OpenLdapStyle:
+      case Pbkdf2Sha256:
       case Unknown:
         break;
       case Md4Hex:
@@ -93,6 +101,7 @@ public:
       switch(d->_encoding) {
       case Plain:
       case OpenLdapStyle:
+      case Pbkdf2Sha256:
       case Unknown:
         break;
       case Md4Hex:
@@ -130,6 +139,9 @@ public:
         granted = hash == QCryptographicHash::hash(password.toUtf8()+salt,
                                                    QCryptographicHash::Sha1);
         break;
+      case Pbkdf2Sha256:
+        granted = pbkdf2Sha256Matches(password);
+        break;
       case OpenLdapStyle:
       case Unknown:
         break;
@@ -142,10 +154,30 @@ public:
     }
     return false;
   }
+
+private:
+  bool pbkdf2Sha256Matches(QString password) const {
+    auto parts = d->_encodedPassword.split('$');
+    if (parts.size() != 3)
+      return false;
+    bool ok;
+    int iterations = parts[0].toInt(&ok);
+    auto salt = QByteArray::fromBase64(parts[1].replace('.', '+').toUtf8());
+    auto hash = QByteArray::fromBase64(parts[2].replace('.', '+').toUtf8());
+    if (!ok || iterations < 1 || hash.isEmpty())
+      return false;
+    return hash == QPasswordDigestor::deriveKeyPbkdf2(
+          QCryptographicHash::Sha256, password.toUtf8(), salt, iterations,
+          hash.size());
+  }
 };
 
 InMemoryAuthenticator::InMemoryAuthenticator(QObject *parent)
-  : Authenticator(parent) {
+  : Authenticator(parent), _failuresCacheKey(32, Qt::Uninitialized),
+    _failuresCache(4096) {
+  QRandomGenerator::system()->fillRange(
+        reinterpret_cast<quint32*>(_failuresCacheKey.data()),
+        _failuresCacheKey.size()/4);
 }
 
 InMemoryAuthenticator::~InMemoryAuthenticator() {
@@ -155,22 +187,49 @@ QString InMemoryAuthenticator::authenticate(QString login, QString password,
                                             ParamSet ctxt) const {
   Q_UNUSED(ctxt)
   QMutexLocker locker(&_mutex);
-  return _users.contains(login) && _users[login].authenticate(password)
-      ? login : QString();
+  auto user = _users.value(login);
+  if (!user.isSlow())
+    return user.authenticate(password) ? login : QString();
+  // slow hash: check recent failures, then derive the key without the lock
+  auto digest = QMessageAuthenticationCode::hash(
+        login.toUtf8()+'\0'+password.toUtf8(), _failuresCacheKey,
+        QCryptographicHash::Sha256);
+  auto failure = _failuresCache.object(digest);
+  if (failure && !failure->hasExpired())
+    return QString();
+  if (failure)
+    _failuresCache.remove(digest);
+  auto generation = _generation;
+  locker.unlock();
+  if (user.authenticate(password))
+    return login;
+  locker.relock();
+  // not if users changed meanwhile, password may have changed
+  if (_failuresCacheTtl > 0 && generation == _generation)
+    _failuresCache.insert(digest, new QDeadlineTimer(_failuresCacheTtl));
+  return QString();
 }
 
 InMemoryAuthenticator &InMemoryAuthenticator::insertUser(
     QString userId, QString encodedPassword, Encoding encoding) {
-  if (!userId.isEmpty()) {
-    QMutexLocker locker(&_mutex);
-    _users.insert(userId, User(userId, encodedPassword, encoding));
-  }
+  if (userId.isEmpty())
+    return *this;
+  QMutexLocker locker(&_mutex);
+  _users.insert(userId, User(userId, encodedPassword, encoding));
+  _failuresCache.clear();
+  ++_generation;
+  locker.unlock();
+  emit changed();
   return *this;
 }
 
 InMemoryAuthenticator &InMemoryAuthenticator::clearUsers() {
   QMutexLocker locker(&_mutex);
   _users.clear();
+  _failuresCache.clear();
+  ++_generation;
+  locker.unlock();
+  emit changed();
   return *this;
 }
 
@@ -179,6 +238,12 @@ bool InMemoryAuthenticator::containsUser(QString login) const {
   return _users.contains(login);
 }
 
+void InMemoryAuthenticator::setFailuresCacheTtl(int ms) {
+  QMutexLocker locker(&_mutex);
+  _failuresCacheTtl = ms;
+  _failuresCache.clear();
+}
+
 InMemoryAuthenticator::Encoding InMemoryAuthenticator::encodingFromString(
     QString text) {
   text = text.trimmed().toLower();
@@ -198,6 +263,8 @@ InMemoryAuthenticator::Encoding InMemoryAuthenticator::encodingFromString(
     return Sha1Base64;
   } else if (text == "ldap") {
     return OpenLdapStyle;
+  } else if (text == "pbkdf2" || text == "pbkdf2sha256") {
+    return Pbkdf2Sha256;
   } else {
     return Unknown;
   }
@@ -222,8 +289,22 @@ QString InMemoryAuthenticator::encodingToString(
     return "sha1b64";
   case OpenLdapStyle:
     return "ldap";
+  case Pbkdf2Sha256:
+    return "pbkdf2sha256";
   case Unknown:
     ;
   }
   return QString();
 }
+
+QString InMemoryAuthenticator::encodePbkdf2Sha256(
+    QString password, int iterations) {
+  QByteArray salt(16, Qt::Uninitialized);
+  QRandomGenerator::system()->fillRange(
+        reinterpret_cast<quint32*>(salt.data()), salt.size()/4);
+  auto hash = QPasswordDigestor::deriveKeyPbkdf2(
+        QCryptographicHash::Sha256, password.toUtf8(), salt, iterations, 32);
+  return QString::number(iterations)+"$"
+      +salt.toBase64(QByteArray::OmitTrailingEquals)+"$"
+      +hash.toBase64(QByteArray::OmitTrailingEquals);
+}
@@ -16,12 +16,27 @@
 
 #include "authenticator.h"
 #include <QMutex>
+#include <QCache>
+#include <QDeadlineTimer>
 
 /** In-memory users-passwords database.
  * Apart from plain (clear text) passwords, some current hash algorithms are
  * also supported.
  * All of them also allow salt (right bytes of a hash, after its expected
  * length depending on the algorithm, are expected to be the salt bytes).
+ *
+ * Pbkdf2Sha256 is a deliberately slow key derivation, encoded as
+ * "iterations$salt$hash" (salt and hash in base64, '.' being accepted instead
+ * of '+' as in OpenLDAP {PBKDF2-SHA256} values). With encodePbkdf2Sha256()
+ * default iterations it costs tens of milliseconds of CPU per authentication,
+ * which is only affordable if callers cache verified credentials, as
+ * BasicAuthHttpHandler does. Failed Pbkdf2Sha256 authentications are cached
+ * too, for a short time (see setFailuresCacheTtl()), so that a client
+ * retrying with the same wrong password does not pay again. A client trying
+ * different passwords still does: rate limit authentication failures
+ * upstream if such endpoints can be reached by untrusted clients.
+ * The key derivation is not performed under the users database lock, so
+ * that it does not serialize concurrent authentications.
  */
 class LIBP6CORESHARED_EXPORT InMemoryAuthenticator : public Authenticator {
   Q_OBJECT
@@ -29,10 +44,14 @@ class LIBP6CORESHARED_EXPORT InMemoryAuthenticator : public Authenticator {
   class User;
   QHash<QString,User> _users;
   mutable QMutex _mutex;
+  QByteArray _failuresCacheKey; // random HMAC key
+  mutable QCache<QByteArray,QDeadlineTimer> _failuresCache;
+  quint64 _generation = 0; // incremented whenever users change
+  int _failuresCacheTtl = 10'000;
 
 public:
   enum Encoding { Plain, Md4Hex, Md4Base64, Md5Hex, Md5Base64, Sha1Hex,
-                  Sha1Base64, OpenLdapStyle, Unknown = -1 };
+                  Sha1Base64, OpenLdapStyle, Pbkdf2Sha256, Unknown = -1 };
   // LATER support Sha224 to 512 when switching to Qt5
   explicit InMemoryAuthenticator(QObject *parent = 0);
   ~InMemoryAuthenticator();
@@ -46,8 +65,22 @@ public:
   InMemoryAuthenticator &clearUsers();
   /** This method is thread-safe */
   bool containsUser(QString login) const ;
+  /** How long, in ms, a failed Pbkdf2Sha256 authentication is remembered,
+   * for the same login and password, without deriving the key again.
+   * 0 disables the cache. Default: 10000 (10 seconds).
+   * This method is thread-safe */
+  void setFailuresCacheTtl(int ms);
   static InMemoryAuthenticator::Encoding encodingFromString(QString text);
   static QString encodingToString(InMemoryAuthenticator::Encoding encoding);
+  /** Encode a password for Pbkdf2Sha256, with a random 16 bytes salt.
+   * Default iterations count costs tens of ms of CPU per check, which is
+   * less than OWASP recommendation (600000) because every request with a new
+   * wrong password pays it: the more iterations, the easier for whoever can
+   * reach an endpoint to keep CPU cores busy just by sending bad passwords.
+   * Use more iterations only along with upstream rate limiting, or when
+   * access to such endpoints is already restricted. */
+  static QString encodePbkdf2Sha256(QString password,
+                                    int iterations = 100'000);
 };
 
 #endif // INMEMORYAUTHENTICATOR_H
@@ -12,59 +12,158 @@
  * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "inmemoryrulesauthorizer.h"
+#include "util/datacache.h"
+#include <QBitArray>
+
+namespace {
+
+std::atomic<quint64> _generations = 0;
+
+struct GroupKey {
+  quint64 _generation;
+  QBitArray _roles;
+  bool operator==(const GroupKey &) const = default;
+};
+
+inline size_t qHash(const GroupKey &key, size_t seed = 0) {
+  return qHashMulti(seed, key._generation, key._roles);
+}
+
+struct DecisionKey {
+  quint64 _generation;
+  QBitArray _roles;
+  QString _actionScope, _dataScope;
+  bool operator==(const DecisionKey &) const = default;
+};
+
+inline size_t qHash(const DecisionKey &key, size_t seed = 0) {
+  return qHashMulti(seed, key._generation, key._roles, key._actionScope,
+                    key._dataScope);
+}
+
+} // unnamed namespace
+
+/** Immutable copy of the rules, replaced as a whole when rules change. */
+struct InMemoryRulesAuthorizer::CompiledRules {
+  quint64 _generation = ++_generations; // unique among all authorizers
+  QList<Rule> _rules;
+  QHash<QString,qsizetype> _roles; // role -> bit in roles sets
+  /** user roles that matter to rules, as a bit array */
+  QBitArray roles(const QSet<QString> &userRoles) const {
+    QBitArray roles(_roles.size());
+    for (const auto &role: userRoles)
+      if (auto it = _roles.constFind(role); it != _roles.cend())
+        roles.setBit(it.value());
+    return roles;
+  }
+};
+
+/** Rules applying to a given set of roles, in order. */
+struct InMemoryRulesAuthorizer::RulesGroup {
+  QList<Rule> _rules;
+  // \A(?:(?=[\s\S]*?(?:pattern0))()|(?=[\s\S]*?(?:pattern1))()|...)
+  // the only empty capture group set tells the first rule matching
+  QRegularExpression _actionScopes;
+  bool _combined = false;
+
+  RulesGroup(const CompiledRules &compiled, const QBitArray &roles) {
+    for (const auto &rule: compiled._rules) {
+      bool applies = rule._roles.isEmpty();
+      for (const auto &role: rule._roles)
+        applies = applies || roles.testBit(compiled._roles.value(role));
+      if (applies)
+        _rules.append(rule);
+    }
+    // rules with their own capture groups, options or \Q..\E quoting would
+    // change meaning once combined: they are evaluated one by one
+    QStringList alternatives;
+    for (const auto &rule: std::as_const(_rules)) {
+      const auto &re = rule._actionScopePattern;
+      if (!re.isValid() || re.captureCount()
+          || re.patternOptions() != QRegularExpression::NoPatternOption
+          || re.pattern().contains("\\Q"))
+        return;
+      alternatives << "(?=[\\s\\S]*?(?:"+re.pattern()+"))()";
+    }
+    if (alternatives.size() < 2)
+      return;
+    _actionScopes.setPattern("\\A(?:"+alternatives.join('|')+")");
+    _combined = _actionScopes.isValid()
+        && _actionScopes.captureCount() == _rules.size();
+    if (_combined)
+      _actionScopes.optimize();
+  }
+
+  bool authorize(const QString &actionScope,
+                 const QString &dataScope) const {
+    qsizetype i = 0;
+    if (_combined) {
+      auto match = _actionScopes.match(actionScope);
+      if (!match.hasMatch())
+        return false; // no rule matches action scope
+      i = match.lastCapturedIndex()-1;
+      if (_rules[i]._dataScopePattern.match(dataScope).hasMatch())
+        return _rules[i]._allow;
+      ++i; // otherwise next rules are evaluated one by one
+    }
+    for (; i < _rules.size(); ++i) {
+      const auto &rule = _rules[i];
+      if (rule._actionScopePattern.match(actionScope).hasMatch()
+          && rule._dataScopePattern.match(dataScope).hasMatch())
+        // LATER implement timestamp-based authorization
+        return rule._allow;
+    }
+    return false;
+  }
+};
 
 InMemoryRulesAuthorizer::InMemoryRulesAuthorizer(QObject *parent)
   : Authorizer(parent) {
+  compile();
 }
 
 InMemoryRulesAuthorizer::InMemoryRulesAuthorizer(UsersDatabase *db) {
   setUsersDatabase(db);
+  compile();
 }
 
 InMemoryRulesAuthorizer::~InMemoryRulesAuthorizer() {
 }
 
-//#include "log/log.h"
 bool InMemoryRulesAuthorizer::authorizeUserData(
     UserData userData, QString actionScope, QString dataScope,
     QDateTime timestamp) const {
   Q_UNUSED(timestamp)
-  QMutexLocker locker(&_mutex);
-  //Log::fatal() << "authorize: i:" << userData.userId()
-  //             << " r:" << userData.roles() << " a:" << actionScope
-  //             << " d:" << dataScope << " t:" << timestamp;
-  for (const auto &rule: _rules) {
-    //Log::fatal() << "authorize rule: r:" << rule._roles
-    //             << " a:" << rule._actionScopePattern.pattern()
-    //             << " d:" << rule._dataScopePattern.pattern()
-    //             << " t:" << rule._timestampPattern.pattern()
-    //             << " allow:" << rule._allow;
-    if (rule._roles.isEmpty())
-      goto roleok;
-    for (const auto &role: userData.roles())
-      if (rule._roles.contains(role))
-        goto roleok;
-    //Log::fatal() << "authorize rule: roles not matching";
-    continue; // no role match between rule and user data
-roleok:;
-    if (!rule._actionScopePattern.match(actionScope).hasMatch()) {
-      //Log::fatal() << "authorize rule: action scope not matching";
-      continue;
-    }
-    if (!rule._dataScopePattern.match(dataScope).hasMatch()) {
-      //Log::fatal() << "authorize rule: data scope not matching";
-      continue;
-    }
-    //Log::fatal() << "authorize rule: matching";
-    // LATER implement timestamp-based authorization
-    return rule._allow;
-  }
-  return false;
+  // keys hold a generation, entries of former rules just age out of caches
+  static thread_local DataCache<DecisionKey,bool> _decisions { 4096 };
+  static thread_local DataCache<GroupKey,std::shared_ptr<const RulesGroup>>
+      _groups { 256 };
+  auto compiled = _compiled.load(std::memory_order_acquire);
+  auto roles = compiled->roles(userData.roles());
+  auto generation = compiled->_generation;
+  return _decisions.get_or_create(
+        { generation, roles, actionScope, dataScope }, [&]() {
+    auto group = _groups.get_or_create({ generation, roles }, [&]() {
+      return std::make_shared<const RulesGroup>(*compiled, roles);
+    });
+    return group->authorize(actionScope, dataScope);
+  });
+}
+
+void InMemoryRulesAuthorizer::compile() {
+  auto compiled = std::make_shared<CompiledRules>();
+  compiled->_rules = _rules;
+  for (const auto &rule: std::as_const(_rules))
+    for (const auto &role: rule._roles)
+      if (!compiled->_roles.contains(role))
+        compiled->_roles.insert(role, compiled->_roles.size());
+  _compiled.store(compiled, std::memory_order_release);
 }
 
 InMemoryRulesAuthorizer &InMemoryRulesAuthorizer::clearRules() {
   QMutexLocker locker(&_mutex);
   _rules.clear();
+  compile();
   return *this;
 }
 
@@ -75,6 +174,7 @@ InMemoryRulesAuthorizer &InMemoryRulesAuthorizer::appendRule(
   QMutexLocker locker(&_mutex);
   _rules.append(Rule(roles, actionScopePattern, dataScopePattern,
                      timestampPattern, allow));
+  compile();
   return *this;
 }
 
@@ -85,5 +185,6 @@ InMemoryRulesAuthorizer &InMemoryRulesAuthorizer::prependRule(
   QMutexLocker locker(&_mutex);
   _rules.prepend(Rule(roles, actionScopePattern, dataScopePattern,
                       timestampPattern, allow));
+  compile();
   return *this;
 }
@@ -18,6 +18,8 @@
 #include <QRegularExpression>
 #include <QMutex>
 #include "util/utf8stringset.h"
+#include <atomic>
+#include <memory>
 
 /** In-memory rules-list based authorizer.
  * The rules are evaluated in the list order.
@@ -27,7 +29,16 @@
  * In a rule, an empty or null criterion matches all authorization requests
  * (e.g. using QString() or QString("") or QRegularExpression() as
  * actionScopePattern will match any actionScope value). This is true even for
- * the roles criterion FIXME explain. */
+ * the roles criterion FIXME explain.
+ *
+ * Rules are compiled each time they change: for every set of user roles
+ * met, the rules applying to these roles are grouped and their action scope
+ * patterns combined into one regular expression that tells at once which is
+ * the first rule matching the action scope. Decisions are cached per thread
+ * by (roles, action scope, data scope), hence authorizeUserData() never
+ * locks and seldom evaluates a regular expression.
+ * Timestamp is not part of decisions (timestamp patterns are not implemented
+ * yet). */
 class LIBP6CORESHARED_EXPORT InMemoryRulesAuthorizer : public Authorizer {
   Q_OBJECT
   Q_DISABLE_COPY(InMemoryRulesAuthorizer)
@@ -45,8 +56,11 @@ class LIBP6CORESHARED_EXPORT InMemoryRulesAuthorizer : public Authorizer {
         _dataScopePattern(dataScopePattern),
         _timestampPattern(timestampPattern), _allow(allow) { }
   };
+  struct CompiledRules;
+  struct RulesGroup;
   QList<Rule> _rules;
-  mutable QMutex _mutex;
+  QMutex _mutex; // writers only
+  std::atomic<std::shared_ptr<const CompiledRules>> _compiled;
 
 public:
   explicit InMemoryRulesAuthorizer(QObject *parent = 0);
@@ -118,6 +132,9 @@ public:
                       QRegularExpression(timestampPattern),
                       false);
   }
+
+private:
+  inline void compile();
 };
 
 #endif // INMEMORYRULESAUTHORIZER_H
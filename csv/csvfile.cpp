@@ -12,13 +12,176 @@
  * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "csvfile.h"
+#include "csvreader.h"
+#include "util/utf8kernels.h"
 #include <QFile>
 #include <QBuffer>
+#include <QFileInfo>
+#include <QCryptographicHash>
+#include <QCache>
+#include <QMutex>
+#include <QDataStream>
+#include <QDateTime>
+#include <zlib.h>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+// Journal format: CSV rows with the same separators than the data file.
+// First row: magic, data file size and data file md5 when the journal was
+// created, so that a journal left behind by an interrupted compaction is
+// ignored.
+// Next rows: op, args..., CRC-32 of the row without checksum, where op is:
+// a,fields...           append row
+// i,row,fields...       insert row
+// u,row,fields...       update row
+// r,first,last          remove rows
+// The checksum is the last field because CsvReader drops trailing empty
+// fields.
+
+// Index format: QDataStream of magic, csv syntax (separators and headers
+// flag), data file size and mtime, rows per page, rows count, columns count
+// and offsets of every page first row.
+
+namespace {
+
+const Utf8String JournalMagic = "p6csvjournal2"_u8;
+const QByteArray IndexMagic = "p6csvindex1";
+const int PageRows = 256;
+
+Utf8String fileChecksum(const QString &filename) {
+  QFile file(filename);
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file))
+    return {};
+  return hash.result().toHex();
+}
+
+Utf8String recordChecksum(const QByteArray &record) {
+  auto p = reinterpret_cast<const Bytef *>(record.constData());
+  uLong crc = ::crc32(0, Z_NULL, 0);
+  for (qsizetype n = record.size(); n > 0; ) { // zlib uses uInt for sizes
+    uInt len = static_cast<uInt>(qMin<qsizetype>(n, 1 << 30));
+    crc = ::crc32(crc, p, len);
+    p += len;
+    n -= len;
+  }
+  return Utf8String::number(static_cast<quint32>(crc), 16);
+}
+
+bool endsWithNewline(const QString &filename) {
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+  if (file.size() == 0)
+    return true;
+  char c = 0;
+  return file.seek(file.size()-1) && file.getChar(&c) && c == '\n';
+}
+
+} // unnamed namespace
+
+class CsvFileIndex {
+public:
+  QMutex _mutex;
+  QFile _file;
+  QByteArray _syntax; // parameters the index depends on
+  char _fieldSeparator, _escapeChar, _quoteChar;
+  QList<qint64> _pageOffsets;
+  int _rowsCount = 0, _columnsCount = 0;
+  QCache<int,QList<Utf8StringList>> _pages;
+  CsvFileIndex(const QString &filename, char fieldSeparator, char escapeChar,
+               char quoteChar, bool headersEnabled, int pageCacheSize)
+    : _file(filename), _fieldSeparator(fieldSeparator),
+      _escapeChar(escapeChar), _quoteChar(quoteChar), _pages(pageCacheSize) {
+    _syntax.append(fieldSeparator).append(escapeChar).append(quoteChar)
+        .append(headersEnabled ? 'h' : '-');
+  }
+  bool load(const QFileInfo &info) {
+    QFile file(_file.fileName()+".index");
+    if (!file.open(QIODevice::ReadOnly))
+      return false;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    QByteArray magic, syntax;
+    qint64 size, mtime;
+    qint32 pageRows, rowsCount, columnsCount;
+    in >> magic >> syntax >> size >> mtime >> pageRows >> rowsCount
+        >> columnsCount >> _pageOffsets;
+    if (in.status() != QDataStream::Ok || magic != IndexMagic
+        || syntax != _syntax || size != info.size()
+        || mtime != info.lastModified().toMSecsSinceEpoch()
+        || pageRows != PageRows || rowsCount < 0
+        || _pageOffsets.size() != (rowsCount+PageRows-1)/PageRows) {
+      _pageOffsets.clear();
+      return false;
+    }
+    _rowsCount = rowsCount;
+    _columnsCount = columnsCount;
+    return true;
+  }
+  /** one pass through the file, from current position */
+  bool build(CsvReader *reader) {
+    Utf8StringList row;
+    bool atEnd = false;
+    _pageOffsets.clear();
+    _rowsCount = _columnsCount = 0;
+    while (!atEnd) {
+      qint64 pos = reader->pos();
+      if (!reader->readRow(&row, &atEnd))
+        return false;
+      if (atEnd && row.isEmpty())
+        break;
+      if (_rowsCount % PageRows == 0)
+        _pageOffsets.append(pos);
+      ++_rowsCount;
+      _columnsCount = qMax(_columnsCount, row.size());
+    }
+    return true;
+  }
+  /** failing to save index (e.g. read-only directory) is not an error */
+  void save(const QFileInfo &info) {
+    QSaveFile file(_file.fileName()+".index");
+    if (!file.open(QIODevice::WriteOnly))
+      return;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << IndexMagic << _syntax << info.size()
+        << info.lastModified().toMSecsSinceEpoch() << (qint32)PageRows
+        << (qint32)_rowsCount << (qint32)_columnsCount << _pageOffsets;
+    if (out.status() == QDataStream::Ok)
+      file.commit();
+  }
+  Utf8StringList row(int row) {
+    if (row < 0 || row >= _rowsCount)
+      return {};
+    QMutexLocker locker(&_mutex);
+    int page = row / PageRows;
+    auto rows = _pages.object(page);
+    if (!rows) {
+      rows = new QList<Utf8StringList>;
+      if (_file.seek(_pageOffsets[page])) {
+        CsvReader reader(&_file, _fieldSeparator, _escapeChar, _quoteChar);
+        Utf8StringList r;
+        bool atEnd = false;
+        int n = qMin(PageRows, _rowsCount-page*PageRows);
+        while (rows->size() < n && !atEnd && reader.readRow(&r, &atEnd))
+          if (!atEnd || !r.isEmpty())
+            rows->append(r);
+      }
+      _pages.insert(page, rows);
+    }
+    return rows->value(row % PageRows);
+  }
+};
 
 CsvFile::CsvFile(QObject *parent)
   : QObject(parent), _openMode(QIODevice::NotOpen),
     _fieldSeparator(','), _escapeChar('\\'), _quoteChar('"'),
-    _headersEnabled(true), _columnCount(0) {
+    _headersEnabled(true), _columnCount(0), _journalingEnabled(false),
+    _syncBatchSize(1), _compactionThreshold(1024), _journalRecords(0),
+    _unsyncedWrites(0), _rewriteNeeded(false), _lazyLoadingEnabled(false),
+    _pageCacheSize(16), _index(0) {
 }
 
 CsvFile::CsvFile(QObject *parent, const QString &filename)
@@ -31,19 +194,86 @@ CsvFile::CsvFile(QObject *parent, QIODevice *input)
   openReadonly(input);
 }
 
+CsvFile::~CsvFile() {
+  close();
+}
+
 bool CsvFile::open(QIODevice::OpenMode mode) {
   close();
+  if (_lazyLoadingEnabled) {
+    _openMode = mode;
+    if (!(mode & QIODevice::WriteOnly) && !_journalingEnabled && openIndex())
+      return true;
+    close();
+    return false;
+  }
   QFile file(_filename);
   if (file.open(_openMode = mode)) {
-    if (!(mode & QIODevice::ReadOnly))
-      return true;
-    if (readAll(&file))
+    // a torn last row is only possible if a session was interrupted while
+    // appending rows, otherwise an unterminated last line is a regular row
+    bool tornTailPossible = _journalingEnabled
+        && QFile::exists(_filename+".appending");
+    qint64 validSize = 0;
+    bool ok = !(mode & QIODevice::ReadOnly)
+        || readAll(&file, tornTailPossible ? &validSize : 0);
+    if (!tornTailPossible && (!_headersEnabled || !_headers.isEmpty()))
+      validSize = file.size();
+    file.close();
+    if (ok && (!_journalingEnabled || openJournal(validSize)))
       return true;
   }
   close();
   return false;
 }
 
+bool CsvFile::openIndex() {
+  _index = new CsvFileIndex(
+        _filename, _fieldSeparator.toLatin1(), _escapeChar.toLatin1(),
+        _quoteChar.toLatin1(), _headersEnabled, _pageCacheSize);
+  if (!_index->_file.open(QIODevice::ReadOnly))
+    return false;
+  CsvReader reader(&_index->_file, _fieldSeparator.toLatin1(),
+                   _escapeChar.toLatin1(), _quoteChar.toLatin1());
+  bool atEnd = false;
+  if (_headersEnabled && !reader.readRow(&_headers, &atEnd))
+    return false;
+  QFileInfo info(_filename);
+  if (!_index->load(info)) {
+    if (!atEnd && !_index->build(&reader))
+      return false;
+    _index->save(info);
+  }
+  _columnCount = qMax<int>(_headers.size(), _index->_columnsCount);
+  return true;
+}
+
+QList<QStringList> CsvFile::rows() const {
+  QList<QStringList> rows;
+  int count = rowCount();
+  rows.reserve(count);
+  for (int i = 0; i < count; ++i)
+    rows.append(utf8Row(i).toUtf16StringList());
+  return rows;
+}
+
+QList<Utf8StringList> CsvFile::utf8Rows() const {
+  if (!_index)
+    return _rows;
+  QList<Utf8StringList> rows;
+  rows.reserve(_index->_rowsCount);
+  for (int i = 0; i < _index->_rowsCount; ++i)
+    rows.append(_index->row(i));
+  return rows;
+}
+
+Utf8StringList CsvFile::utf8Row(int row) const {
+  return _index ? _index->row(row) : _rows.value(row);
+}
+
+int CsvFile::rowCount() const {
+  return _index ? _index->_rowsCount : _rows.size();
+}
+
 bool CsvFile::open(const QString &filename, QIODevice::OpenMode mode) {
   _filename = filename;
   return open(mode);
@@ -63,6 +293,11 @@ bool CsvFile::openReadonly(QByteArray input) {
 }
 
 void CsvFile::close() {
+  sync();
+  closeJournal();
+  _rewriteNeeded = false;
+  delete _index;
+  _index = 0;
   _rows.clear();
   _headers.clear();
   _columnCount = 0;
@@ -82,9 +317,13 @@ bool CsvFile::insertRow(int row, const QStringList &data) {
   if (row < 0 || row > _rows.size())
     return false;
   if (_openMode & QIODevice::WriteOnly) {
+    bool appending = row == _rows.size();
     _rows.insert(row, data);
     _columnCount = qMax(_columnCount, data.size());
-    return writeAll();
+    if (appending)
+      return writeAppendedRow(_rows[row]);
+    return writeJournalRecord(Utf8StringList{"i", Utf8String::number(row)}
+                              + _rows[row]);
   }
   return false;
 }
@@ -95,7 +334,8 @@ bool CsvFile::updateRow(int row, const QStringList &data){
   if (_openMode & QIODevice::WriteOnly) {
     _rows[row] = data;
     _columnCount = qMax(_columnCount, data.size());
-    return writeAll();
+    return writeJournalRecord(Utf8StringList{"u", Utf8String::number(row)}
+                              + _rows[row]);
   }
   return false;
 }
@@ -111,109 +351,276 @@ bool CsvFile::removeRows(int first, int last) {
     int count = last - first + 1;
     while (count--)
       _rows.removeAt(first);
-    return writeAll();
+    return writeJournalRecord(
+          { "r", Utf8String::number(first), Utf8String::number(last) });
   }
   return false;
 }
 
-bool CsvFile::readAll(QIODevice *input) {
+bool CsvFile::sync() {
+  _unsyncedWrites = 0;
+  // data file first, since journal records depend on its content
+  return syncFile(&_dataFile) && syncFile(&_journalFile);
+}
+
+bool CsvFile::compact() {
+  return (_openMode & QIODevice::WriteOnly) && writeAll();
+}
+
+/** If validSize is set, an unterminated last row is considered as a torn
+ * write and ignored, and validSize receives the size of complete rows. */
+bool CsvFile::readAll(QIODevice *input, qint64 *validSize) {
+  CsvReader reader(input, _fieldSeparator.toLatin1(), _escapeChar.toLatin1(),
+                   _quoteChar.toLatin1());
   bool atEnd = false;
   if (_headersEnabled) {
-    if (!readRow(input, &_headers, &atEnd))
+    if (!reader.readRow(&_headers, &atEnd))
       return false;
+    if (validSize) {
+      if (atEnd)
+        _headers.clear();
+      else
+        *validSize = reader.pos();
+    }
     _columnCount = _headers.size();
   }
   while (!atEnd) {
-    QStringList row;
-    if (!readRow(input, &row, &atEnd))
+    Utf8StringList row;
+    if (!reader.readRow(&row, &atEnd))
       return false;
-    if (!atEnd || !row.isEmpty())
+    if (!atEnd || (!row.isEmpty() && !validSize))
       _rows.append(row);
+    if (!atEnd && validSize)
+      *validSize = reader.pos();
     _columnCount = qMax(_columnCount, row.size());
   }
   return true;
 }
 
-bool CsvFile::readRow(QIODevice *input, QStringList *row, bool *atEnd) {
-  row->clear();
-  // LATER call waitForReadyRead() with a parametrized timeout (named pipes...)
-  QByteArray data;
-  bool quoting = false;
-  forever {
-    char c;
-    switch (input->read(&c, 1)) {
-    case 0: // end of file
-      *atEnd = true;
-      return true;
-    case 1:
-      if (c == _escapeChar) {
-        switch (input->read(&c, 1)) {
-        case 0:
-          *atEnd = true;
-          break; // ignore lone \ at end of file
-        case 1:
-          data.append(c);
-          break;
-        default: // error
-          return false;
-        }
-      } else if (c == _quoteChar) {
-        quoting = !quoting;
-      } else if (!quoting && c == _fieldSeparator) {
-        row->append(QString::fromUtf8(data));
-        data.clear();
-      } else if (c == '\r') {
-        // silently ignore \r
-      } else if (!quoting && c == '\n') {
-        if (!data.isEmpty())
-          row->append(QString::fromUtf8(data));
-        return true;
-      } else {
-        data.append(c);
-      }
-      break;
-    default: // error
-      return false;
-    }
-  }
-}
-
 bool CsvFile::writeAll() {
   if (_openMode & QIODevice::WriteOnly) {
     QSaveFile file(_filename);
     if (file.open(QIODevice::WriteOnly)) {
-      QString specialChars("\r\n");
-      specialChars.append(_fieldSeparator).append(_escapeChar)
-          .append(_quoteChar);
+      QByteArray chars = specialChars();
       if (_headersEnabled)
-        if (!writeRow(&file, _headers, specialChars))
+        if (!writeRow(&file, _headers, chars))
           return false;
       for (const auto &row: _rows)
-        if (!writeRow(&file, row, specialChars))
+        if (!writeRow(&file, row, chars))
           return false;
-      return file.commit();
+      if (!file.commit())
+        return false;
+      if (!_journalingEnabled)
+        return true;
+      // data file was replaced by a compacted one: reopen it, drop journal
+      closeJournal();
+      _rewriteNeeded = false;
+      _journalFile.setFileName(_filename+".journal");
+      return (!_journalFile.exists() || _journalFile.remove())
+          && openDataFile();
     }
   }
   return false;
 }
 
-bool CsvFile::writeRow(QSaveFile *file, const QStringList &row,
-                       const QString &specialChars) {
-  QString s;
+bool CsvFile::writeRow(QIODevice *file, const Utf8StringList &row,
+                       const QByteArray &specialChars) {
+  QByteArray bytes = formatRow(row, specialChars);
+  return (file->write(bytes) == bytes.size());
+}
+
+QByteArray CsvFile::formatRow(const Utf8StringList &row,
+                              const QByteArray &specialChars) const {
+  QByteArray bytes;
   bool firstColumn = true;
   for (const auto &cell: row) {
     if (firstColumn)
       firstColumn = false;
     else
-      s.append(_fieldSeparator);
-    for (int i = 0; i < cell.size(); ++i) {
-      QChar c = cell.at(i);
-      if (specialChars.contains(c))
-        s.append(_escapeChar);
-      s.append(c);
+      bytes.append(_fieldSeparator.toLatin1());
+    for (auto s = cell.constData(), end = s+cell.size(); s < end; ) {
+      auto n = p6::utf8::prefix_size_not_in(s, end, specialChars);
+      bytes.append(s, n);
+      s += n;
+      if (s < end)
+        bytes.append(_escapeChar.toLatin1()).append(*s++);
     }
   }
-  s.append('\n');
-  QByteArray bytes = s.toUtf8();
-  return (file->write(bytes) == bytes.size());
+  bytes.append('\n');
+  return bytes;
+}
+
+QByteArray CsvFile::specialChars() const {
+  QByteArray specialChars("\r\n");
+  specialChars.append(_fieldSeparator.toLatin1()).append(_escapeChar.toLatin1())
+      .append(_quoteChar.toLatin1());
+  return specialChars;
+}
+
+bool CsvFile::openJournal(qint64 validSize) {
+  bool readable = _openMode & QIODevice::ReadOnly,
+      writable = _openMode & QIODevice::WriteOnly;
+  qint64 journalSize = 0;
+  _journalFile.setFileName(_filename+".journal");
+  _journalRecords = 0;
+  if (readable && _journalFile.exists() && !replayJournal(&journalSize))
+    return false;
+  if (!writable)
+    return true;
+  // write only mode truncated the file, appending rows to a file without
+  // headers row would make the first one become headers and appending to an
+  // unterminated last line would merge both rows
+  _rewriteNeeded = !readable || (_headersEnabled && !validSize);
+  if (readable && QFileInfo(_filename).size() > validSize
+      && !QFile::resize(_filename, validSize)) // drop torn last row
+    return false;
+  if (readable && !endsWithNewline(_filename))
+    _rewriteNeeded = true;
+  if (!openDataFile())
+    return false;
+  if (!journalSize)
+    return !_journalFile.exists() || _journalFile.remove();
+  return QFile::resize(_journalFile.fileName(), journalSize) // drop bad tail
+      && _journalFile.open(QIODevice::WriteOnly|QIODevice::Append);
+}
+
+/** Open data file for appending, after having created the marker telling
+ * that the file may end with a torn row if the session is interrupted. */
+bool CsvFile::openDataFile() {
+  QFile marker(_filename+".appending");
+  if (!marker.exists()
+      && (!marker.open(QIODevice::WriteOnly) || !syncFile(&marker)))
+    return false;
+  _dataFile.setFileName(_filename);
+  return _dataFile.open(QIODevice::WriteOnly|QIODevice::Append);
+}
+
+/** Apply journal records, if the journal matches the data file.
+ * @param validSize receives the size of valid records, 0 if the journal must
+ * be ignored */
+bool CsvFile::replayJournal(qint64 *validSize) {
+  *validSize = 0;
+  if (!_journalFile.open(QIODevice::ReadOnly))
+    return false;
+  CsvReader reader(&_journalFile, _fieldSeparator.toLatin1(),
+                   _escapeChar.toLatin1(), _quoteChar.toLatin1());
+  Utf8StringList record;
+  bool atEnd = false;
+  if (!reader.readRow(&record, &atEnd)) {
+    _journalFile.close();
+    return false;
+  }
+  if (!atEnd && record.size() == 3 && record[0] == JournalMagic
+      && record[1].toLongLong<false,false>(nullptr, 10)
+         == QFileInfo(_filename).size()
+      && record[2] == fileChecksum(_filename)) {
+    *validSize = reader.pos();
+    while (!atEnd) {
+      if (!reader.readRow(&record, &atEnd)) {
+        _journalFile.close();
+        return false;
+      }
+      // stop at first torn or corrupted record, next ones cannot be trusted
+      if (atEnd || !applyJournalRecord(record))
+        break;
+      *validSize = reader.pos();
+      ++_journalRecords;
+    }
+  } // otherwise: journal of another data file version, ignore it
+  _journalFile.close();
+  return true;
+}
+
+bool CsvFile::applyJournalRecord(const Utf8StringList &record) {
+  Utf8StringList fields = record.mid(0, record.size()-1);
+  if (fields.isEmpty()
+      || record.last() != recordChecksum(formatRow(fields, specialChars())))
+    return false;
+  Utf8String op = fields.takeFirst();
+  if (op == "a") {
+    _rows.append(fields);
+    _columnCount = qMax(_columnCount, fields.size());
+    return true;
+  }
+  bool ok;
+  int row = fields.value(0).toInt<false,false>(&ok, 10);
+  if (!ok || row < 0)
+    return false;
+  fields.removeFirst();
+  if (op == "i" && row <= _rows.size()) {
+    _rows.insert(row, fields);
+  } else if (op == "u" && row < _rows.size()) {
+    _rows[row] = fields;
+  } else if (op == "r" && fields.size() == 1) {
+    int last = fields[0].toInt<false,false>(&ok, 10);
+    if (!ok || row > last || last >= _rows.size())
+      return false;
+    _rows.remove(row, last-row+1);
+    return true;
+  } else {
+    return false;
+  }
+  _columnCount = qMax(_columnCount, fields.size());
+  return true;
+}
+
+bool CsvFile::writeAppendedRow(const Utf8StringList &row) {
+  if (!_journalingEnabled || _rewriteNeeded)
+    return writeAll();
+  if (_journalFile.isOpen()) // once there is a journal, keep changes order
+    return writeJournalRecord(Utf8StringList{"a"} + row);
+  return writeWithSync(&_dataFile, formatRow(row, specialChars()));
+}
+
+bool CsvFile::writeJournalRecord(const Utf8StringList &record) {
+  if (!_journalingEnabled || _rewriteNeeded)
+    return writeAll();
+  QByteArray chars = specialChars();
+  if (!_journalFile.isOpen()) {
+    // the data file must be on disk before a journal that depends on it
+    Utf8String checksum;
+    if (!syncFile(&_dataFile)
+        || (checksum = fileChecksum(_filename)).isEmpty()
+        || !_journalFile.open(QIODevice::WriteOnly|QIODevice::Truncate)
+        || !writeRow(&_journalFile, { JournalMagic, Utf8String::number(
+                                        _dataFile.size()), checksum }, chars))
+      return false;
+  }
+  Utf8StringList row = record;
+  row.append(recordChecksum(formatRow(record, chars)));
+  if (!writeWithSync(&_journalFile, formatRow(row, chars)))
+    return false;
+  if (++_journalRecords >= _compactionThreshold)
+    return compact();
+  return true;
+}
+
+bool CsvFile::writeWithSync(QFile *file, const QByteArray &bytes) {
+  if (file->write(bytes) != bytes.size() || !file->flush())
+    return false;
+  if (++_unsyncedWrites >= _syncBatchSize)
+    return sync();
+  return true;
+}
+
+bool CsvFile::syncFile(QFile *file) {
+  if (!file->isOpen())
+    return true;
+  if (!file->flush())
+    return false;
+#ifdef Q_OS_UNIX
+  return ::fsync(file->handle()) == 0;
+#else
+  return true; // LATER FlushFileBuffers() on Windows
+#endif
+}
+
+void CsvFile::closeJournal() {
+  if (_dataFile.isOpen()) { // data file synced, its last row is complete
+    _dataFile.close();
+    QFile::remove(_filename+".appending");
+  }
+  _journalFile.close();
+  _journalRecords = 0;
+  _unsyncedWrites = 0;
 }
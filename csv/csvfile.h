@@ -17,24 +17,67 @@
 #include "libp6core_global.h"
 #include <QIODevice>
 #include <QSaveFile>
+#include <QFile>
 #include "util/utf8stringlist.h"
 
+class CsvFileIndex;
+
 // LATER implement auto-truncating / rows-count-caped mechanism
-// LATER propose a non-all-in-memory mechanism
 // LATER support for error() errorString() error reporting
 // LATER implement quoting on write
 
-/** Give read/write access to a CSV file content. */
+/** Give read/write access to a CSV file content.
+ *
+ * By default every change rewrites the whole file through a QSaveFile, which
+ * is atomic but costs O(file size) per change.
+ *
+ * In journaled mode (see enableJournaling()), appended rows are written at
+ * the end of the file, and other changes (inserts, updates, removes) are
+ * written to a journal file next to it (filename+".journal") which is
+ * replayed on open. Once the journal reaches compactionThreshold() records,
+ * or when compact() is called, the file is rewritten through a QSaveFile and
+ * the journal is removed.
+ * Files are fsync-ed every syncBatchSize() changes, on sync() and on close().
+ * After a crash the content is always a consistent prefix of the history of
+ * changes: a torn last row is dropped, journal records are checksummed
+ * (CRC-32) and a journal that does not match the file (e.g. crash during a
+ * compaction) is ignored. With the default batch size of 1 no acknowledged
+ * change is lost, with bigger batches at most the last unsynced batch can be
+ * lost.
+ * While rows are appended, a marker file (filename+".appending") exists: an
+ * unterminated last line is only considered as a torn write, and dropped,
+ * when this marker was left behind by an interrupted session. Otherwise
+ * (e.g. a file written by another tool without final newline) the last line
+ * is kept and the file is rewritten on first change.
+ *
+ * With lazy loading (see enableLazyLoading()), rows are not loaded in memory
+ * but read on demand through a small LRU cache of pages of consecutive rows,
+ * using a row offsets index, which makes it possible to read files far larger
+ * than RAM. The index is built on first open and persisted next to the file
+ * (filename+".index"), it is rebuilt when the file size or modification time
+ * changes.
+ * Lazy loading is read-only and incompatible with journaling.
+ * Reading rows in lazy loading mode is thread-safe.
+ */
 class LIBP6CORESHARED_EXPORT CsvFile : public QObject {
   Q_OBJECT
   Q_DISABLE_COPY(CsvFile)
   QString _filename;
   QIODevice::OpenMode _openMode;
-  QList<QStringList> _rows;
-  QStringList _headers;
+  QList<Utf8StringList> _rows;
+  Utf8StringList _headers;
   QChar _fieldSeparator, _escapeChar, _quoteChar;
   bool _headersEnabled;
   int _columnCount;
+  bool _journalingEnabled;
+  int _syncBatchSize, _compactionThreshold;
+  // journaled mode state, only open in journaled write mode
+  QFile _dataFile, _journalFile;
+  int _journalRecords, _unsyncedWrites;
+  bool _rewriteNeeded; // file content does not match _headers and _rows
+  bool _lazyLoadingEnabled;
+  int _pageCacheSize;
+  CsvFileIndex *_index; // only set in lazy loading mode
 
 public:
   explicit CsvFile(QObject *parent = 0);
@@ -42,14 +85,23 @@ public:
   explicit CsvFile(const QString &filename) : CsvFile(0, filename) { }
   CsvFile(QObject *parent, QIODevice *input);
   explicit CsvFile(QIODevice *input) : CsvFile(0, input) { }
-  QStringList headers() const { return _headers; }
-  QString header(int column) const { return headers().value(column); }
-  QList<QStringList> rows() const { return _rows; }
-  QStringList row(int row) const { return _rows.value(row); }
+  ~CsvFile();
+  QStringList headers() const { return _headers.toUtf16StringList(); }
+  QString header(int column) const {
+    return _headers.value(column).toUtf16(); }
+  /** In lazy loading mode, this reads the whole file. */
+  QList<QStringList> rows() const;
+  QStringList row(int row) const { return utf8Row(row).toUtf16StringList(); }
   QString cell(int row, int column) const {
-    return _rows.value(row).value(column); }
+    return utf8Row(row).value(column).toUtf16(); }
+  Utf8StringList utf8Headers() const { return _headers; }
+  /** In lazy loading mode, this reads the whole file. */
+  QList<Utf8StringList> utf8Rows() const;
+  Utf8StringList utf8Row(int row) const;
+  Utf8String utf8Cell(int row, int column) const {
+    return utf8Row(row).value(column); }
   int columnCount() const { return _columnCount; }
-  int rowCount() const { return _rows.size(); }
+  int rowCount() const;
   bool open(QIODevice::OpenMode mode);
   bool open(const QString &filename, QIODevice::OpenMode mode);
   bool openReadonly(QIODevice *input);
@@ -76,6 +128,30 @@ public:
   /** Default: true (first file line contains headers rather than data) */
   CsvFile &enableHeaders(bool headersEnabled = true) {
     _headersEnabled = headersEnabled; return *this; }
+  bool journalingEnabled() const { return _journalingEnabled; }
+  /** Default: false (every change rewrites the whole file)
+   *  Must be set before open(). */
+  CsvFile &enableJournaling(bool journalingEnabled = true) {
+    _journalingEnabled = journalingEnabled; return *this; }
+  int syncBatchSize() const { return _syncBatchSize; }
+  /** Default: 1 (fsync after every change), only used in journaled mode */
+  CsvFile &setSyncBatchSize(int syncBatchSize) {
+    _syncBatchSize = qMax(1, syncBatchSize); return *this; }
+  int compactionThreshold() const { return _compactionThreshold; }
+  /** Default: 1024 journal records, only used in journaled mode */
+  CsvFile &setCompactionThreshold(int compactionThreshold) {
+    _compactionThreshold = qMax(1, compactionThreshold); return *this; }
+  bool lazyLoadingEnabled() const { return _lazyLoadingEnabled; }
+  /** Default: false (whole file is loaded in memory by open())
+   *  Must be set before open(), which will then fail if write mode is
+   *  requested or journaling is enabled. */
+  CsvFile &enableLazyLoading(bool lazyLoadingEnabled = true) {
+    _lazyLoadingEnabled = lazyLoadingEnabled; return *this; }
+  int pageCacheSize() const { return _pageCacheSize; }
+  /** Default: 16 pages of 256 rows, only used in lazy loading mode.
+   *  Must be set before open(). */
+  CsvFile &setPageCacheSize(int pageCacheSize) {
+    _pageCacheSize = qMax(1, pageCacheSize); return *this; }
   bool setHeaders(const QStringList &data);
 
 public slots:
@@ -83,13 +159,29 @@ public slots:
   bool updateRow(int row, const QStringList &data);
   bool appendRow(const QStringList &data);
   bool removeRows(int first, int last);
+  /** Flush and fsync pending journaled mode writes. */
+  bool sync();
+  /** Rewrite the whole file and remove the journal, in journaled mode. */
+  bool compact();
 
 private:
-  bool readAll(QIODevice *input);
-  inline bool readRow(QIODevice *input, QStringList *row, bool *atEnd);
+  bool readAll(QIODevice *input, qint64 *validSize = 0);
+  bool openIndex();
   bool writeAll();
-  inline bool writeRow(QSaveFile *file, const QStringList &row,
-                       const QString &specialChars);
+  inline bool writeRow(QIODevice *file, const Utf8StringList &row,
+                       const QByteArray &specialChars);
+  QByteArray formatRow(const Utf8StringList &row,
+                       const QByteArray &specialChars) const;
+  QByteArray specialChars() const;
+  bool openJournal(qint64 validSize);
+  bool openDataFile();
+  bool replayJournal(qint64 *validSize);
+  bool applyJournalRecord(const Utf8StringList &record);
+  bool writeAppendedRow(const Utf8StringList &row);
+  bool writeJournalRecord(const Utf8StringList &record);
+  bool writeWithSync(QFile *file, const QByteArray &bytes);
+  bool syncFile(QFile *file);
+  void closeJournal();
 };
 
 #endif // CSVFILE_H
@@ -35,7 +35,7 @@ int CsvFileModel::rowCount(const QModelIndex &parent) const {
 
 QVariant CsvFileModel::data(const QModelIndex &index, int role) const {
   if (_csvFile && role == Qt::DisplayRole && index.isValid())
-    return _csvFile->row(index.row()).value(index.column());
+    return _csvFile->cell(index.row(), index.column());
   return QVariant();
 }
 
@@ -0,0 +1,87 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "csvreader.h"
+#include "util/utf8kernels.h"
+
+CsvReader::CsvReader(QIODevice *input, char fieldSeparator, char escapeChar,
+                     char quoteChar, qsizetype blockSize)
+  : _input(input), _buffer(qMax<qsizetype>(blockSize, 1), Qt::Uninitialized),
+    _begin(0), _end(0), _offset(input ? input->pos() : 0),
+    _fieldSeparator(fieldSeparator), _escapeChar(escapeChar),
+    _quoteChar(quoteChar),
+    _specialChars { fieldSeparator, escapeChar, quoteChar, '\r', '\n' },
+    _eof(!input), _error(false) {
+}
+
+void CsvReader::appendField(Utf8StringList *row) {
+  row->append(Utf8String(_field.constData(), _field.size()));
+  _field.resize(0); // rather than clear(), to keep capacity
+}
+
+bool CsvReader::readRow(Utf8StringList *row, bool *atEnd) {
+  row->clear();
+  _field.resize(0);
+  QByteArrayView specialChars(_specialChars, sizeof _specialChars);
+  bool quoting = false;
+  // LATER call waitForReadyRead() with a parametrized timeout (named pipes...)
+  forever {
+    if (_begin == _end && !refill()) { // end of input
+      *atEnd = true;
+      if (!_field.isEmpty())
+        appendField(row);
+      return !_error;
+    }
+    // copy regular bytes at once, up to next special char or end of buffer
+    const char *s = _buffer.constData()+_begin, *end = _buffer.constData()+_end;
+    auto n = p6::utf8::prefix_size_not_in(s, end, specialChars);
+    _field.append(s, n);
+    _begin += n;
+    if (_begin == _end)
+      continue;
+    char c = s[n];
+    ++_begin;
+    if (c == _escapeChar) {
+      if (_begin == _end && !refill())
+        continue; // ignore lone escape char at end of input
+      _field.append(_buffer.at(_begin++));
+    } else if (c == _quoteChar) {
+      quoting = !quoting;
+    } else if (!quoting && c == _fieldSeparator) {
+      appendField(row);
+    } else if (c == '\r') {
+      // silently ignore \r
+    } else if (!quoting && c == '\n') {
+      if (!_field.isEmpty())
+        appendField(row);
+      return true;
+    } else {
+      _field.append(c);
+    }
+  }
+}
+
+bool CsvReader::refill() {
+  if (_eof)
+    return false;
+  _offset += _end;
+  _begin = _end = 0;
+  auto n = _input->read(_buffer.data(), _buffer.size());
+  if (n <= 0) {
+    _eof = true;
+    _error = n < 0;
+    return false;
+  }
+  _end = n;
+  return true;
+}
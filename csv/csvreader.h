@@ -0,0 +1,66 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include "util/utf8stringlist.h"
+#include <QIODevice>
+
+/** Fast CSV rows reader, used by CsvFile and ParamSet.
+ *
+ * Reads input by blocks and searches separators, quotes, escapes and end of
+ * lines with vectorized kernels, copying fields bytes once to Utf8String,
+ * without any utf-16 conversion.
+ *
+ * Syntax is the one written by CsvFile:
+ * - escape char (default: \) makes next byte a regular one
+ * - quote char (default: ") toggles quoting, within which field separators
+ *   and newlines are regular chars, quote chars are not part of fields
+ * - \r are always ignored (unless escaped)
+ * - an empty last field is ignored, e.g. "a,\n" is read as { "a" }
+ * - the last line needs not to end with \n
+ *
+ * Since input is read by blocks, input position after reading is undefined,
+ * use pos() to know where the last read row ended.
+ */
+class LIBP6CORESHARED_EXPORT CsvReader {
+  QIODevice *_input;
+  QByteArray _buffer, _field;
+  qsizetype _begin, _end; // unread bytes in _buffer
+  qint64 _offset; // input position of _buffer first byte
+  char _fieldSeparator, _escapeChar, _quoteChar;
+  char _specialChars[5];
+  bool _eof, _error;
+
+public:
+  explicit CsvReader(QIODevice *input, char fieldSeparator = ',',
+                     char escapeChar = '\\', char quoteChar = '"',
+                     qsizetype blockSize = 65536);
+  CsvReader(const CsvReader &) = delete;
+  CsvReader &operator=(const CsvReader &) = delete;
+  /** Read next row.
+   *  @param atEnd set to true when the end of input has been reached, in
+   *  which case row is the unterminated last line (often empty)
+   *  @return false on read error */
+  bool readRow(Utf8StringList *row, bool *atEnd);
+  /** Input position just after the last byte consumed by readRow(). */
+  qint64 pos() const { return _offset+_begin; }
+  bool error() const { return _error; }
+
+private:
+  inline void appendField(Utf8StringList *row);
+  bool refill();
+};
+
+#endif // CSVREADER_H
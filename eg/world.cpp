@@ -0,0 +1,811 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "world.h"
+#include "log/log.h"
+#include <QFile>
+#include <QReadWriteLock>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <numeric>
+
+namespace p6 {
+
+namespace {
+
+const quint64 Max = ~0ULL;
+
+/** bytewise comparison, the one of memcmp() */
+inline int compare(QByteArrayView a, QByteArrayView b) {
+  int c = ::memcmp(a.data(), b.data(), qMin(a.size(), b.size()));
+  return c ? c : (a.size() > b.size()) - (a.size() < b.size());
+}
+
+/** Value as a heap record: type byte then payload, which is utf8 text,
+ *  little endian entity ids or etv depending on type. */
+QByteArray record(const TypedValue &value) {
+  QByteArray record;
+  auto type = value.type();
+  if (type == TypedValue::Null)
+    return record;
+  record.append(static_cast<char>(type));
+  switch (type) {
+    case TypedValue::Utf8:
+      record.append(value.as_utf8());
+      break;
+    case TypedValue::Entity8:
+    case TypedValue::Entity8Vector:
+      for (auto e: type == TypedValue::Entity8
+           ? std::vector<Entity>{ value.entity8() }
+           : value.as_entityvector({}, nullptr)) {
+        char le[8];
+        qToLittleEndian(e.id(), le);
+        record.append(le, 8);
+      }
+      break;
+    default:
+      record.append(value.as_etv());
+  }
+  return record;
+}
+
+TypedValue decode(QByteArrayView record) {
+  if (record.isEmpty())
+    return {};
+  auto type = static_cast<TypedValue::Type>(static_cast<quint8>(record[0]));
+  auto payload = record.sliced(1);
+  switch (type) {
+    case TypedValue::Utf8:
+      return Utf8String(payload.data(), payload.size());
+    case TypedValue::Entity8:
+    case TypedValue::Entity8Vector: {
+      std::vector<Entity> entities;
+      entities.reserve(payload.size()/8);
+      for (qsizetype i = 0; i+8 <= payload.size(); i += 8)
+        entities.push_back(qFromLittleEndian<quint64>(payload.data()+i));
+      if (type == TypedValue::Entity8)
+        return entities.empty() ? TypedValue{} : TypedValue{entities[0]};
+      return entities;
+    }
+    default:
+      return TypedValue::from_etv(Utf8String(payload.data(), payload.size()));
+  }
+}
+
+const char Magic[8] = { 'P', '6', 'W', 'O', 'R', 'L', 'D', '1' };
+const quint64 ByteOrderMark = 0x0102'0304'0506'0708ULL;
+
+struct WorldFileHeader {
+  char _magic[8];
+  quint64 _byte_order, _triplets_count, _values_count, _next_entity;
+  // offsets in file
+  quint64 _spo, _pos, _osp, _value_offsets, _value_sorted, _heap, _heap_size;
+};
+
+} // unnamed namespace
+
+struct WorldMapping {
+  QFile _file;
+  const uchar *_data = nullptr;
+};
+
+/** Append-only values heap, shared by the world and its snapshots, each
+ *  snapshot only seeing the values that existed when it was committed.
+ *  First values can be records in a mapped file, decoded on demand. */
+struct WorldValues {
+  QReadWriteLock _lock; // only the world writes, with _lock locked for write
+  std::shared_ptr<const WorldMapping> _mapping;
+  const quint64 *_mapped_offsets = nullptr; // _mapped_count+1 offsets in heap
+  const quint64 *_mapped_sorted = nullptr; // indexes sorted by record
+  const char *_mapped_heap = nullptr;
+  quint64 _mapped_count = 0;
+  std::deque<TypedValue> _values; // values after mapped ones
+  QHash<Utf8String,quint64> _indexes; // record -> index, but mapped ones
+  inline quint64 count() const { return _mapped_count+_values.size(); }
+  inline QByteArrayView mapped_record(quint64 index) const {
+    return { _mapped_heap+_mapped_offsets[index],
+          static_cast<qsizetype>(_mapped_offsets[index+1]
+                                 -_mapped_offsets[index]) };
+  }
+  /** index of a record, or Max, caller must hold _lock or be the writer */
+  quint64 index(QByteArrayView record) const {
+    auto it = _indexes.constFind(Utf8String(record.data(), record.size()));
+    if (it != _indexes.cend())
+      return it.value();
+    auto end = _mapped_sorted+_mapped_count;
+    auto mapped = std::lower_bound(
+          _mapped_sorted, end, record,
+          [this](quint64 i, QByteArrayView r) {
+      return compare(mapped_record(i), r) < 0; });
+    return mapped != end && compare(mapped_record(*mapped), record) == 0
+        ? *mapped : Max;
+  }
+  /** caller must hold _lock or be the writer, unless index is mapped */
+  inline TypedValue value(quint64 index) const {
+    return index < _mapped_count ? decode(mapped_record(index))
+                                 : _values[index-_mapped_count];
+  }
+  inline QByteArray record(quint64 index) const {
+    return index < _mapped_count ? mapped_record(index).toByteArray()
+                                 : p6::record(_values[index-_mapped_count]);
+  }
+};
+
+/** Transitive $kind_of closures cache, shared by every snapshot as long as
+ *  $kind_of triplets do not change. */
+struct WorldKinds {
+  QMutex _mutex;
+  QHash<quint64,EntityList> _closures;
+};
+
+struct WorldSnapshot {
+  // same triplets, three orders, either owned or mapped
+  std::span<const Triplet> _spo, _pos, _osp;
+  std::vector<Triplet> _owned_spo, _owned_pos, _owned_osp;
+  std::shared_ptr<const WorldMapping> _mapping;
+  std::shared_ptr<WorldValues> _values;
+  quint64 _values_count = 0;
+  std::shared_ptr<WorldKinds> _kinds = std::make_shared<WorldKinds>();
+  quint64 _generation = 0;
+  void own(std::vector<Triplet> &&spo, std::vector<Triplet> &&pos,
+           std::vector<Triplet> &&osp) {
+    _owned_spo = std::move(spo);
+    _owned_pos = std::move(pos);
+    _owned_osp = std::move(osp);
+    _spo = _owned_spo;
+    _pos = _owned_pos;
+    _osp = _owned_osp;
+  }
+};
+
+namespace {
+
+const auto spo_less = [](const Triplet &a, const Triplet &b) STATIC_LAMBDA {
+  return std::tie(a.s, a.p, a.o) < std::tie(b.s, b.p, b.o);
+};
+const auto pos_less = [](const Triplet &a, const Triplet &b) STATIC_LAMBDA {
+  return std::tie(a.p, a.o, a.s) < std::tie(b.p, b.o, b.s);
+};
+const auto osp_less = [](const Triplet &a, const Triplet &b) STATIC_LAMBDA {
+  return std::tie(a.o, a.s, a.p) < std::tie(b.o, b.s, b.p);
+};
+
+/** triplets between lo and hi (included), in less order */
+template <typename Less>
+inline std::span<const Triplet> range(
+    std::span<const Triplet> triplets, Less less, const Triplet &lo,
+    const Triplet &hi) {
+  auto begin = std::lower_bound(triplets.begin(), triplets.end(), lo, less);
+  auto end = std::upper_bound(begin, triplets.end(), hi, less);
+  return { begin, end };
+}
+
+/** (base - removed) + added, in one linear pass once changes are sorted */
+template <typename Less>
+std::vector<Triplet> merged(
+    std::span<const Triplet> base, std::vector<Triplet> added,
+    std::vector<Triplet> removed, Less less) {
+  std::sort(added.begin(), added.end(), less);
+  std::sort(removed.begin(), removed.end(), less);
+  std::vector<Triplet> result;
+  result.reserve(base.size()+added.size());
+  auto a = added.cbegin(), r = removed.cbegin();
+  for (const auto &t: base) {
+    while (a != added.cend() && less(*a, t))
+      result.push_back(*a++);
+    bool readded = a != added.cend() && *a == t;
+    if (readded)
+      ++a;
+    while (r != removed.cend() && less(*r, t))
+      ++r;
+    if (readded || r == removed.cend() || *r != t)
+      result.push_back(t);
+  }
+  result.insert(result.end(), a, added.cend());
+  return result;
+}
+
+} // unnamed namespace
+
+std::span<const Triplet> WorldView::match(
+    quint64 s, quint64 p, quint64 o) const {
+  if (!_snapshot)
+    return {};
+  const auto &x = *_snapshot;
+  if (s && p && o)
+    return range(x._spo, spo_less, { s, p, o }, { s, p, o });
+  if (s && p)
+    return range(x._spo, spo_less, { s, p, 0 }, { s, p, Max });
+  if (s && o)
+    return range(x._osp, osp_less, { s, 0, o }, { s, Max, o });
+  if (s)
+    return range(x._spo, spo_less, { s, 0, 0 }, { s, Max, Max });
+  if (p && o)
+    return range(x._pos, pos_less, { 0, p, o }, { Max, p, o });
+  if (p)
+    return range(x._pos, pos_less, { 0, p, 0 }, { Max, p, Max });
+  if (o)
+    return range(x._osp, osp_less, { 0, 0, o }, { Max, Max, o });
+  return x._spo;
+}
+
+bool WorldView::contains(Entity s, Entity p, const TypedValue &o) const {
+  auto t = term(o);
+  return s && p && t && !match(s, p, t).empty();
+}
+
+EntityList WorldView::objects(Entity s, Entity p) const {
+  EntityList objects;
+  if (!s || !p)
+    return objects;
+  for (const auto &t: match(s, p))
+    if (!t.has_value())
+      objects.append(t.o);
+  return objects;
+}
+
+TypedValueList WorldView::values(Entity s, Entity p) const {
+  TypedValueList values;
+  if (!s || !p)
+    return values;
+  for (const auto &t: match(s, p))
+    values.push_back(value(t.o));
+  return values;
+}
+
+TypedValue WorldView::attribute(Entity s, Entity p) const {
+  if (!s || !p)
+    return {};
+  auto triplets = match(s, p);
+  return triplets.empty() ? TypedValue{} : value(triplets.front().o);
+}
+
+EntityList WorldView::subjects(Entity p, const TypedValue &o) const {
+  EntityList subjects;
+  auto t = term(o);
+  if (!p || !t)
+    return subjects;
+  for (const auto &triplet: match(0, p, t))
+    subjects.append(triplet.s);
+  return subjects;
+}
+
+Entity WorldView::by_name(const Utf8String &name) const {
+  auto t = term(name);
+  if (!t)
+    return {};
+  auto triplets = match(0, Entity::NAME, t);
+  return triplets.empty() ? Entity{} : Entity{triplets.front().s};
+}
+
+EntityList WorldView::kinds(Entity e) const {
+  if (!_snapshot || !e)
+    return {};
+  auto cache = _snapshot->_kinds.get();
+  {
+    QMutexLocker locker(&cache->_mutex);
+    auto it = cache->_closures.constFind(e);
+    if (it != cache->_closures.cend())
+      return it.value();
+  }
+  // breadth first, closure being its own queue, cycles are ignored
+  EntityList closure;
+  QSet<quint64> seen { e };
+  for (qsizetype i = -1; i < closure.size(); ++i) {
+    Entity kind = i < 0 ? e : closure[i];
+    for (const auto &t: match(kind, Entity::KIND_OF)) {
+      if (t.has_value() || seen.contains(t.o))
+        continue;
+      seen.insert(t.o);
+      closure.append(t.o);
+    }
+  }
+  QMutexLocker locker(&cache->_mutex);
+  cache->_closures.insert(e, closure);
+  return closure;
+}
+
+TypedValue WorldView::find_first_attribute(
+    Entity e, Entity p, Entity inheritance) const {
+  if (auto v = attribute(e, p); v.type() != TypedValue::Null)
+    return v;
+  EntityList ancestors;
+  if (inheritance == Entity::KIND_OF) {
+    ancestors = kinds(e);
+  } else if (inheritance == Entity::INSTANCE_THEN_KIND_OF) {
+    for (auto instance_of: objects(e, Entity::INSTANCE_OF)) {
+      ancestors *= instance_of;
+      for (auto kind: kinds(instance_of))
+        ancestors *= kind;
+    }
+  } else {
+    ancestors = objects(e, inheritance);
+  }
+  for (auto ancestor: ancestors)
+    if (auto v = attribute(ancestor, p); v.type() != TypedValue::Null)
+      return v;
+  return {};
+}
+
+TypedValue WorldView::value(quint64 term) const {
+  if (!(term & Triplet::ValueFlag))
+    return term ? TypedValue{Entity{term}} : TypedValue{};
+  auto index = term & ~Triplet::ValueFlag;
+  if (!_snapshot || index >= _snapshot->_values_count)
+    return {};
+  const auto &values = *_snapshot->_values;
+  if (index < values._mapped_count) // mapped records are immutable
+    return values.value(index);
+  QReadLocker locker(&_snapshot->_values->_lock);
+  return values.value(index);
+}
+
+quint64 WorldView::term(const TypedValue &value) const {
+  switch (value.type()) {
+    case TypedValue::Null:
+      return 0;
+    case TypedValue::Entity8:
+      return value.entity8().id();
+    default:
+      ;
+  }
+  if (!_snapshot)
+    return 0;
+  auto r = record(value);
+  QReadLocker locker(&_snapshot->_values->_lock);
+  auto index = _snapshot->_values->index(r);
+  return index < _snapshot->_values_count ? index | Triplet::ValueFlag : 0;
+}
+
+size_t WorldView::size() const {
+  return _snapshot ? _snapshot->_spo.size() : 0;
+}
+
+quint64 WorldView::generation() const {
+  return _snapshot ? _snapshot->_generation : 0;
+}
+
+World::World() : _values(std::make_shared<WorldValues>()) {
+  auto snapshot = std::make_shared<WorldSnapshot>();
+  snapshot->_values = _values;
+  _snapshot = snapshot;
+  static const std::pair<quint64,const char *> predicates[] = {
+    { Entity::NAME, "$name" }, { Entity::KIND_OF, "$kind_of" },
+    { Entity::ATTRIBUTE, "$attribute" }, { Entity::RELATION, "$relation" },
+    { Entity::TAG, "$tag" }, { Entity::OWNS, "$owns" },
+    { Entity::INSTANCE_OF, "$instance_of" },
+    { Entity::GRANTS_KIND, "$grants_kind" },
+  };
+  for (auto [e, name]: predicates) {
+    set_name(e, Utf8String(name));
+    if (e != Entity::ATTRIBUTE && e != Entity::RELATION)
+      add(e, Entity::KIND_OF, Entity(e == Entity::NAME || e == Entity::TAG
+                                     ? Entity::ATTRIBUTE : Entity::RELATION));
+  }
+  commit();
+}
+
+World::~World() {
+}
+
+quint64 World::term(QByteArrayView record, bool create) {
+  if (record.isEmpty())
+    return 0;
+  if (record[0] == static_cast<char>(TypedValue::Entity8))
+    return record.size() == 9 ? qFromLittleEndian<quint64>(record.data()+1)
+                              : 0;
+  // only this thread modifies values, hence no need to lock for reading
+  auto index = _values->index(record);
+  if (index != Max)
+    return index | Triplet::ValueFlag;
+  if (!create)
+    return 0;
+  auto value = decode(record);
+  QWriteLocker locker(&_values->_lock);
+  index = _values->count();
+  _values->_values.push_back(value);
+  _values->_indexes.insert(Utf8String(record.data(), record.size()), index);
+  return index | Triplet::ValueFlag;
+}
+
+void World::do_add(quint64 s, quint64 p, quint64 t) {
+  Triplet triplet { s, p, t };
+  _removed.remove(triplet);
+  _added.insert(triplet);
+}
+
+void World::do_remove(quint64 s, quint64 p, quint64 t) {
+  Triplet triplet { s, p, t };
+  _added.remove(triplet);
+  _removed.insert(triplet);
+  auto it = _set_attributes.find({ s, p });
+  if (it != _set_attributes.end() && it.value() == t)
+    _set_attributes.erase(it);
+}
+
+void World::do_set_attribute(quint64 s, quint64 p, quint64 t) {
+  _set_attributes.insert({ s, p }, t);
+  if (t)
+    _removed.remove({ s, p, t });
+}
+
+void World::log(char op, quint64 s, quint64 p, QByteArrayView record) {
+  if (!_log)
+    return;
+  char header[21];
+  header[0] = op;
+  qToLittleEndian(s, header+1);
+  qToLittleEndian(p, header+9);
+  qToLittleEndian<quint32>(record.size(), header+17);
+  _log_buffer.append(header, sizeof header).append(record);
+}
+
+void World::add(Entity s, Entity p, const TypedValue &o) {
+  if (!s || !p || (s & Triplet::ValueFlag) || (p & Triplet::ValueFlag))
+    return;
+  auto r = record(o);
+  QMutexLocker locker(&_mutex);
+  auto t = term(r, true);
+  if (!t)
+    return;
+  do_add(s, p, t);
+  log('a', s, p, r);
+}
+
+void World::remove(Entity s, Entity p, const TypedValue &o) {
+  auto r = record(o);
+  QMutexLocker locker(&_mutex);
+  auto t = term(r, false);
+  if (!s || !p || !t)
+    return;
+  do_remove(s, p, t);
+  log('r', s, p, r);
+}
+
+void World::set_attribute(Entity s, Entity p, const TypedValue &value) {
+  if (!s || !p || (s & Triplet::ValueFlag) || (p & Triplet::ValueFlag))
+    return;
+  auto r = record(value);
+  QMutexLocker locker(&_mutex);
+  do_set_attribute(s, p, term(r, true));
+  log('s', s, p, r);
+}
+
+void World::declare_kind_of(Entity e, Entity kind) {
+  auto grants = view().objects(kind, Entity::GRANTS_KIND);
+  add(e, Entity::KIND_OF, kind);
+  for (auto granted: grants)
+    add(e, Entity::KIND_OF, granted);
+}
+
+WorldView World::commit() {
+  QMutexLocker locker(&_mutex);
+  auto view = do_commit();
+  if (!_log || _log_buffer.isEmpty())
+    return view;
+  log('c', 0, 0, {});
+  if (_log->write(_log_buffer) != _log_buffer.size() || !_log->flush())
+    Log::warning() << "cannot write world log " << _log->fileName() << " : "
+                   << _log->errorString();
+  _log_buffer.clear();
+  if (_log->size() > _compaction_threshold && do_compact())
+    return WorldView(_snapshot);
+  return view;
+}
+
+WorldView World::do_commit() {
+  if (_added.isEmpty() && _removed.isEmpty() && _set_attributes.isEmpty())
+    return WorldView(_snapshot);
+  const auto &old = *_snapshot;
+  std::vector<Triplet> added(_added.cbegin(), _added.cend()),
+      removed(_removed.cbegin(), _removed.cend());
+  if (!_set_attributes.isEmpty()) {
+    WorldView view(_snapshot);
+    for (auto [sp, t]: _set_attributes.asKeyValueRange()) {
+      for (const auto &triplet: view.match(sp.first, sp.second))
+        if (triplet.o != t)
+          removed.push_back(triplet);
+      if (t)
+        added.push_back({ sp.first, sp.second, t });
+    }
+    // set_attribute() wins over add() of other values in the same batch
+    std::erase_if(added, [this](const Triplet &triplet) {
+      auto it = _set_attributes.constFind({ triplet.s, triplet.p });
+      return it != _set_attributes.cend() && it.value() != triplet.o;
+    });
+  }
+  _added.clear();
+  _removed.clear();
+  _set_attributes.clear();
+  auto is_kind_of = [](const Triplet &t) STATIC_LAMBDA {
+    return t.p == Entity::KIND_OF; };
+  bool kinds_changed = std::any_of(added.cbegin(), added.cend(), is_kind_of)
+      || std::any_of(removed.cbegin(), removed.cend(), is_kind_of);
+  auto snapshot = std::make_shared<WorldSnapshot>();
+  auto spo = merged(old._spo, added, removed, spo_less);
+  auto pos = merged(old._pos, added, removed, pos_less);
+  snapshot->own(std::move(spo), std::move(pos),
+                merged(old._osp, std::move(added), std::move(removed),
+                       osp_less));
+  snapshot->_values = _values;
+  snapshot->_values_count = _values->count();
+  if (!kinds_changed)
+    snapshot->_kinds = old._kinds;
+  snapshot->_generation = old._generation+1;
+  _snapshot = snapshot;
+  return WorldView(_snapshot);
+}
+
+WorldView World::view() const {
+  QMutexLocker locker(&_mutex);
+  return WorldView(_snapshot);
+}
+
+bool World::open(const QString &path) {
+  QMutexLocker locker(&_mutex);
+  _added.clear();
+  _removed.clear();
+  _set_attributes.clear();
+  _log_buffer.clear();
+  _log.reset();
+  _path = path;
+  if (!QFile::exists(path)) {
+    QFile::remove(path+".log"); // a log without its file is meaningless
+    if (!write_file())
+      return false;
+  }
+  if (!map_file() || !replay_log())
+    return false;
+  _log = std::make_unique<QFile>(path+".log");
+  if (!_log->open(QIODevice::WriteOnly|QIODevice::Append)) {
+    Log::warning() << "cannot open world log " << _log->fileName() << " : "
+                   << _log->errorString();
+    _log.reset();
+    return false;
+  }
+  return true;
+}
+
+bool World::compact() {
+  QMutexLocker locker(&_mutex);
+  return do_compact();
+}
+
+bool World::do_compact() {
+  if (!_log)
+    return false;
+  if (!write_file() || !map_file())
+    return false;
+  // replaying the log again on the new file would be harmless, since every
+  // change is idempotent, therefore a crash before truncation is not an issue
+  if (!_log->resize(0)) {
+    Log::warning() << "cannot truncate world log " << _log->fileName()
+                   << " : " << _log->errorString();
+    return false;
+  }
+  return true;
+}
+
+bool World::write_file() {
+  static_assert(sizeof(Triplet) == 24 && sizeof(WorldFileHeader) == 96);
+  const auto &x = *_snapshot;
+  const auto &values = *_values;
+  // every value, including those only used by pending changes, so that their
+  // terms are still valid once the file is mapped
+  quint64 count = values.count();
+  std::vector<quint64> offsets, sorted(count);
+  offsets.reserve(count+1);
+  QByteArray heap;
+  for (quint64 i = 0; i < count; ++i) {
+    offsets.push_back(heap.size());
+    heap.append(values.record(i));
+  }
+  offsets.push_back(heap.size());
+  auto record_of = [&](quint64 i) {
+    return QByteArrayView(heap.constData()+offsets[i],
+                          static_cast<qsizetype>(offsets[i+1]-offsets[i]));
+  };
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::sort(sorted.begin(), sorted.end(), [&](quint64 a, quint64 b) {
+    return compare(record_of(a), record_of(b)) < 0; });
+  WorldFileHeader header;
+  ::memcpy(header._magic, Magic, sizeof Magic);
+  header._byte_order = ByteOrderMark;
+  header._triplets_count = x._spo.size();
+  header._values_count = count;
+  header._next_entity = _next_entity;
+  quint64 triplets_size = x._spo.size()*sizeof(Triplet);
+  header._spo = sizeof header;
+  header._pos = header._spo+triplets_size;
+  header._osp = header._pos+triplets_size;
+  header._value_offsets = header._osp+triplets_size;
+  header._value_sorted = header._value_offsets+(count+1)*sizeof(quint64);
+  header._heap = header._value_sorted+count*sizeof(quint64);
+  header._heap_size = heap.size();
+  QSaveFile file(_path);
+  auto write = [&file](const void *data, qint64 size) {
+    return file.write(static_cast<const char *>(data), size) == size;
+  };
+  if (!file.open(QIODevice::WriteOnly)
+      || !write(&header, sizeof header)
+      || !write(x._spo.data(), triplets_size)
+      || !write(x._pos.data(), triplets_size)
+      || !write(x._osp.data(), triplets_size)
+      || !write(offsets.data(), (count+1)*sizeof(quint64))
+      || !write(sorted.data(), count*sizeof(quint64))
+      || !write(heap.constData(), heap.size())
+      || !file.commit()) {
+    Log::warning() << "cannot write world file " << _path << " : "
+                   << file.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool World::map_file() {
+  auto mapping = std::make_shared<WorldMapping>();
+  mapping->_file.setFileName(_path);
+  if (!mapping->_file.open(QIODevice::ReadOnly)) {
+    Log::warning() << "cannot open world file " << _path << " : "
+                   << mapping->_file.errorString();
+    return false;
+  }
+  quint64 size = mapping->_file.size();
+  WorldFileHeader header;
+  if (size < sizeof header
+      || !(mapping->_data = mapping->_file.map(0, size))) {
+    Log::warning() << "cannot map world file " << _path << " : "
+                   << mapping->_file.errorString();
+    return false;
+  }
+  auto data = mapping->_data;
+  ::memcpy(&header, data, sizeof header);
+  quint64 triplets_size = header._triplets_count*sizeof(Triplet);
+  auto fits = [size](quint64 offset, quint64 length) {
+    return offset <= size && length <= size-offset && !(offset % 8);
+  };
+  auto offsets = reinterpret_cast<const quint64 *>(
+        data+header._value_offsets);
+  auto sorted = reinterpret_cast<const quint64 *>(data+header._value_sorted);
+  // records are then read without bounds checking, hence every offset must
+  // stay within the heap and every sorted index within values
+  auto valid_values = [&]() {
+    for (quint64 i = 0; i < header._values_count; ++i)
+      if (offsets[i] > offsets[i+1] || sorted[i] >= header._values_count)
+        return false;
+    return true;
+  };
+  if (::memcmp(header._magic, Magic, sizeof Magic)
+      || header._byte_order != ByteOrderMark
+      || header._triplets_count > size || header._values_count > size
+      || !fits(header._spo, triplets_size)
+      || !fits(header._pos, triplets_size)
+      || !fits(header._osp, triplets_size)
+      || !fits(header._value_offsets,
+               (header._values_count+1)*sizeof(quint64))
+      || !fits(header._value_sorted, header._values_count*sizeof(quint64))
+      || header._heap > size || header._heap_size > size-header._heap
+      || offsets[header._values_count] != header._heap_size
+      || !valid_values()) {
+    Log::warning() << "invalid world file " << _path;
+    return false;
+  }
+  auto values = std::make_shared<WorldValues>();
+  values->_mapping = mapping;
+  values->_mapped_offsets = offsets;
+  values->_mapped_sorted = sorted;
+  values->_mapped_heap = reinterpret_cast<const char *>(data+header._heap);
+  values->_mapped_count = header._values_count;
+  auto triplets = [&](quint64 offset) {
+    return std::span<const Triplet>(
+          reinterpret_cast<const Triplet *>(data+offset),
+          header._triplets_count);
+  };
+  auto snapshot = std::make_shared<WorldSnapshot>();
+  snapshot->_spo = triplets(header._spo);
+  snapshot->_pos = triplets(header._pos);
+  snapshot->_osp = triplets(header._osp);
+  snapshot->_mapping = mapping;
+  snapshot->_values = values;
+  snapshot->_values_count = header._values_count;
+  snapshot->_generation = _snapshot->_generation+1;
+  _snapshot = snapshot;
+  _values = values;
+  if (header._next_entity > _next_entity)
+    _next_entity = header._next_entity;
+  return true;
+}
+
+bool World::replay_log() {
+  QFile file(_path+".log");
+  if (!file.exists())
+    return true;
+  if (!file.open(QIODevice::ReadWrite)) {
+    Log::warning() << "cannot open world log " << file.fileName() << " : "
+                   << file.errorString();
+    return false;
+  }
+  auto data = file.readAll();
+  struct Change { char op; quint64 s, p, t; };
+  std::vector<Change> changes; // of current commit, applied when complete
+  qsizetype pos = 0, end = 0; // end of last complete commit
+  quint64 max_entity = 0;
+  while (pos+21 <= data.size()) {
+    char op = data[pos];
+    auto s = qFromLittleEndian<quint64>(data.constData()+pos+1);
+    auto p = qFromLittleEndian<quint64>(data.constData()+pos+9);
+    auto length = qFromLittleEndian<quint32>(data.constData()+pos+17);
+    if (qsizetype(length) > data.size()-pos-21)
+      break;
+    QByteArrayView record(data.constData()+pos+21, length);
+    pos += 21+length;
+    if (op == 'c') {
+      // a set_attribute() followed by add() or remove() on the same
+      // attribute in later commits must not be merged in the same batch
+      for (const auto &c: changes) {
+        if (c.op != 's' && _set_attributes.contains({ c.s, c.p })) {
+          do_commit();
+          break;
+        }
+      }
+      for (const auto &c: changes) {
+        switch (c.op) {
+          case 'a':
+            do_add(c.s, c.p, c.t);
+            break;
+          case 'r':
+            do_remove(c.s, c.p, c.t);
+            break;
+          case 's':
+            do_set_attribute(c.s, c.p, c.t);
+            break;
+        }
+        max_entity = std::max({ max_entity, c.s, c.p,
+                                c.t & Triplet::ValueFlag ? 0 : c.t });
+      }
+      changes.clear();
+      end = pos;
+      continue;
+    }
+    if ((op != 'a' && op != 'r' && op != 's') || !s || !p
+        || (s & Triplet::ValueFlag) || (p & Triplet::ValueFlag))
+      break;
+    auto t = term(record, op != 'r');
+    if (op == 's' || t)
+      changes.push_back({ op, s, p, t });
+  }
+  if (end < data.size()) { // interrupted write or garbage
+    Log::warning() << "ignoring " << data.size()-end
+                   << " bytes of uncommitted changes at the end of world log "
+                   << file.fileName();
+    if (!file.resize(end))
+      Log::warning() << "cannot truncate world log " << file.fileName()
+                     << " : " << file.errorString();
+  }
+  if (max_entity >= _next_entity)
+    _next_entity = max_entity+1;
+  do_commit();
+  return true;
+}
+
+Utf8String Entity::n3(const WorldView *wv) const {
+  if (wv)
+    if (auto name = wv->name(*this); !name.isEmpty())
+      return name;
+  return n3();
+}
+
+} // p6 ns
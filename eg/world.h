@@ -0,0 +1,197 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "eg/entity.h"
+#include "util/typedvaluelist.h"
+#include <QMutex>
+#include <QSet>
+#include <atomic>
+#include <memory>
+#include <span>
+#include <vector>
+
+class QFile;
+
+namespace p6 {
+
+struct WorldSnapshot;
+struct WorldValues;
+
+/** Subject-predicate-object triplet.
+ *  Every part is a 64 bits term: an entity id or, when ValueFlag is set, the
+ *  index of a value in the world values heap.
+ *  @see World */
+struct LIBP6CORESHARED_EXPORT Triplet {
+  static constexpr quint64 ValueFlag = 1ULL << 63;
+  quint64 s, p, o;
+  [[nodiscard]] inline bool has_value() const { return o & ValueFlag; }
+  friend inline auto operator<=>(const Triplet &, const Triplet &) = default;
+};
+
+inline size_t qHash(const Triplet &t, size_t seed = 0) {
+  return qHashMulti(seed, t.s, t.p, t.o);
+}
+
+/** Consistent read-only view of the world, as it was when the view was taken.
+ *  Views are cheap to copy and are not affected by later World::commit(), so
+ *  every reader thread can hold its own without any lock but for values heap
+ *  accesses.
+ *  Returned spans are valid as long as the view (or one of its copies)
+ *  lives. */
+class LIBP6CORESHARED_EXPORT WorldView {
+  friend class World;
+  std::shared_ptr<const WorldSnapshot> _snapshot;
+
+  WorldView(std::shared_ptr<const WorldSnapshot> snapshot)
+    : _snapshot(snapshot) { }
+
+public:
+  WorldView() { }
+  /** Triplets matching a pattern, 0 being a wildcard, using the index fitting
+   *  the pattern, hence in s,p,o or p,o,s or o,s,p order. */
+  [[nodiscard]] std::span<const Triplet> match(
+      quint64 s = 0, quint64 p = 0, quint64 o = 0) const;
+  [[nodiscard]] bool contains(Entity s, Entity p, const TypedValue &o) const;
+  /** Entities related to s through p (value objects are ignored). */
+  [[nodiscard]] EntityList objects(Entity s, Entity p) const;
+  /** Values and entities (as Entity8 values) related to s through p. */
+  [[nodiscard]] TypedValueList values(Entity s, Entity p) const;
+  /** First value related to s through p, or null. */
+  [[nodiscard]] TypedValue attribute(Entity s, Entity p) const;
+  [[nodiscard]] EntityList subjects(Entity p, const TypedValue &o) const;
+  [[nodiscard]] Utf8String name(Entity e) const {
+    return attribute(e, Entity::NAME).as_utf8(); }
+  /** First entity named so, or null. */
+  [[nodiscard]] Entity by_name(const Utf8String &name) const;
+  /** Transitive $kind_of closure of e, breadth first, e excluded.
+   *  Cached and shared by every view until $kind_of graph changes. */
+  [[nodiscard]] EntityList kinds(Entity e) const;
+  [[nodiscard]] bool is_kind_of(Entity e, Entity kind) const {
+    return kinds(e).contains(kind); }
+  /** Attribute of e or, if none, of the first of its ancestors having it.
+   *  @param inheritance KIND_OF (default), INSTANCE_OF or
+   *  INSTANCE_THEN_KIND_OF (instance_of objects then their kinds) */
+  [[nodiscard]] TypedValue find_first_attribute(
+      Entity e, Entity p, Entity inheritance = Entity::KIND_OF) const;
+  /** Value or entity (as Entity8 value) for a term. */
+  [[nodiscard]] TypedValue value(quint64 term) const;
+  /** Term for a value or 0 if the value did not exist in this view. */
+  [[nodiscard]] quint64 term(const TypedValue &value) const;
+  [[nodiscard]] size_t size() const;
+  [[nodiscard]] quint64 generation() const;
+  [[nodiscard]] bool operator!() const { return !_snapshot; }
+};
+
+/** Entity seen through a world view, for convenience. */
+struct LIBP6CORESHARED_EXPORT EntityRef {
+  Entity _entity;
+  const WorldView *_wv;
+  EntityRef(Entity entity, const WorldView *wv) : _entity(entity), _wv(wv) { }
+  operator Entity() const { return _entity; }
+  [[nodiscard]] Utf8String n3() const { return _entity.n3(_wv); }
+  [[nodiscard]] TypedValue attribute(Entity p) const {
+    return _wv->find_first_attribute(_entity, p); }
+  [[nodiscard]] EntityList objects(Entity p) const {
+    return _wv->objects(_entity, p); }
+};
+
+/** In-memory triplet store.
+ *
+ *  Triplets are kept in three sorted arrays (s,p,o, p,o,s and o,s,p orders)
+ *  so that any pattern is answered by a binary search and a contiguous range.
+ *  Values (anything but entities) are interned once in a values heap and
+ *  referenced by their term.
+ *
+ *  Changes (add(), remove(), set_attribute()...) are buffered until commit(),
+ *  which merges them into new arrays and publishes them as a new snapshot.
+ *  Readers use WorldViews on snapshots and are never blocked by writers, nor
+ *  see uncommitted or partly committed changes. Committing costs a linear
+ *  merge, therefore changes should be batched.
+ *
+ *  Values heap is append-only: values no longer referenced are not reclaimed.
+ *  Entities ids must not have ValueFlag bit set.
+ *
+ *  Optional persistence (open()) uses a file holding the three triplets
+ *  arrays as is, plus the values heap as records (type byte and utf8, raw
+ *  entity ids or etv payload) with an offsets array and an index of records
+ *  sorted by content. The file is mapped read-only and used in place, which
+ *  makes loading O(1): pages are read by the system when lookups need them.
+ *  Committed changes are appended to a log (path+".log") which is replayed
+ *  on open() and folded into a new file by compact(), automatically when it
+ *  grows beyond compaction_threshold().
+ *  The file is in native byte order and, on Windows, cannot be compacted
+ *  while older views still map it.
+ */
+class LIBP6CORESHARED_EXPORT World {
+  Q_DISABLE_COPY(World)
+  mutable QMutex _mutex;
+  std::shared_ptr<const WorldSnapshot> _snapshot;
+  std::shared_ptr<WorldValues> _values;
+  QSet<Triplet> _added, _removed; // pending changes
+  QHash<QPair<quint64,quint64>,quint64> _set_attributes; // s,p -> term
+  std::atomic<quint64> _next_entity = Entity::LAST_RESERVED+1;
+  QString _path;
+  std::unique_ptr<QFile> _log;
+  QByteArray _log_buffer; // changes not yet committed
+  qint64 _compaction_threshold = 64*1024*1024;
+
+public:
+  /** Create a world in which reserved predicates are named. */
+  World();
+  ~World();
+  [[nodiscard]] Entity create_entity() { return _next_entity++; }
+  void add(Entity s, Entity p, const TypedValue &o);
+  void remove(Entity s, Entity p, const TypedValue &o);
+  /** Replace any value s may have through p. */
+  void set_attribute(Entity s, Entity p, const TypedValue &value);
+  void set_name(Entity e, const Utf8String &name) {
+    set_attribute(e, Entity::NAME, name); }
+  /** Add e,$kind_of,kind and e,$kind_of,x for every kind,$grants_kind,x */
+  void declare_kind_of(Entity e, Entity kind);
+  /** Publish pending changes as a new snapshot. */
+  WorldView commit();
+  /** View on last committed snapshot. */
+  [[nodiscard]] WorldView view() const;
+  /** Persist the world in path: if the file exists, replace current state
+   *  with its content and the one of its log, otherwise write current state
+   *  to it. Uncommitted changes are discarded. */
+  bool open(const QString &path);
+  /** Write last committed snapshot to a new world file, map it and truncate
+   *  the log. */
+  bool compact();
+  /** Log size triggering compaction on commit. Default: 64 MB. */
+  [[nodiscard]] qint64 compaction_threshold() const {
+    return _compaction_threshold; }
+  void set_compaction_threshold(qint64 bytes) { _compaction_threshold = bytes; }
+
+private:
+  /** Term for a value record, interning it in values heap if needed and
+   *  create. */
+  quint64 term(QByteArrayView record, bool create);
+  void do_add(quint64 s, quint64 p, quint64 t);
+  void do_remove(quint64 s, quint64 p, quint64 t);
+  void do_set_attribute(quint64 s, quint64 p, quint64 t);
+  inline void log(char op, quint64 s, quint64 p, QByteArrayView record);
+  WorldView do_commit();
+  bool do_compact();
+  bool write_file();
+  bool map_file();
+  bool replay_log();
+};
+
+} // p6 ns
+
+#endif // WORLD_H
@@ -13,6 +13,48 @@
  */
 #include "abstracttextformatter.h"
 
+namespace {
+
+/** Buffers output to write it by large blocks, and throttles the caller
+ * when output device does not keep up. */
+class ThrottledWriter {
+  static const qsizetype BlockSize = 65536;
+  static const qint64 MaxPendingBytes = 1 << 20;
+  static const int WriteTimeoutMs = 30'000;
+  QIODevice *_output;
+  QByteArray _buffer;
+  bool _error;
+
+public:
+  explicit ThrottledWriter(QIODevice *output)
+    : _output(output), _error(!output) {
+    _buffer.reserve(BlockSize+BlockSize/4);
+  }
+  bool write(const QByteArray &data) {
+    _buffer.append(data);
+    if (_buffer.size() >= BlockSize)
+      flush();
+    return !_error;
+  }
+  bool flush() {
+    if (_error || _buffer.isEmpty())
+      return !_error;
+    if (_output->write(_buffer) != _buffer.size()) {
+      _error = true;
+      return false;
+    }
+    _buffer.resize(0); // rather than clear(), to keep capacity
+    while (_output->bytesToWrite() > MaxPendingBytes)
+      if (!_output->waitForBytesWritten(WriteTimeoutMs)) {
+        _error = true;
+        return false;
+      }
+    return true;
+  }
+};
+
+} // unnamed namespace
+
 int AbstractTextFormatter::_defaultMaxCellContentLength = 200;
 
 AbstractTextFormatter::~AbstractTextFormatter() {
@@ -65,6 +107,47 @@ QString AbstractTextFormatter::formatTable(
   return s;
 }
 
+bool AbstractTextFormatter::writeTable(
+    QIODevice *output, const SharedUiItemList &list, int role) const {
+  ThrottledWriter writer(output);
+  const SharedUiItem first = list.isEmpty() ? SharedUiItem() : list.first();
+  QStringList headers;
+  if (_columnHeadersEnabled)
+    fetchHeaderList(&headers, first);
+  writer.write(formatTableHeader(headers).toUtf8());
+  int row = 0;
+  for (const SharedUiItem &item : list) {
+    ++row;
+    if (!writer.write(formatUtf8RowInternal(
+                        item, role, _rowHeadersEnabled
+                        ? Utf8String::number(row) : Utf8String{})))
+      return false;
+  }
+  writer.write(formatTableFooter(headers).toUtf8());
+  return writer.flush();
+}
+
+bool AbstractTextFormatter::writeTable(
+    QIODevice *output, const QAbstractItemModel *model, int firstRow,
+    int lastRow, const QModelIndex &parent, int role) const {
+  ThrottledWriter writer(output);
+  QStringList headers;
+  if (_columnHeadersEnabled)
+    fetchHeaderList(&headers, model, parent, role);
+  writer.write(formatTableHeader(headers).toUtf8());
+  if (model) {
+    if (firstRow < 0)
+      firstRow = 0;
+    if (lastRow == -1 || lastRow >= model->rowCount(parent))
+      lastRow = model->rowCount(parent)-1;
+    for (int row = firstRow; row <= lastRow; ++row)
+      if (!writer.write(formatUtf8RowInternal(model, row, parent, role)))
+        return false;
+  }
+  writer.write(formatTableFooter(headers).toUtf8());
+  return writer.flush();
+}
+
 void AbstractTextFormatter::fetchHeaderList(
     QStringList *headers, const SharedUiItem &item) const {
   Q_ASSERT(headers);
@@ -111,6 +194,45 @@ QString AbstractTextFormatter::formatRowInternal(
   return formatRow(cells, rowHeader.isNull() ? item.qualifiedId() : rowHeader);
 }
 
+Utf8String AbstractTextFormatter::formatUtf8RowInternal(
+    const QAbstractItemModel *model, int row,
+    const QModelIndex &parent, int role) const {
+  if (!model)
+    return {};
+  Utf8StringList cells;
+  int columns = model->columnCount(parent);
+  for (int column = 0; column < columns; ++column)
+    cells.append(Utf8String(model->index(row, column, parent).data(role)));
+  if (!_rowHeadersEnabled)
+    return formatUtf8Row(cells);
+  Utf8String rowHeader(model->headerData(row, Qt::Vertical, role));
+  if (rowHeader.isNull())
+    rowHeader = Utf8String::number(row);
+  return formatUtf8Row(cells, rowHeader);
+}
+
+Utf8String AbstractTextFormatter::formatUtf8RowInternal(
+    const SharedUiItem &item, int role, const Utf8String &rowHeader) const {
+  Utf8StringList cells;
+  int n = item.uiSectionCount();
+  for (int i = 0; i < n; ++i)
+    cells.append(item.uiUtf8(i, role));
+  if (!_rowHeadersEnabled)
+    return formatUtf8Row(cells);
+  return formatUtf8Row(cells, rowHeader.isNull() ? item.qualifiedId()
+                                                  : rowHeader);
+}
+
+Utf8String AbstractTextFormatter::formatUtf8Cell(
+    const Utf8String &rawData) const {
+  return formatCell(rawData.toUtf16()).toUtf8();
+}
+
+Utf8String AbstractTextFormatter::formatUtf8Row(
+    const Utf8StringList &cells, const Utf8String &rowHeader) const {
+  return formatRow(cells.toUtf16StringList(), rowHeader.toUtf16()).toUtf8();
+}
+
 QString AbstractTextFormatter::formatTableHeader(const QStringList &) const {
   return QString();
 }
@@ -16,6 +16,7 @@
 
 #include "modelview/shareduiitemlist.h"
 #include <QAbstractItemModel>
+#include <QIODevice>
 
 /** Convenience shared feature for text formatters. */
 class LIBP6CORESHARED_EXPORT AbstractTextFormatter {
@@ -93,6 +94,21 @@ public:
       const QAbstractItemModel *model, int firstRow = 0, int lastRow = -1,
       const QModelIndex &parent = QModelIndex(),
       int role = Qt::DisplayRole) const;
+  /** Same as formatTable() but writing rows as UTF-8 to output as soon as
+   * they are formatted instead of building the whole table in memory.
+   * Writes are buffered by ~64 kB and when output lags behind (e.g. a slow
+   * HTTP client), waits for pending bytes to be written before formatting
+   * more rows, so that memory usage does not depend on table size.
+   * @return false on write error or timeout */
+  bool writeTable(QIODevice *output, const SharedUiItemList &list,
+                  int role = Qt::DisplayRole) const;
+  /** Same as formatTable() but writing rows as UTF-8 to output as soon as
+   * they are formatted.
+   * @see writeTable(QIODevice *, const SharedUiItemList &, int) */
+  bool writeTable(
+      QIODevice *output, const QAbstractItemModel *model, int firstRow = 0,
+      int lastRow = -1, const QModelIndex &parent = QModelIndex(),
+      int role = Qt::DisplayRole) const;
   /** Format the table header.
    * If column headers are enabled, the header may include a header row,
    * otherwise only outputs static part of the header (e.g. <table> for html).
@@ -121,6 +137,15 @@ public:
    * If row headers are enabled, topLeftHeader is used. */
   virtual QString formatRow(const QStringList &cells,
                             QString rowHeader = QString()) const = 0;
+  /** Same as formatCell() but on UTF-8 data.
+   * Default implementation converts to and from utf-16 and calls formatCell(),
+   * subclasses should override it to avoid conversions. */
+  virtual Utf8String formatUtf8Cell(const Utf8String &rawData) const;
+  /** Same as formatRow() but on UTF-8 data.
+   * Default implementation converts to and from utf-16 and calls formatRow(),
+   * subclasses should override it to avoid conversions. */
+  virtual Utf8String formatUtf8Row(const Utf8StringList &cells,
+                                   const Utf8String &rowHeader = {}) const;
 
 protected:
   /** Fetch column headers, but topLeftHeader() even if rowHeadersEnabled() */
@@ -138,6 +163,10 @@ private:
     * @param rowHeader: use qualifiedId if null */
   QString formatRowInternal(const SharedUiItem &item, int role,
                             Utf8String rowHeader = {}) const;
+  Utf8String formatUtf8RowInternal(const QAbstractItemModel *model, int row,
+                                   const QModelIndex &parent, int role) const;
+  Utf8String formatUtf8RowInternal(const SharedUiItem &item, int role,
+                                   const Utf8String &rowHeader) const;
 };
 
 #endif // ABSTRACTTEXTFORMATTER_H
@@ -13,6 +13,7 @@
  */
 #include "csvformatter.h"
 #include "format/stringutils.h"
+#include "util/utf8kernels.h"
 
 QChar CsvFormatter::_defaultFieldSeparator(',');
 QString CsvFormatter::_defaultRecordSeparator("\n");
@@ -50,6 +51,11 @@ void CsvFormatter::setEscapeChar(QChar c) {
   updateSpecialChars();
 }
 
+void CsvFormatter::setReplacementChar(QChar c) {
+  _replacementChar = c;
+  updateSpecialChars();
+}
+
 void CsvFormatter::updateSpecialChars() {
   _specialChars.clear();
   if (!_escapeChar.isNull())
@@ -59,6 +65,19 @@ void CsvFormatter::updateSpecialChars() {
   if (!_fieldSeparator.isNull())
     _specialChars.append(_fieldSeparator);
   _specialChars.append(_recordSeparator);
+  auto utf8 = [](QChar c) {
+    return c.isNull() ? Utf8String{} : QString(c).toUtf8(); };
+  _utf8RecordSeparator = _recordSeparator.toUtf8();
+  _utf8SpecialChars = _specialChars.toUtf8();
+  _utf8FieldSeparator = utf8(_fieldSeparator);
+  _utf8FieldQuote = utf8(_fieldQuote);
+  _utf8EscapeChar = utf8(_escapeChar);
+  _utf8ReplacementChar = utf8(_replacementChar);
+  // ascii special chars can be searched byte-wise since they never match part
+  // of an utf-8 multibyte sequence
+  _utf8SpecialCharsAreBytes =
+      _utf8SpecialChars.size() == _specialChars.size()
+      && _utf8SpecialChars.size() <= p6::utf8::MaxBytesSetSize;
 }
 
 QString CsvFormatter::formatCell(QString data) const {
@@ -95,6 +114,37 @@ QString CsvFormatter::formatCell(QString data) const {
   return s;
 }
 
+Utf8String CsvFormatter::formatUtf8Cell(const Utf8String &data) const {
+  // fallback to utf-16 when eliding may be needed (utf-8 size being greater
+  // than or equal to utf-16 size) or when special chars are not ascii
+  if (!_utf8SpecialCharsAreBytes
+      || (maxCellContentLength() >= 0 && data.size() >= maxCellContentLength()))
+    return AbstractTextFormatter::formatUtf8Cell(data);
+  Utf8String s;
+  s.reserve(data.size()+2*_utf8FieldQuote.size()+8);
+  s.append(_utf8FieldQuote);
+  const char *p = data.constData(), *end = p+data.size();
+  bool first = true;
+  while (p < end) {
+    auto n = p6::utf8::prefix_size_not_in(p, end, _utf8SpecialChars);
+    if (n) {
+      s.append(p, n);
+      p += n;
+      first = true;
+      continue;
+    }
+    if (!_utf8EscapeChar.isEmpty()) {
+      s.append(_utf8EscapeChar).append(*p);
+    } else if (!_utf8ReplacementChar.isEmpty() && first) {
+      s.append(_utf8ReplacementChar);
+      first = false;
+    }
+    ++p;
+  }
+  s.append(_utf8FieldQuote);
+  return s;
+}
+
 QString CsvFormatter::formatTableHeader(
     const QStringList &columnHeaders) const {
   QString s;
@@ -140,3 +190,22 @@ QString CsvFormatter::formatRow(const QStringList &cells,
   s.append(_recordSeparator);
   return s;
 }
+
+Utf8String CsvFormatter::formatUtf8Row(const Utf8StringList &cells,
+                                       const Utf8String &rowHeader) const {
+  Utf8String s;
+  if (rowHeadersEnabled()) {
+    s.append(formatUtf8Cell(rowHeader));
+    s.append(_utf8FieldSeparator);
+  }
+  bool first = true;
+  for (const Utf8String &cell : cells) {
+    if (first)
+      first = false;
+    else
+      s.append(_utf8FieldSeparator);
+    s.append(formatUtf8Cell(cell));
+  }
+  s.append(_utf8RecordSeparator);
+  return s;
+}
@@ -20,6 +20,10 @@
 class LIBP6CORESHARED_EXPORT CsvFormatter : public AbstractTextFormatter {
   QString _recordSeparator, _specialChars;
   QChar _fieldSeparator, _fieldQuote, _escapeChar, _replacementChar;
+  // utf-8 forms of the above, used by formatUtf8Cell() and formatUtf8Row()
+  Utf8String _utf8RecordSeparator, _utf8SpecialChars, _utf8FieldSeparator,
+  _utf8FieldQuote, _utf8EscapeChar, _utf8ReplacementChar;
+  bool _utf8SpecialCharsAreBytes;
   static QString _defaultRecordSeparator;
   static QChar _defaultFieldSeparator, _defaultFieldQuote, _defaultEscapeChar,
   _defaultReplacementChar;
@@ -80,7 +84,7 @@ public:
    * replacement char, or removed if replacement char not found.
    * Default: none
    * Examples: underscore, question mark */
-  void setReplacementChar(QChar c = QChar()) { _replacementChar = c; }
+  void setReplacementChar(QChar c = QChar());
   /** @see setReplacementChar() */
   static void setDefaultReplacementChar(QChar c = QChar()) {
     _defaultReplacementChar = c; }
@@ -93,6 +97,9 @@ public:
   using AbstractTextFormatter::formatRow;
   QString formatRow(const QStringList &cells,
                     QString rowHeader = QString()) const override;
+  Utf8String formatUtf8Cell(const Utf8String &data) const override;
+  Utf8String formatUtf8Row(const Utf8StringList &cells,
+                           const Utf8String &rowHeader = {}) const override;
 
 private:
   inline void updateSpecialChars();
@@ -0,0 +1,116 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "graphvizrendercache.h"
+#include "log/log.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QSaveFile>
+
+GraphvizRenderCache::GraphvizRenderCache(
+    qsizetype max_bytes, const QString &spill_dir)
+  : _cache(max_bytes), _spill_dir(spill_dir) {
+  if (!_spill_dir.isEmpty() && !QDir().mkpath(_spill_dir)) {
+    Log::warning() << "cannot create graphviz render cache directory "
+                   << _spill_dir << ", disabling on-disk cache";
+    _spill_dir.clear();
+  }
+}
+
+QByteArray GraphvizRenderCache::key(
+    const Utf8String &source, GraphvizRenderer::Layout layout,
+    GraphvizRenderer::Format format, const QStringList &options) {
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  hash.addData(GraphvizRenderer::layoutAsString(layout)+"\n"
+               +GraphvizRenderer::formatAsString(format)+"\n");
+  for (const auto &option: options)
+    hash.addData(Utf8String(option)+"\n");
+  hash.addData("\n");
+  hash.addData(source);
+  return hash.result().toHex();
+}
+
+QString GraphvizRenderCache::spill_path(const QByteArray &key) const {
+  return _spill_dir+"/"+key;
+}
+
+Utf8String GraphvizRenderCache::get_or_render(
+    const QByteArray &key, std::function<Utf8String(bool *success)> render,
+    bool *success) {
+  QMutexLocker ml(&_mutex);
+  bool waited = false;
+  forever {
+    if (auto output = _cache.object(key)) {
+      ++_stats.hits;
+      if (success)
+        *success = true;
+      return *output;
+    }
+    if (!_in_flight.contains(key))
+      break;
+    // identical rendering in flight: wait for it, and render again only if
+    // it failed
+    if (!waited) {
+      ++_stats.coalesced;
+      waited = true;
+    }
+    _rendering_finished.wait(&_mutex);
+  }
+  _in_flight.insert(key);
+  ml.unlock();
+  Utf8String output;
+  bool from_disk = false, ok = true;
+  if (!_spill_dir.isEmpty()) {
+    QFile file(spill_path(key));
+    if (file.open(QIODevice::ReadOnly)) {
+      output = file.readAll();
+      from_disk = file.error() == QFileDevice::NoError;
+    }
+  }
+  if (!from_disk) {
+    output = render(&ok);
+    if (ok && !_spill_dir.isEmpty()) {
+      QSaveFile file(spill_path(key));
+      if (!file.open(QIODevice::WriteOnly)
+          || file.write(output) != output.size() || !file.commit())
+        Log::warning() << "cannot write graphviz render cache file "
+                       << file.fileName() << " : " << file.errorString();
+    }
+  }
+  ml.relock();
+  _in_flight.remove(key);
+  if (from_disk) {
+    ++_stats.disk_hits;
+  } else {
+    ++_stats.misses;
+    if (!ok)
+      ++_stats.failures;
+  }
+  if (ok) // cost 0 would never be evicted
+    _cache.insert(key, new Utf8String(output),
+                  qMax<qsizetype>(output.size(), 1));
+  _rendering_finished.wakeAll();
+  if (success)
+    *success = ok;
+  return output;
+}
+
+GraphvizRenderCache::Stats GraphvizRenderCache::stats() const {
+  QMutexLocker ml(&_mutex);
+  return _stats;
+}
+
+void GraphvizRenderCache::clear() {
+  QMutexLocker ml(&_mutex);
+  _cache.clear();
+}
@@ -0,0 +1,80 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GRAPHVIZRENDERCACHE_H
+#define GRAPHVIZRENDERCACHE_H
+
+#include "format/graphvizrenderer.h"
+#include <QCache>
+#include <QSet>
+#include <QWaitCondition>
+#include <functional>
+
+/** Content-addressed cache of GraphvizRenderer outputs, keyed by a hash of
+ * source, layout, format and options.
+ *
+ * Outputs are kept in memory in a LRU bounded by their total size, and, if a
+ * spill directory is set, also written there (one file per key) so that they
+ * survive memory eviction and restarts. The spill directory is not bounded,
+ * its cleanup is left to the caller.
+ *
+ * Concurrent renderings of the same key are deduplicated: only one process is
+ * started, other callers wait for its output. Failed renderings are never
+ * cached.
+ *
+ * Thread-safe. Used by GraphvizRenderer::run() when set with set_cache() or
+ * set_default_cache().
+ */
+class LIBP6CORESHARED_EXPORT GraphvizRenderCache {
+public:
+  struct Stats {
+    quint64 hits = 0; // found in memory
+    quint64 disk_hits = 0; // found in spill directory
+    quint64 misses = 0; // actually rendered, including failures
+    quint64 failures = 0;
+    quint64 coalesced = 0; // waited for an identical rendering in flight
+  };
+
+private:
+  mutable QMutex _mutex;
+  QWaitCondition _rendering_finished;
+  QCache<QByteArray,Utf8String> _cache;
+  QSet<QByteArray> _in_flight;
+  QString _spill_dir;
+  Stats _stats;
+
+public:
+  /** @param max_bytes memory LRU bound
+   *  @param spill_dir optional directory for on-disk copies, created if
+   *  needed */
+  explicit GraphvizRenderCache(qsizetype max_bytes = 32*1024*1024,
+                               const QString &spill_dir = {});
+  GraphvizRenderCache(const GraphvizRenderCache &) = delete;
+  GraphvizRenderCache &operator=(const GraphvizRenderCache &) = delete;
+  static QByteArray key(
+      const Utf8String &source, GraphvizRenderer::Layout layout,
+      GraphvizRenderer::Format format, const QStringList &options = {});
+  /** Return cached output for key, or call render() to produce it.
+   *  render() must set its success parameter to false on failure. */
+  Utf8String get_or_render(
+      const QByteArray &key, std::function<Utf8String(bool *success)> render,
+      bool *success = nullptr);
+  Stats stats() const;
+  /** Empty memory cache (spill directory is left untouched). */
+  void clear();
+
+private:
+  inline QString spill_path(const QByteArray &key) const;
+};
+
+#endif // GRAPHVIZRENDERCACHE_H
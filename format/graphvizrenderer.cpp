@@ -12,6 +12,7 @@
  * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "graphvizrenderer.h"
+#include "graphvizrendercache.h"
 #include "util/paramsprovidermerger.h"
 #include "util/containerutils.h"
 #include <QMap>
@@ -20,12 +21,15 @@
 #include <QTimer>
 #include <QtDebug>
 #include <QDateTime>
+#include <atomic>
+
+static std::atomic<GraphvizRenderCache *> _default_cache = nullptr;
 
 GraphvizRenderer::GraphvizRenderer(QObject *parent,
     const Utf8String &source, Layout layout, Format format, int timeoutms,
     const ParamSet &params)
   : QProcess(parent), _source(source), _layout(layout), _format(format),
-    _params(params), _timeoutms(timeoutms) {
+    _params(params), _timeoutms(timeoutms), _cache(_default_cache) {
   connect(this, &QProcess::finished,
           this, &GraphvizRenderer::process_finished);
   connect(this, &QProcess::errorOccurred,
@@ -39,8 +43,29 @@ GraphvizRenderer::GraphvizRenderer(QObject *parent,
 Utf8String GraphvizRenderer::run(
     const ParamsProvider &context, const Utf8String &start_source) {
   QMutexLocker ml(&_mutex);
+  auto ppm = ParamsProviderMerger(&context)(_params);
+  auto source = start_source | ppm.paramRawUtf8("source") | _source;
+  Format format = formatFromString(ppm.paramRawUtf8("format"), _format);
+  Layout layout = layoutFromString(ppm.paramRawUtf8("layout"), _layout);
+  int timeoutms = ppm.paramNumber<double>("timeout", _timeoutms/1e3)*1e3;
+  if (!_cache)
+    return do_run(source, layout, format, timeoutms);
+  auto key = GraphvizRenderCache::key(source, layout, format, _options);
+  return _cache->get_or_render(key, [&](bool *success) {
+    auto output = do_run(source, layout, format, timeoutms);
+    *success = _success;
+    return output;
+  }, &_success);
+}
+
+void GraphvizRenderer::set_default_cache(GraphvizRenderCache *cache) {
+  _default_cache = cache;
+}
+
+Utf8String GraphvizRenderer::do_run(
+    const Utf8String &source, Layout layout, Format format, int timeoutms) {
   _output.clear();
-  do_start(context, start_source);
+  do_start(source, layout, format, timeoutms);
   if (QThread::currentThread() == thread()) {
     do QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
     while (_output.isEmpty());
@@ -52,12 +77,7 @@ Utf8String GraphvizRenderer::run(
 }
 
 void GraphvizRenderer::do_start(
-    const ParamsProvider &context, const Utf8String &start_source) {
-  auto ppm = ParamsProviderMerger(&context)(_params);
-  auto source = start_source | ppm.paramRawUtf8("source") | _source;
-  Format format = formatFromString(ppm.paramRawUtf8("format"), _format);
-  Layout layout = layoutFromString(ppm.paramRawUtf8("layout"), _layout);
-  int timeoutms = ppm.paramNumber<double>("timeout", _timeoutms/1e3)*1e3;
+    const Utf8String &source, Layout layout, Format format, int timeoutms) {
   if (timeoutms > 0) {
     _timout_timer = new QTimer(this);
     connect(_timout_timer, &QTimer::timeout, this, &GraphvizRenderer::kill);
@@ -89,6 +109,7 @@ void GraphvizRenderer::process_finished(
   read_stderr();
   read_stdout();
   bool success = (exitStatus == QProcess::NormalExit && exitCode == 0);
+  _success = success;
   if (success) {
     qDebug() << "graphviz rendering process successful with return code"
              << exitCode << "and QProcess::ExitStatus" << (int)exitStatus
@@ -19,6 +19,7 @@
 #include <QProcess>
 
 class QTimer;
+class GraphvizRenderCache;
 
 /** QProcess subclass for rendering graphviz graph using localy installed
  *  binaries (dot, neato, etc.).
@@ -41,6 +42,8 @@ private:
   QTimer *_timout_timer = 0;
   QStringList _options;
   qint64 _startms;
+  bool _success = false;
+  GraphvizRenderCache *_cache;
 
 public:
   GraphvizRenderer(
@@ -90,10 +93,19 @@ public:
                  const Utf8String &source = {});
   inline Utf8String run(const Utf8String &source) {
     return run(*ParamsProvider::empty(), source); }
+  /** Whether last run() failed, in which case it returned stderr content or
+   *  "error" rather than an image. */
+  inline bool failed() const { return !_success; }
   inline QStringList options() const { return _options; }
   /** Set custom command line options, such as "-Gsplines=spline" or "-n2" */
   inline void set_options(const QStringList &options) { _options = options; }
   inline void set_layout(Layout layout) { _layout = layout; }
+  /** Serve run() from cache, or nullptr to always start a process.
+   *  Default: set_default_cache() value, itself nullptr by default. */
+  inline void set_cache(GraphvizRenderCache *cache) { _cache = cache; }
+  /** Set cache used by renderers constructed afterward. Cache must outlive
+   *  them. */
+  static void set_default_cache(GraphvizRenderCache *cache);
   static Utf8String mime_type(Format format);
   static Format formatFromString(const Utf8String &s, Format def = Gv);
   static Utf8String formatAsString(Format format);
@@ -102,8 +114,10 @@ public:
 
 private:
   using QProcess::start; // make it private
-  void do_start(const ParamsProvider &params_evaluation_context,
-                const Utf8String &source);
+  Utf8String do_run(const Utf8String &source, Layout layout, Format format,
+                    int timeoutms);
+  void do_start(const Utf8String &source, Layout layout, Format format,
+                int timeoutms);
   void process_error(QProcess::ProcessError error);
   void process_finished(int exitCode, QProcess::ExitStatus exitStatus);
   void read_stdout();
@@ -13,6 +13,7 @@
  */
 #include "htmltableformatter.h"
 #include "stringutils.h"
+#include "util/utf8kernels.h"
 
 HtmlTableFormatter::TextConversion
 HtmlTableFormatter::_defaultTextConversion(HtmlEscapingWithUrlAsLinks);
@@ -37,6 +38,50 @@ QString HtmlTableFormatter::formatCell(QString data) const {
   return data;
 }
 
+Utf8String HtmlTableFormatter::formatUtf8Cell(const Utf8String &data) const {
+  // fallback to utf-16 when eliding may be needed (utf-8 size being greater
+  // than or equal to utf-16 size) or when urls may have to be converted
+  if ((maxCellContentLength() >= 0 && data.size() >= maxCellContentLength())
+      || (_textConversion == HtmlEscapingWithUrlAsLinks
+          && data.contains("http")))
+    return AbstractTextFormatter::formatUtf8Cell(data);
+  if (_textConversion == AsIs)
+    return data;
+  const bool newlineAsBr = _textConversion == HtmlEscapingWithUrlAsLinks;
+  const QByteArrayView specialChars = newlineAsBr ? "<>&\"'\n" : "<>&\"'";
+  Utf8String s;
+  s.reserve(data.size()+data.size()/8);
+  const char *p = data.constData(), *end = p+data.size();
+  while (p < end) {
+    auto n = p6::utf8::prefix_size_not_in(p, end, specialChars);
+    s.append(p, n);
+    p += n;
+    if (p == end)
+      break;
+    switch (*p++) {
+    case '<':
+      s.append("&lt;");
+      break;
+    case '>':
+      s.append("&gt;");
+      break;
+    case '&':
+      s.append("&amp;");
+      break;
+    case '"':
+      s.append("&#34;");
+      break;
+    case '\'':
+      s.append("&#39;");
+      break;
+    case '\n':
+      s.append("<br/>\n");
+      break;
+    }
+  }
+  return s;
+}
+
 QString HtmlTableFormatter::formatTableHeader(
     const QStringList &columnHeaders) const {
   QString s;
@@ -70,3 +115,15 @@ QString HtmlTableFormatter::formatRow(const QStringList &cells,
   s.append("</tr>\n");
   return s;
 }
+
+Utf8String HtmlTableFormatter::formatUtf8Row(
+    const Utf8StringList &cells, const Utf8String &rowHeader) const {
+  Utf8String s;
+  s.append("<tr>");
+  if (rowHeadersEnabled())
+    s.append("<th>").append(formatUtf8Cell(rowHeader)).append("</th>");
+  for (const Utf8String &cell: cells)
+    s.append("<td>").append(formatUtf8Cell(cell)).append("</td>");
+  s.append("</tr>\n");
+  return s;
+}
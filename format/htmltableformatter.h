@@ -56,6 +56,9 @@ public:
   using AbstractTextFormatter::formatRow;
   QString formatRow(const QStringList &cells,
                     QString rowHeader = QString()) const override;
+  Utf8String formatUtf8Cell(const Utf8String &data) const override;
+  Utf8String formatUtf8Row(const Utf8StringList &cells,
+                           const Utf8String &rowHeader = {}) const override;
 };
 
 #endif // HTMLTABLEFORMATTER_H
@@ -13,37 +13,80 @@
  */
 #include "xlsxwriter.h"
 #include "log/log.h"
+#include "io/zipwriter.h"
 #include <QFile>
 #include <QDir>
-#include <QProcess>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <cmath>
+#include <functional>
+#include <atomic>
+
+static const qsizetype BatchSize = 262'144; // rows bytes compressed at once
 
 class XlsxWriter::Sheet {
 public:
   Utf8String _title;
   size_t _index;
-  QFile *_file;
+  QFile *_file; // deflated sheet xml, copied as is in the archive
+  ZipDeflater *_deflater; // only used by worker threads once created
   size_t _rowcount = 0;
-  bool _success = true;
-  Sheet(const Utf8String &title, size_t index, const Utf8String &workdir)
-    : _title(title), _index(index) {
-    _file = new QFile(workdir+"/"+"sheet"+Utf8String::number(_index)+".xml");
-    if (!_file->open(QIODevice::Append|QIODevice::WriteOnly
-                     |QIODevice::Truncate)
-        || _file->write(
+  std::atomic<bool> _success = true;
+  Utf8String _buffer; // rows bytes not yet handed to a worker
+  QThreadPool *_pool;
+  QSemaphore _idle { 1 }; // at most one job per sheet, to keep rows ordered
+  Sheet(const Utf8String &title, size_t index, const Utf8String &workdir,
+        QThreadPool *pool)
+    : _title(title), _index(index), _pool(pool) {
+    _file = new QFile(workdir+"/"+"sheet"+Utf8String::number(_index)
+                      +".xml.deflate");
+    _deflater = new ZipDeflater(_file);
+    if (!_file->open(QIODevice::ReadWrite|QIODevice::Truncate)
+        || !_deflater->write(
           "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
           "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/"
           "2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocum"
           "ent/2006/relationships\">\n"
           "<sheetData>\n"
-          ) < 0) {
+          )) {
       Log::error() << "cannot create file: " << _file->fileName() << " : "
                    << _file->errorString();
       _success = false;
     }
   }
   ~Sheet() {
-    if (_file)
-      delete _file;
+    wait();
+    delete _deflater;
+    delete _file;
+  }
+  /** Run job on a worker thread, after previous one, if any, has finished,
+   *  which also throttles the caller if workers do not keep up. */
+  void run(std::function<void()> job) {
+    _idle.acquire();
+    _pool->start([this, job = std::move(job)]() {
+      job();
+      _idle.release();
+    });
+  }
+  void wait() {
+    _idle.acquire();
+    _idle.release();
+  }
+  /** Compress bytes, called on worker thread. */
+  void compress(const Utf8String &bytes) {
+    if (_success && !_deflater->write(bytes)) {
+      Log::error() << "cannot write to file: " << _file->fileName() << " : "
+                   << _file->errorString();
+      _success = false;
+    }
+  }
+  /** Hand buffered rows to a worker thread. */
+  void flush() {
+    if (_buffer.isEmpty())
+      return;
+    run([this, bytes = std::move(_buffer)]() { compress(bytes); });
+    _buffer = {};
   }
 };
 
@@ -86,46 +129,97 @@ inline Utf8String cell_ref(size_t rownum, size_t colnum) {
         colnum, "ABCDEFGHIJKLMNOPQRSTUVWXYZ"_ba) + Utf8String::number(rownum);
 }
 
-static inline double to_excel_datetime(QVariant v) {
+static inline double to_excel_datetime(QDate date, QTime time) {
   // excel pretends to use 1900-1-1 as an epoch, but...
   // for excel 1900-1-1 is day 1 (not 0)
   // for excel 1900-2-29 exists
   // therefore the virtual gregorian epoch is 2 days before 1900-1-1
   // (a.k.a. 1970-1-1 is day 25569)
   static const QDate _excel_epoch(1899, 12, 30);
-  auto days_since_1899 = _excel_epoch.daysTo(v.toDate());
+  auto days_since_1899 = _excel_epoch.daysTo(date);
   if (days_since_1899 < 61)
     days_since_1899 = 0; // everything before 1900-3-1 is inconsistent
-  auto days_since_midnight = v.toTime().msecsSinceStartOfDay()/86'400'000.0;
+  auto days_since_midnight = time.msecsSinceStartOfDay()/86'400'000.0;
   return days_since_1899+days_since_midnight;
 }
 
+static inline double to_excel_datetime(QVariant v) {
+  return to_excel_datetime(v.toDate(), v.toTime());
+}
+
+/** string cell content, shared if index != SIZE_MAX, otherwise inline */
+static inline Utf8String string_cell(
+    const Utf8String &s, size_t index) {
+  if (s.isEmpty())
+    return " t=\"str\"><v/></c>\n"_u8; // FIXME str or number ?
+  if (index != SIZE_MAX)
+    return " t=\"s\"><v>"+Utf8String::number(index)+"</v></c>\n";
+  bool has_spaces = false;
+  auto q = html_protect(s, &has_spaces);
+  return (has_spaces ? " t=\"inlineStr\"><is><t xml:space=\"preserve\">"_u8
+                     : " t=\"inlineStr\"><is><t>"_u8)+q+"</t></is></c>\n"_u8;
+}
+
+/** encode cell for row i in column, or nothing if cell is empty or missing
+ *  @param indexes shared strings indexes for Utf8StringList columns */
+static inline Utf8String column_cell(
+    const XlsxWriter::Column &column, const QList<size_t> &indexes,
+    qsizetype i, bool bool_as_text) {
+  if (auto c = std::get_if<QList<double>>(&column)) {
+    if (i >= c->size() || std::isnan(c->at(i)))
+      return {};
+    return " s=\"4\"><v>"+Utf8String::number(c->at(i), 'g', 16)+"</v></c>\n";
+  }
+  if (auto c = std::get_if<QList<qint64>>(&column)) {
+    if (i >= c->size())
+      return {};
+    return " s=\"5\"><v>"+Utf8String::number(c->at(i))+"</v></c>\n";
+  }
+  if (auto c = std::get_if<QList<bool>>(&column)) {
+    if (i >= c->size())
+      return {};
+    if (bool_as_text)
+      return string_cell(c->at(i) ? "true"_u8 : "false"_u8, SIZE_MAX);
+    return " t=\"b\" s=\"6\"><v>"+(c->at(i) ? "1"_u8 : "0"_u8)+"</v></c>\n";
+  }
+  if (auto c = std::get_if<QList<QDateTime>>(&column)) {
+    if (i >= c->size() || !c->at(i).isValid())
+      return {};
+    return " s=\"1\"><v>"+Utf8String::number(to_excel_datetime(
+                   c->at(i).date(), c->at(i).time()), 'g', 16)+"</v></c>\n";
+  }
+  if (auto c = std::get_if<QList<QDate>>(&column)) {
+    if (i >= c->size() || !c->at(i).isValid())
+      return {};
+    return " s=\"2\"><v>"+Utf8String::number(to_excel_datetime(
+                   c->at(i), {}), 'g', 16)+"</v></c>\n";
+  }
+  if (auto c = std::get_if<QList<QTime>>(&column)) {
+    if (i >= c->size() || !c->at(i).isValid())
+      return {};
+    return " s=\"3\"><v>"+Utf8String::number(to_excel_datetime(
+                   {}, c->at(i)), 'g', 16)+"</v></c>\n";
+  }
+  if (auto c = std::get_if<Utf8StringList>(&column)) {
+    if (i >= c->size())
+      return {};
+    return string_cell(c->at(i), indexes.value(i, SIZE_MAX));
+  }
+  if (auto c = std::get_if<XlsxWriter::InlineStrings>(&column)) {
+    if (i >= c->size())
+      return {};
+    return string_cell(c->at(i), SIZE_MAX);
+  }
+  return {};
+}
+
 XlsxWriter::XlsxWriter(const Utf8String &workdir, bool autoclean)
-  : _workdir(workdir), _autoclean(autoclean) {
+  : _pool(new QThreadPool), _workdir(workdir), _autoclean(autoclean) {
   if (!QDir().mkpath(workdir)) {
     Log::error() << "cannot create directory: " << workdir;
     _success = false;
     return;
   }
-  _strings_file = new QFile(_workdir+"/strings.xml");
-  if (!_strings_file->open(QIODevice::Append|QIODevice::WriteOnly
-                           |QIODevice::Truncate)) {
-    Log::error() << "cannot create file: " << _strings_file->fileName()
-                 << " : " << _strings_file->errorString();
-    _success = false;
-    return;
-  }
-  if (_strings_file->write(
-        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
-        "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\""
-        " count=                                            "
-        " uniqueCount=                                                >\n"
-        ) < 0) {
-    Log::error() << "cannot write header to file: " << _strings_file->fileName()
-                 << " : " << _strings_file->errorString();
-    _success = false;
-    return;
-  }
 }
 
 Utf8String XlsxWriter::normalized_sheet_name(const Utf8String &title) {
@@ -141,7 +235,7 @@ XlsxWriter::Sheet *XlsxWriter::get_or_create_sheet(
   auto title = normalized_sheet_name(original_title);
   if (_sheets.contains(title))
     return _sheets[title];
-  Sheet *sheet = new Sheet(title, _sheets.size()+1, _workdir);
+  Sheet *sheet = new Sheet(title, _sheets.size()+1, _workdir, _pool);
   _sheets.insert(title, sheet);
   if (!sheet->_success)
     _success = false;
@@ -153,16 +247,10 @@ size_t XlsxWriter::share_string(
   auto string = original_string.null_coalesced();
   auto i = _strings.value(string, SIZE_MAX);
   if (i == SIZE_MAX) {
+    if (_strings.size() >= _max_shared_strings)
+      return SIZE_MAX;
     i = _strings.size();
     _strings.insert(string, i);
-    bool has_spaces = false;
-    auto s = html_protect(string, &has_spaces);
-    if (_strings_file->write((has_spaces ? "<si><t xml:space=\"preserve\">"
-                              : "<si><t>")+s+"</t></si>\n") < 0) {
-      Log::error() << "cannot write to file: " << _strings_file->fileName()
-                   << " : " << _strings_file->errorString();
-      _success = false;
-    }
   }
   if (incr_counter)
     ++_strings_ref;
@@ -210,25 +298,67 @@ bool XlsxWriter::appendRow(
                +"</v></c>\n";
     else { // will be handled as a string
       auto s = v.value<Utf8String>();
-      if (s.isEmpty())
-        bytes += " t=\"str\"><v/></c>\n"; // FIXME str or number ?
-      else // LATER should we use str instead of s below some minimal size ?
-        bytes += " t=\"s\"><v>"
-                 +Utf8String::number(share_string(s, true))
-                 +"</v></c>\n";
+      // LATER should we use str instead of s below some minimal size ?
+      bytes += string_cell(s, s.isEmpty() ? SIZE_MAX : share_string(s, true));
     }
     ++colnum;
   }
   bytes += "  </row>\n";
-  if (sheet->_file->write(bytes) < 0) {
-    Log::error() << "cannot write to file: " << sheet->_file->fileName()
-                 << " : " << sheet->_file->errorString();
+  sheet->_buffer += bytes;
+  if (sheet->_buffer.size() >= BatchSize)
+    sheet->flush();
+  if (!sheet->_success)
     return _success = false;
-  }
   sheet->_rowcount++;
   return true;
 }
 
+bool XlsxWriter::appendColumns(
+    const QList<Column> &columns, const Utf8String &sheet_title) {
+  if (!_success)
+    return false;
+  Sheet *sheet = this->get_or_create_sheet(sheet_title);
+  qsizetype n = 0;
+  for (const auto &column: columns)
+    n = qMax(n, std::visit([](const auto &c) { return c.size(); }, column));
+  // strings are shared here since the table is not thread-safe, the rest of
+  // encoding is done on worker thread
+  QList<QList<size_t>> indexes(columns.size());
+  for (qsizetype j = 0; j < columns.size(); ++j)
+    if (auto c = std::get_if<Utf8StringList>(&columns[j])) {
+      indexes[j].reserve(c->size());
+      for (const auto &s: *c)
+        indexes[j] += s.isEmpty() ? SIZE_MAX : share_string(s, true);
+    }
+  auto first_rownum = sheet->_rowcount+1;
+  sheet->_rowcount += n;
+  sheet->run([sheet, columns, indexes = std::move(indexes), first_rownum, n,
+             bytes = std::move(sheet->_buffer), spans = Utf8String::number(
+               columns.size()), bool_as_text = _bool_as_text]() mutable {
+    for (qsizetype i = 0; i < n; ++i) {
+      auto rownum = first_rownum+i;
+      bytes += "  <row r=\""+Utf8String::number(rownum)+"\" spans=\"1:"+spans
+               +"\">\n";
+      for (qsizetype j = 0; j < columns.size(); ++j) {
+        auto cell = column_cell(columns.at(j), indexes.at(j), i,
+                                bool_as_text);
+        if (!cell.isEmpty())
+          bytes += "<c r=\""+cell_ref(rownum, j+1)+"\""+cell;
+      }
+      bytes += "  </row>\n";
+      if (bytes.size() >= BatchSize) {
+        sheet->compress(bytes);
+        bytes.resize(0); // rather than clear(), to keep capacity
+      }
+    }
+    sheet->compress(bytes);
+  });
+  sheet->_buffer = {};
+  if (!sheet->_success)
+    return _success = false;
+  return true;
+}
+
 size_t XlsxWriter::rowCount(const Utf8String &original_title) const {
   auto title = normalized_sheet_name(original_title);
   auto sheet = _sheets[title];
@@ -253,56 +383,37 @@ bool XlsxWriter::write(Utf8String filename) {
                                +".xml\" ContentType=\"application/vnd.openxmlfo"
                                 "rmats-officedocument.spreadsheetml.worksheet+x"
                                 "ml\"/>\n";
-    if (sheet->_file->write(
-          "</sheetData>\n"
-          "</worksheet>\n"
-          ) < 0) {
+    sheet->_buffer += "</sheetData>\n"
+                      "</worksheet>\n";
+    sheet->flush();
+    sheet->run([sheet]() {
+      if (sheet->_success && !sheet->_deflater->finish())
+        sheet->_success = false;
+    });
+  }
+  for (auto sheet: std::as_const(_sheets)) {
+    sheet->wait();
+    if (!sheet->_success || !sheet->_file->seek(0)) {
       Log::error() << "cannot write footer to file: "
                    << sheet->_file->fileName() << " : "
                    << sheet->_file->errorString();
       return _success = false;
     }
-    sheet->_file->close();
   }
 
-  // closing shared strings file
-  if (_strings_file->write("</sst>\n") < 0) {
-    Log::error() << "cannot write footer to file: " << _strings_file->fileName()
-                 << " : " << _strings_file->errorString();
-    return _success = false;
-  }
-  _strings_file->close();
-
-  // updating shared strings file header
-  if (!_strings_file->open(QIODevice::ReadWrite|QIODevice::ExistingOnly)) {
-    Log::error() << "cannot reopen file: " << _strings_file->fileName()
-                 << " : " << _strings_file->errorString();
-    return _success = false;
-  }
-  auto ba = _strings_file->read(16384);
-  auto i = ba.indexOf("count="_ba);
-  if (!_strings_file->seek(i+6)
-      || _strings_file->write("\""+Utf8String::number(_strings_ref)+"\"") < 0) {
-    Log::error() << "cannot update header of file: "
-                 << _strings_file->fileName() << " : "
-                 << _strings_file->errorString();
-    return _success = false;
-  }
-  i = ba.indexOf("uniqueCount="_ba);
-  if (!_strings_file->seek(i+12)
-      || _strings_file->write("\""+Utf8String::number(_strings.size())
-                              +"\"") < 0) {
-    Log::error() << "cannot update header of file: "
-                 << _strings_file->fileName() << " : "
-                 << _strings_file->errorString();
+  // opening archive
+  if (!filename.startsWith('/'))
+    filename = Utf8String(QDir::currentPath())+"/"+filename;
+  QSaveFile archive(filename);
+  if (!archive.open(QIODevice::WriteOnly)) {
+    Log::error() << "cannot write spreadsheet archive: " << filename << " : "
+                 << archive.errorString();
     return _success = false;
   }
-  _strings_file->close();
+  ZipWriter zip(&archive);
 
   // writing book file
-  QFile file(_workdir+"/workbook.xml");
-  if (!file.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Append)
-      || file.write(
+  zip.addEntry("workbook.xml"_u8,
         "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
         "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006"
         "/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/"
@@ -311,18 +422,10 @@ bool XlsxWriter::write(Utf8String filename) {
         "  <sheets>\n"
         +sheets_in_book+
         "  </sheets>\n"
-        "</workbook>\n"
-        ) < 0) {
-    Log::error() << "cannot write file: " << file.fileName() << " : "
-                 << file.errorString();
-    return _success = false;
-  }
-  file.close();
+        "</workbook>\n"_u8);
 
   // writing style sheet
-  file.setFileName(_workdir+"/styles.xml");
-  if (!file.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Append)
-      || file.write(
+  zip.addEntry("styles.xml"_u8,
         "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
         "<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/20"
         "06/main\" >\n"
@@ -406,51 +509,26 @@ bool XlsxWriter::write(Utf8String filename) {
         "  <xf numFmtId=\"169\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>\n"
         "  <xf numFmtId=\"172\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>\n"
         "</cellXfs>\n"
-        "</styleSheet>\n"
-        ) < 0) {
-    Log::error() << "cannot write file: " << file.fileName() << " : "
-                 << file.errorString();
-    return _success = false;
-  }
-  file.close();
+        "</styleSheet>\n");
 
   // writing workbook relations file
-  QDir().mkdir(_workdir+"/_rels");
-  file.setFileName(_workdir+"/_rels/workbook.xml.rels");
-  if (!file.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Append)
-      || file.write(
+  zip.addEntry("_rels/workbook.xml.rels"_u8,
         "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
         "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">\n"
         +sheets_in_rels+
         "  <Relationship Id=\"rIdS\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"strings.xml\"/>\n"
         "  <Relationship Id=\"rIdY\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>\n"
-        "</Relationships>\n"
-        ) < 0) {
-    Log::error() << "cannot write file: " << file.fileName() << " : "
-                 << file.errorString();
-    return _success = false;
-  }
-  file.close();
+        "</Relationships>\n"_u8);
 
   // writing .rels relations file
-  file.setFileName(_workdir+"/_rels/.rels");
-  if (!file.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Append)
-      || file.write(
+  zip.addEntry("_rels/.rels"_u8,
         "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
         "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">\n"
         "  <Relationship Id=\"rIdB\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"workbook.xml\"/>\n"
-        "</Relationships>\n"
-        ) < 0) {
-    Log::error() << "cannot write file: " << file.fileName() << " : "
-                 << file.errorString();
-    return _success = false;
-  }
-  file.close();
+        "</Relationships>\n");
 
   // writing content types file
-  file.setFileName(_workdir+"/[Content_Types].xml");
-  if (!file.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Append)
-      || file.write(
+  zip.addEntry("[Content_Types].xml"_u8,
         "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
         "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">\n"
         "  <Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>\n"
@@ -459,25 +537,44 @@ bool XlsxWriter::write(Utf8String filename) {
         +sheets_in_content_types+
         "  <Override PartName=\"/strings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>\n"
         "  <Override PartName=\"/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>\n"
-        "</Types>\n"
-        ) < 0) {
-    Log::error() << "cannot write file: " << file.fileName() << " : "
-                 << file.errorString();
-    return _success = false;
+        "</Types>\n"_u8);
+
+  // writing shared strings, ordered by index
+  QList<const Utf8String *> strings(_strings.size());
+  for (const auto &[string, index]: std::as_const(_strings).asKeyValueRange())
+    strings[index] = &string;
+  zip.beginEntry("strings.xml"_u8);
+  zip.writeEntryData(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\""
+        " count=\""+Utf8String::number(_strings_ref)+"\""
+        " uniqueCount=\""+Utf8String::number(_strings.size())+"\">\n");
+  Utf8String bytes;
+  for (auto string: strings) {
+    bool has_spaces = false;
+    auto s = html_protect(*string, &has_spaces);
+    bytes += (has_spaces ? "<si><t xml:space=\"preserve\">"_u8 : "<si><t>"_u8)
+             +s+"</t></si>\n"_u8;
+    if (bytes.size() >= 65536) {
+      zip.writeEntryData(bytes);
+      bytes.resize(0); // rather than clear(), to keep capacity
+    }
   }
-  file.close();
+  zip.writeEntryData(bytes+"</sst>\n"_u8);
+  zip.endEntry();
 
-  // zip
-  QProcess zip;
-  if (!filename.startsWith('/'))
-    filename = Utf8String(QDir::currentPath())+"/"+filename;
-  zip.setWorkingDirectory(_workdir);
-  zip.start("zip", { "-rX6qm", filename, "." });
-  while (zip.state() != QProcess::NotRunning)
-    zip.waitForFinished();
-  if (zip.exitStatus() != QProcess::NormalExit || zip.exitCode() != 0) {
+  // copying already deflated sheets
+  for (auto sheet: std::as_const(_sheets)) {
+    zip.addDeflatedEntry(
+          "sheet"+Utf8String::number(sheet->_index)+".xml", sheet->_file,
+          sheet->_deflater->crc32(), sheet->_deflater->uncompressedSize());
+    sheet->_file->close();
+  }
+
+  // closing archive
+  if (!zip.finish() || !archive.commit()) {
     Log::error() << "cannot write spreadsheet archive: " << filename << " : "
-                 << zip.exitCode();
+                 << archive.errorString();
     return _success = false;
   }
 
@@ -492,6 +589,6 @@ bool XlsxWriter::write(Utf8String filename) {
 }
 
 XlsxWriter::~XlsxWriter() {
-  if (_strings_file)
-    delete _strings_file;
+  qDeleteAll(_sheets);
+  delete _pool;
 }
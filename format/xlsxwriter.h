@@ -14,9 +14,11 @@
 #ifndef XLSXWRITER_H
 #define XLSXWRITER_H
 
-#include <util/utf8string.h>
+#include <util/utf8stringlist.h>
+#include <QDateTime>
+#include <variant>
 
-class QFile;
+class QThreadPool;
 
 /** Write data sequencially in a Open Office XML (OOXML, ECMA-376-5th)
  *  spreadsheet format. Which makes it openable by LibreOffice Calc and
@@ -27,13 +29,33 @@ class QFile;
  *  Keep the less data possible in memory, by writing in temp files as soon as
  *  possible. The only scalability limit is temp disk space and text strings
  *  dictionay memory footprint (which is lightweight if the same strings are
- *  heavily repeated).
+ *  heavily repeated, and bounded by setMaxSharedStrings()).
+ *  Sheets are compressed on worker threads, one batch of rows at a time per
+ *  sheet and in parallel between sheets, while the caller appends next rows.
  */
 class XlsxWriter {
 public:
+  /** Column of strings that are not shared, which is better for high
+   *  cardinality data (ids, free text...). */
+  struct InlineStrings : Utf8StringList {
+    using Utf8StringList::Utf8StringList;
+    InlineStrings(const Utf8StringList &list) : Utf8StringList(list) { }
+  };
+  /** Typed column for appendColumns().
+   *  NaN doubles and invalid dates or times are written as empty cells. */
+  using Column = std::variant<QList<double>, QList<qint64>, QList<bool>,
+  QList<QDateTime>, QList<QDate>, QList<QTime>, Utf8StringList, InlineStrings>;
+
   explicit XlsxWriter(const Utf8String &workdir, bool autoclean = true);
   ~XlsxWriter();
   bool appendRow(const QVariantList &row, const Utf8String &sheet_title = {});
+  /** Append as many rows as the longest column has cells, without per-cell
+   *  QVariant dispatch, rows being encoded on the sheet's worker thread. */
+  bool appendColumns(const QList<Column> &columns,
+                     const Utf8String &sheet_title = {});
+  /** Maximum number of distinct shared strings, further new strings are
+   *  written inline in sheets. Default: 1M. */
+  void setMaxSharedStrings(size_t max) { _max_shared_strings = max; }
   size_t rowCount(const Utf8String &sheet_title = {}) const;
   bool write(Utf8String filename);
   bool failed() const { return !_success; }
@@ -42,7 +64,8 @@ private:
   class Sheet;
   QMap<Utf8String,Sheet*> _sheets;
   QHash<Utf8String,size_t> _strings;
-  QFile *_strings_file = nullptr;
+  size_t _max_shared_strings = 1'000'000;
+  QThreadPool *_pool;
   size_t _strings_ref = 0;
   bool _success = true;
   Utf8String _workdir;
@@ -52,6 +75,7 @@ private:
   /** empty title becomes "Sheet1", longer than 31 char titles are truncated. */
   inline static Utf8String normalized_sheet_name(const Utf8String &sheet_title);
   inline Sheet *get_or_create_sheet(const Utf8String &sheet_title);
+  /** @return SIZE_MAX if string is not shared since the table is full */
   inline size_t share_string(const Utf8String &string, bool incr_counter);
 };
 
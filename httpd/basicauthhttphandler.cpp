@@ -13,10 +13,16 @@
  */
 #include "basicauthhttphandler.h"
 #include <QRegularExpression>
+#include <QMessageAuthenticationCode>
+#include <QRandomGenerator>
 
 BasicAuthHttpHandler::BasicAuthHttpHandler(QObject *parent)
   : HttpHandler(parent), _authenticator(0), _authorizer(0),
-    _authIsMandatory(false), _userIdContextParamName("userid") {
+    _authIsMandatory(false), _userIdContextParamName("userid"),
+    _credentialsCacheKey(32, Qt::Uninitialized), _credentialsCache(4096) {
+  QRandomGenerator::system()->fillRange(
+        reinterpret_cast<quint32*>(_credentialsCacheKey.data()),
+        _credentialsCacheKey.size()/4);
 }
 
 BasicAuthHttpHandler::~BasicAuthHttpHandler() {
@@ -33,25 +39,38 @@ bool BasicAuthHttpHandler::handleRequest(
     HttpRequest &req, HttpResponse &res,
     ParamsProviderMerger &request_context) {
   auto header = req.header("Authorization");
-  QByteArray token;
-  auto m = _headerRe.match(header);
-  if (m.hasMatch()) {
-    token = QByteArray::fromBase64(m.captured(1).toUtf8());
-    m = _tokenRe.match(token);
-    if (m.hasMatch()) {
-      auto login = m.captured(1), password = m.captured(2);
-      if (_authenticator) {
-        auto userId = _authenticator->authenticate(login, password,
-                                                   _authContext);
-        if (!userId.isEmpty()) {
-          if (!_userIdContextParamName.isEmpty())
-            request_context
-                .overrideParamValue(_userIdContextParamName, userId);
-          return true;
-        }
+  QString userId;
+  if (_authenticator && !header.isEmpty()) {
+    QByteArray digest;
+    quint64 generation = 0;
+    if (_credentialsCacheTtl > 0) {
+      digest = QMessageAuthenticationCode::hash(
+            header, _credentialsCacheKey, QCryptographicHash::Sha256);
+      QMutexLocker locker(&_credentialsCacheMutex);
+      generation = _credentialsCacheGeneration;
+      auto credentials = _credentialsCache.object(digest);
+      if (credentials && !credentials->_deadline.hasExpired())
+        userId = credentials->_userId;
+      else if (credentials)
+        _credentialsCache.remove(digest);
+    }
+    if (userId.isEmpty()) {
+      userId = verifyCredentials(header);
+      if (!userId.isEmpty() && !digest.isEmpty()) {
+        QMutexLocker locker(&_credentialsCacheMutex);
+        // not if cache was cleared meanwhile, credentials may have changed
+        if (generation == _credentialsCacheGeneration)
+          _credentialsCache.insert(digest, new VerifiedCredentials {
+                                     userId,
+                                     QDeadlineTimer(_credentialsCacheTtl) });
       }
     }
   }
+  if (!userId.isEmpty()) {
+    if (!_userIdContextParamName.isEmpty())
+      request_context.overrideParamValue(_userIdContextParamName, userId);
+    return true;
+  }
   if (_authIsMandatory
       || (_authorizer && !_authorizer->authorize(
             {}, req.method_name(), req.path(),
@@ -64,8 +83,31 @@ bool BasicAuthHttpHandler::handleRequest(
   return true;
 }
 
+QString BasicAuthHttpHandler::verifyCredentials(
+    const Utf8String &header) const {
+  auto m = _headerRe.match(header);
+  if (!m.hasMatch())
+    return {};
+  auto token = QByteArray::fromBase64(m.captured(1).toUtf8());
+  m = _tokenRe.match(token);
+  if (!m.hasMatch())
+    return {};
+  return _authenticator->authenticate(m.captured(1), m.captured(2),
+                                      _authContext);
+}
+
 void BasicAuthHttpHandler::setAuthenticator(Authenticator *authenticator) {
+  if (_authenticator)
+    disconnect(_authenticator, &Authenticator::changed,
+               this, &BasicAuthHttpHandler::clearCredentialsCache);
   _authenticator = authenticator;
+  // direct connection: cache must not be used anymore as soon as credentials
+  // change, whatever thread changes them
+  if (authenticator)
+    connect(authenticator, &Authenticator::changed,
+            this, &BasicAuthHttpHandler::clearCredentialsCache,
+            Qt::DirectConnection);
+  clearCredentialsCache();
 }
 
 void BasicAuthHttpHandler::setAuthorizer(Authorizer *authorizer) {
@@ -75,3 +117,14 @@ void BasicAuthHttpHandler::setAuthorizer(Authorizer *authorizer) {
 void BasicAuthHttpHandler::enableMandatoryAuth(bool mandatory) {
   _authIsMandatory = mandatory;
 }
+
+void BasicAuthHttpHandler::setCredentialsCacheTtl(int ms) {
+  _credentialsCacheTtl = ms;
+  clearCredentialsCache();
+}
+
+void BasicAuthHttpHandler::clearCredentialsCache() {
+  QMutexLocker locker(&_credentialsCacheMutex);
+  _credentialsCache.clear();
+  ++_credentialsCacheGeneration;
+}
@@ -17,6 +17,9 @@
 #include "httphandler.h"
 #include "auth/authenticator.h"
 #include "auth/authorizer.h"
+#include <QCache>
+#include <QDeadlineTimer>
+#include <QMutex>
 
 /** Handler for HTTP Basic authentication scheme.
  * Check for Authorization header, challenge login/password against an
@@ -36,6 +39,12 @@
  *
  * In all other cases the pipeline will continue (and authorization check of
  * authenticated users is up to the following handlers).
+ *
+ * Successfully verified Authorization headers are kept for a short time (see
+ * setCredentialsCacheTtl()) so that slow password hashes are not computed on
+ * every request. Only a HMAC-SHA256 of the header, with a random key, is
+ * kept, never the password. The cache is cleared whenever the Authenticator
+ * emits changed().
  */
 class LIBP6CORESHARED_EXPORT BasicAuthHttpHandler : public HttpHandler {
   Q_OBJECT
@@ -45,6 +54,15 @@ class LIBP6CORESHARED_EXPORT BasicAuthHttpHandler : public HttpHandler {
   bool _authIsMandatory;
   QByteArray _realm, _userIdContextParamName;
   ParamSet _authContext;
+  struct VerifiedCredentials {
+    QString _userId;
+    QDeadlineTimer _deadline;
+  };
+  QByteArray _credentialsCacheKey; // random HMAC key
+  QCache<QByteArray,VerifiedCredentials> _credentialsCache;
+  QMutex _credentialsCacheMutex;
+  quint64 _credentialsCacheGeneration = 0; // incremented by clear
+  int _credentialsCacheTtl = 60'000;
 
 public:
   explicit BasicAuthHttpHandler(QObject *parent = 0);
@@ -59,6 +77,7 @@ public:
   void setRealm(const QByteArray &realm) {
     _realm = realm;
     _authContext.insert("realm"_u8, realm);
+    clearCredentialsCache();
   }
   /** Define which param name will be used to set the (principal) user id in
    * HttpRequestContext. Default is "userid". Null or empty string disable
@@ -66,12 +85,21 @@ public:
   void setUserIdContextParamName(const QByteArray &name) {
     _userIdContextParamName = name;
   }
+  /** How long, in ms, a verified Authorization header is trusted without
+   * calling the Authenticator again. 0 disables the cache.
+   * Default: 60000 (1 minute). */
+  void setCredentialsCacheTtl(int ms);
 
 public slots:
   /** If no or bad basic auth, request auth (HTTP 401) and stop pipeline
    * (handRequest() returns false).
    * Otherwise let the page be served with no userId in HttpRequestContext. */
   void enableMandatoryAuth(bool mandatory = true);
+  /** This method is thread-safe */
+  void clearCredentialsCache();
+
+private:
+  inline QString verifyCredentials(const Utf8String &header) const;
 };
 
 #endif // BASICAUTHHTTPHANDLER_H
@@ -14,28 +14,104 @@
 #include "graphvizimagehttphandler.h"
 #include "httpd/httpworker.h"
 #include "log/log.h"
+#include <QThreadPool>
+#include <QCryptographicHash>
+#include <QDeadlineTimer>
+
+static QByteArray computeEtag(
+    const Utf8String &source, GraphvizRenderer::Layout layout,
+    GraphvizRenderer::Format format) {
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  hash.addData(GraphvizRenderer::layoutAsString(layout)+" "
+               +GraphvizRenderer::formatAsString(format)+" ");
+  hash.addData(source);
+  return "\""+hash.result().toHex()+"\"";
+}
 
 GraphvizImageHttpHandler::GraphvizImageHttpHandler(
     QObject *parent, Layout layout, Format format)
   : ImageHttpHandler(parent), _layout(layout), _format(format),
-    _renderingNeeded(false) {
+    _contentType(GraphvizRenderer::mime_type(format)),
+    _renderingNeeded(false), _renderingInProgress(false),
+    _backgroundRendering(false) {
+}
+
+GraphvizImageHttpHandler::~GraphvizImageHttpHandler() {
+  QMutexLocker ml(&_mutex);
+  _renderingNeeded = false;
+  while (_renderingInProgress)
+    _renderingFinished.wait(&_mutex);
 }
 
 QByteArray GraphvizImageHttpHandler::imageData(
-    HttpRequest &req, ParamsProviderMerger &context, int timeoutMillis) {
+    HttpRequest &, ParamsProviderMerger &, int timeoutMillis,
+    QByteArray *etag) {
   QMutexLocker ml(&_mutex);
-  if (!_renderingNeeded)
-    return _data;
-  if (_source.isEmpty()) {
-    _data.clear();
-    _renderingNeeded = false;
-    return _data;
+  QDeadlineTimer deadline(timeoutMillis);
+  forever {
+    if (_renderingNeeded && !_renderingInProgress && !_backgroundRendering) {
+      _renderingInProgress = true;
+      render(&ml, timeoutMillis);
+      _renderingInProgress = false;
+      _renderingFinished.wakeAll();
+    }
+    // wait for rendering in progress, unless in background mode with an
+    // already rendered image
+    if (!_renderingInProgress || (_backgroundRendering && !_etag.isNull())
+        || !_renderingFinished.wait(&_mutex, deadline)) {
+      if (etag) // empty but not null if none yet, to prevent etag() fallback
+        *etag = _etag.isNull() ? QByteArray("") : _etag;
+      return _data;
+    }
   }
-  auto gvr = new GraphvizRenderer(req.worker(), _format, timeoutMillis);
-  _data = gvr->run(context, _source);
-  gvr->deleteLater();
+}
+
+bool GraphvizImageHttpHandler::render(
+    QMutexLocker<QMutex> *ml, int timeoutMillis) {
   _renderingNeeded = false;
-  return _data;
+  auto source = _source;
+  auto layout = _layout;
+  auto format = _format;
+  ml->unlock();
+  QByteArray data;
+  bool success = true;
+  if (!source.isEmpty()) {
+    GraphvizRenderer renderer(layout, format, timeoutMillis);
+    data = renderer.run(source);
+    success = !renderer.failed();
+  }
+  ml->relock();
+  // keep last good image, if any, rather than replacing it with an error
+  if (!success && !_etag.isEmpty())
+    return false;
+  _data = data;
+  // an error output is served until a good image is rendered, but with an
+  // empty (not null) etag so that it is neither tagged nor ever answered 304
+  _etag = success ? computeEtag(source, layout, format) : QByteArray("");
+  return true;
+}
+
+void GraphvizImageHttpHandler::renderingNeeded() {
+  _renderingNeeded = true;
+  if (!_backgroundRendering || _renderingInProgress)
+    return; // will be rendered on demand or after current rendering
+  _renderingInProgress = true;
+  QThreadPool::globalInstance()->start([this]() {
+    QMutexLocker ml(&_mutex);
+    forever {
+      bool changed = false;
+      while (_renderingNeeded && _backgroundRendering)
+        changed |= render(
+              &ml, IMAGEHTTPHANDLER_DEFAULT_ONDEMAND_RENDERING_TIMEOUT);
+      if (!changed)
+        break;
+      ml.unlock();
+      emit contentChanged();
+      ml.relock();
+    }
+    _renderingInProgress = false;
+    _renderingFinished.wakeAll();
+  });
 }
 
 QByteArray GraphvizImageHttpHandler::contentType(
@@ -56,21 +132,34 @@ QByteArray GraphvizImageHttpHandler::source(
   return _source;
 }
 
+QByteArray GraphvizImageHttpHandler::etag(
+    HttpRequest&, ParamsProviderMerger&) const {
+  QMutexLocker ml(&_mutex);
+  return _etag;
+}
+
 void GraphvizImageHttpHandler::setSource(const QByteArray &source) {
   QMutexLocker ml(&_mutex);
   _source = source;
-  _renderingNeeded = true;
+  renderingNeeded();
 }
 
 void GraphvizImageHttpHandler::setLayout(Layout layout) {
   QMutexLocker ml(&_mutex);
   _layout = layout;
-  _renderingNeeded = true;
+  renderingNeeded();
 }
 
 void GraphvizImageHttpHandler::setFormat(Format format) {
   QMutexLocker ml(&_mutex);
   _format = format;
   _contentType = GraphvizRenderer::mime_type(format);
-  _renderingNeeded = true;
+  renderingNeeded();
+}
+
+void GraphvizImageHttpHandler::enableBackgroundRendering(bool enabled) {
+  QMutexLocker ml(&_mutex);
+  _backgroundRendering = enabled;
+  if (enabled && _renderingNeeded)
+    renderingNeeded();
 }
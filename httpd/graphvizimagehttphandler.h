@@ -17,8 +17,27 @@
 #include "imagehttphandler.h"
 #include "format/graphvizrenderer.h"
 #include <QMutex>
+#include <QWaitCondition>
 #include <QProcess>
 
+/** Serve an image rendered from graphviz source, using GraphvizRenderer.
+ *
+ * By default, rendering is done on demand, by the first request following a
+ * source (or layout or format) change, concurrent requests waiting for it.
+ * With background rendering enabled, setSource() triggers rendering on a
+ * worker thread and requests never wait for it (but the very first one):
+ * they are served the last good image meanwhile (stale-while-revalidate).
+ * In both cases, if the source changes several times during a rendering,
+ * only the last one is rendered afterward.
+ *
+ * An ETag is computed from source, layout and format, so that clients can
+ * send conditional requests. A failed rendering never replaces a good image,
+ * and if there is none yet, its error output is served without ETag.
+ *
+ * Since the rendered image is shared by every request, rendering never
+ * depends on request context: on demand and background renderings are
+ * performed the same way, from source, layout and format only.
+ */
 class LIBP6CORESHARED_EXPORT GraphvizImageHttpHandler
     : public ImageHttpHandler {
   Q_OBJECT
@@ -34,31 +53,48 @@ private:
   Layout _layout;
   Format _format;
   Utf8String _source, _contentType;
-  bool _renderingNeeded;
+  bool _renderingNeeded, _renderingInProgress, _backgroundRendering;
   mutable QMutex _mutex;
-  QByteArray _data;
+  QWaitCondition _renderingFinished;
+  QByteArray _data, _etag;
 
 public:
   explicit GraphvizImageHttpHandler(
       QObject *parent = 0, Layout layout = Dot, Format format = Svg);
+  ~GraphvizImageHttpHandler();
   QByteArray imageData(
       HttpRequest &req, ParamsProviderMerger &params, int timeoutMillis
-      = IMAGEHTTPHANDLER_DEFAULT_ONDEMAND_RENDERING_TIMEOUT) override;
+      = IMAGEHTTPHANDLER_DEFAULT_ONDEMAND_RENDERING_TIMEOUT,
+      QByteArray *etag = nullptr) override;
   QByteArray contentType(HttpRequest &req,
                          ParamsProviderMerger &context) const override;
   QByteArray contentEncoding(
     HttpRequest &req, ParamsProviderMerger &context) const override;
   QByteArray source(
     HttpRequest &req, ParamsProviderMerger &context) const override;
+  QByteArray etag(
+    HttpRequest &req, ParamsProviderMerger &context) const override;
   Layout layout() const { return _layout; }
   void setLayout(Layout layout);
   Format format() const { return _format; }
   void setFormat(Format format);
+  /** Render in background as soon as source, layout or format change instead
+   * of on demand, and serve last good image meanwhile.
+   * Default: false */
+  void enableBackgroundRendering(bool enabled = true);
 
 public slots:
   /** Set new graphviz-format source and, if refresh strategy is OnChange,
    * trigger image layout processing */
   void setSource(const QByteArray &source);
+
+private:
+  /** Render current source, with _mutex locked by ml but during actual
+   * rendering.
+   * @return false if rendering failed and last good image was kept */
+  bool render(QMutexLocker<QMutex> *ml, int timeoutMillis);
+  /** Trigger rendering, called with _mutex locked. */
+  void renderingNeeded();
 };
 
 #endif // GRAPHVIZIMAGEHTTPHANDLER_H
@@ -13,7 +13,7 @@
  */
 #include "httpcommon.h"
 #include "httpworker.h"
-#include "util/radixtree.h"
+#include "util/frozenradixtree.h"
 #include "util/containerutils.h"
 #include "format/stringutils.h"
 #include <QHostAddress>
@@ -77,8 +77,8 @@ static QMap<HttpRequest::HttpMethod,Utf8String> _method_to_text {
   { HttpRequest::ANY, "ANY" },
 };
 
-static RadixTree<HttpRequest::HttpMethod> _method_from_text =
-    RadixTree<HttpRequest::HttpMethod>::reversed(_method_to_text);
+static FrozenRadixTree<HttpRequest::HttpMethod> _method_from_text {
+  RadixTree<HttpRequest::HttpMethod>::reversed(_method_to_text) };
 
 QSet<HttpRequest::HttpMethod> HttpRequest::_well_known_methods {
   HttpRequest::HEAD, HttpRequest::GET, HttpRequest::POST, HttpRequest::PUT,
@@ -100,15 +100,16 @@ HttpRequest::HttpMethod HttpRequest::method_from_text(const Utf8String &name) {
   return _method_from_text.value(name, NONE);
 }
 
-bool HttpRequest::parse_and_add_header(Utf8String rawHeader) {
+bool HttpRequest::parse_and_add_header(Utf8StringView rawHeader) {
   if (!d)
     return false;
-  int i = rawHeader.indexOf(':');
+  auto i = rawHeader.indexOf(':');
   if (i == -1)
     return false;
   // TODO support multi-line headers
-  auto key = rawHeader.left(i).trimmed().toInternetHeaderCase();
-  auto value = rawHeader.right(rawHeader.size()-i-1).trimmed();
+  // only key and value are copied, trimming and slicing are done on views
+  auto key = rawHeader.left(i).trimmed().toUtf8().toInternetHeaderCase();
+  auto value = rawHeader.sliced(i+1).trimmed().toUtf8();
   //qDebug() << "header:" << rawHeader << key << value;
   d->_headers.insert(key, value);
   if (key == "Cookie"_u8)
@@ -16,6 +16,7 @@
 
 #include "libp6core_global.h"
 #include "util/paramset.h"
+#include "util/utf8stringview.h"
 #include <QAbstractSocket>
 #include <QUrlQuery>
 
@@ -66,7 +67,7 @@ public:
     return _well_known_methods; }
   [[nodiscard]] static Utf8StringSet well_known_method_names() {
     return _well_known_method_names; }
-  [[nodiscard]] bool parse_and_add_header(Utf8String rawHeader);
+  [[nodiscard]] bool parse_and_add_header(Utf8StringView rawHeader);
   /** Value associated to a request header.
    * If the header is found several time, last value is returned. */
   [[nodiscard]] Utf8String header(
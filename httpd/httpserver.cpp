@@ -15,7 +15,7 @@
 #include "httpworker.h"
 #include "log/log.h"
 #include "pipelinehttphandler.h"
-#include "util/radixtree.h"
+#include "util/frozenradixtree.h"
 #include <QMutexLocker>
 #include <QThread>
 #include <QMetaObject>
@@ -122,13 +122,16 @@ bool HttpServer::listen(QHostAddress address, quint16 port) {
   return success;
 }
 
-static RadixTree<HttpServer::LogPolicy> _logPoliciesFromText {
+static RadixTree<HttpServer::LogPolicy> _logPoliciesTree {
   { "LogDisabled", HttpServer::LogDisabled },
   { "LogErrorHits", HttpServer::LogErrorHits },
   { "LogAllHits", HttpServer::LogAllHits },
 };
 
-static auto _logPoliciesToText = _logPoliciesFromText.toReversedUtf8Map();
+static auto _logPoliciesToText = _logPoliciesTree.toReversedUtf8Map();
+
+static FrozenRadixTree<HttpServer::LogPolicy> _logPoliciesFromText {
+  _logPoliciesTree };
 
 Utf8String HttpServer::logPolicyAsText(LogPolicy policy) {
   return _logPoliciesToText.value(policy, "LogDisabled"_u8);
@@ -56,7 +56,8 @@ void HttpWorker::handleConnection(int socketDescriptor) {
     // emit error(_socket->error());
   }
   socket->setReadBufferSize(MAXIMUM_LINE_SIZE+2);
-  Utf8StringList args;
+  Utf8String request_line;
+  QList<Utf8StringView> args; // views on request_line
   HttpRequest req(socket, this);
   HttpResponse res(socket);
   ParamsProviderMerger request_context;
@@ -79,26 +80,26 @@ void HttpWorker::handleConnection(int socketDescriptor) {
               "starting with: "+line.left(200));
     [[unlikely]] goto finally;
   }
-  line = line.trimmed();
-  args = line.split(' ');
+  request_line = line.trimmed();
+  args = Utf8StringView(request_line).split(' ');
   if (args.size() != 3) {
     sendError(out, "400 Bad request line",
-              "starting with: "+line.left(200));
+              "starting with: "+request_line.left(200));
     goto finally;
   }
-  method = HttpRequest::method_from_text(args[0]);
+  method = HttpRequest::method_from_text(args[0].toUtf8());
   req.set_method(method);
   if (method == HttpRequest::HEAD) {
     res.disable_body_output();
   } else if (method == HttpRequest::NONE
              || method == HttpRequest::ANY) {
     sendError(out, "405 Method not allowed",
-              "starting with: "+args[0].left(200));
+              "starting with: "+args[0].left(200).toUtf8());
     [[unlikely]] goto finally;
   }
   if (!args[2].startsWith("HTTP/")) {
     sendError(out, "400 Bad request protocol",
-              "starting with: "+args[2].left(200));
+              "starting with: "+args[2].left(200).toUtf8());
     [[unlikely]] goto finally;
   }
   for (;;) {
@@ -129,7 +130,7 @@ void HttpWorker::handleConnection(int socketDescriptor) {
     }
     //qDebug() << "a7";
   }
-  uri = args[1];
+  uri = args[1].toUtf8();
   // replacing + with space in URI since this cannot be done in HttpRequest
   // unless QUrl implements a full HTML form encoding (including + for space)
   // in addition to current QUrl::FullyDecoded
@@ -28,7 +28,6 @@ bool ImageHttpHandler::acceptRequest(HttpRequest &req) {
 
 bool ImageHttpHandler::handleRequest(HttpRequest &req, HttpResponse &res,
                                      ParamsProviderMerger &request_context) {
-  // TODO handle HTTP/304
   // LATER content type and content should be retrieve at once atomicaly
   // LATER pass params from request
   if (handleCORS(req, res))
@@ -37,7 +36,24 @@ bool ImageHttpHandler::handleRequest(HttpRequest &req, HttpResponse &res,
   auto contentEncoding = this->contentEncoding(req, request_context);
   if (!contentEncoding.isEmpty())
     res.set_header("Content-Encoding"_u8, contentEncoding);
-  QByteArray data = imageData(req, request_context);
+  QByteArray etag;
+  QByteArray data = imageData(
+        req, request_context,
+        IMAGEHTTPHANDLER_DEFAULT_ONDEMAND_RENDERING_TIMEOUT, &etag);
+  if (etag.isNull())
+    etag = this->etag(req, request_context);
+  if (!etag.isEmpty()) {
+    res.set_header("ETag"_u8, etag);
+    for (auto tag: req.header("If-None-Match"_u8).split(',')) {
+      tag = tag.trimmed();
+      if (tag.startsWith("W/"))
+        tag = tag.mid(2);
+      if (tag == etag || tag == "*") {
+        res.set_status(HttpResponse::HTTP_Not_Modified);
+        return true;
+      }
+    }
+  }
   res.set_content_length(data.size());
   if (req.method() != HttpRequest::HEAD)
     res.output()->write(data);
@@ -49,13 +65,18 @@ QByteArray ImageHttpHandler::source(
   return {};
 }
 
+QByteArray ImageHttpHandler::etag(
+    HttpRequest &, ParamsProviderMerger &) const {
+  return {};
+}
+
 QByteArray ImageHttpHandler::contentEncoding(
   HttpRequest&, ParamsProviderMerger &) const {
   return {};
 }
 
 QByteArray ImageHttpHandler::imageData(
-  HttpRequest&, ParamsProviderMerger &, int) {
+  HttpRequest&, ParamsProviderMerger &, int, QByteArray *) {
   return {};
 }
 
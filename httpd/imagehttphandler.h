@@ -35,10 +35,14 @@ public:
   /** This method must be thread-safe for the same reasons than
    * handleRequest()
    * @param timeoutMillis maximum acceptable time if the image rendering is
-   *   performed on demand */
+   *   performed on demand
+   * @param etag if not null, set to the entity tag of the returned image,
+   *   read atomically with it, or left untouched if the implementation does
+   *   not support it (then handleRequest() falls back to etag()) */
   virtual QByteArray imageData(
       HttpRequest &req, ParamsProviderMerger &request_context,
-      int timeoutMillis = IMAGEHTTPHANDLER_DEFAULT_ONDEMAND_RENDERING_TIMEOUT)
+      int timeoutMillis = IMAGEHTTPHANDLER_DEFAULT_ONDEMAND_RENDERING_TIMEOUT,
+      QByteArray *etag = nullptr)
   = 0;
   /** This method must be thread-safe for the same reasons than
    * handleRequest() */
@@ -55,6 +59,16 @@ public:
    * handleRequest() */
   virtual QByteArray source(
     HttpRequest &req, ParamsProviderMerger &request_context) const;
+  /** Return an entity tag identifying the image last returned by imageData(),
+   * if any, e.g. a hash of its source, enabling clients conditional requests
+   * (If-None-Match, answered with HTTP/304).
+   * Only used when imageData() does not set its etag parameter, since the
+   * image may have changed in between.
+   * Default: {}
+   * This method must be thread-safe for the same reasons than
+   * handleRequest() */
+  virtual QByteArray etag(
+    HttpRequest &req, ParamsProviderMerger &request_context) const;
   // LATER sourceMimeType and imageMimeType
 
 signals:
@@ -0,0 +1,57 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tableexporthttphandler.h"
+#include "log/log.h"
+
+TableExportHttpHandler::TableExportHttpHandler(
+    const QByteArray &urlPathPrefix, AbstractTextFormatter *formatter,
+    const QByteArray &contentType, QObject *parent)
+  : HttpHandler(parent), _urlPathPrefix(urlPathPrefix),
+    _contentType(contentType), _formatter(formatter) {
+}
+
+TableExportHttpHandler::~TableExportHttpHandler() {
+  delete _formatter;
+}
+
+bool TableExportHttpHandler::acceptRequest(HttpRequest &req) {
+  return _urlPathPrefix.isEmpty() || req.path().startsWith(_urlPathPrefix);
+}
+
+bool TableExportHttpHandler::handleRequest(
+    HttpRequest &req, HttpResponse &res,
+    ParamsProviderMerger &request_context) {
+  if (handleCORS(req, res))
+    return true;
+  res.set_content_type(_contentType);
+  if (req.method() == HttpRequest::HEAD)
+    return true;
+  // no content length: the connection is closed at end of response
+  if (!_formatter->writeTable(res.output(), items(req, request_context))) {
+    Log::warning() << "cannot write table to client " << req.path();
+    return false;
+  }
+  return true;
+}
+
+SharedUiItemList TableExportHttpHandler::items(
+    HttpRequest &, ParamsProviderMerger &) const {
+  QMutexLocker locker(&_mutex);
+  return _items;
+}
+
+void TableExportHttpHandler::setItems(const SharedUiItemList &items) {
+  QMutexLocker locker(&_mutex);
+  _items = items;
+}
@@ -0,0 +1,57 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TABLEEXPORTHTTPHANDLER_H
+#define TABLEEXPORTHTTPHANDLER_H
+
+#include "httphandler.h"
+#include "format/abstracttextformatter.h"
+#include <QMutex>
+
+/** Serve a list of items as a table (e.g. CSV or HTML), formatted by an
+ * AbstractTextFormatter and streamed to the client row by row, so that
+ * memory usage does not depend on table size.
+ *
+ * Items are a snapshot set through setItems() (SharedUiItem being implicitly
+ * shared, this is cheap and thread-safe), subclasses can override items()
+ * instead, e.g. to filter them according to request params.
+ */
+class LIBP6CORESHARED_EXPORT TableExportHttpHandler : public HttpHandler {
+  Q_OBJECT
+  Q_DISABLE_COPY(TableExportHttpHandler)
+  QByteArray _urlPathPrefix, _contentType;
+  AbstractTextFormatter *_formatter;
+  mutable QMutex _mutex;
+  SharedUiItemList _items;
+
+public:
+  /** Takes ownership of formatter, which must not be modified afterward. */
+  TableExportHttpHandler(
+      const QByteArray &urlPathPrefix, AbstractTextFormatter *formatter,
+      const QByteArray &contentType, QObject *parent = 0);
+  ~TableExportHttpHandler();
+  bool acceptRequest(HttpRequest &req) override;
+  bool handleRequest(HttpRequest &req, HttpResponse &res,
+                     ParamsProviderMerger &request_context) override;
+  /** This method must be thread-safe for the same reasons than
+   * handleRequest().
+   * Default: last list set by setItems() */
+  virtual SharedUiItemList items(
+      HttpRequest &req, ParamsProviderMerger &request_context) const;
+
+public slots:
+  /** This method is thread-safe */
+  void setItems(const SharedUiItemList &items);
+};
+
+#endif // TABLEEXPORTHTTPHANDLER_H
@@ -83,27 +83,30 @@ void TemplatingHttpHandler::applyTemplateFile(
   buf.open(QIODevice::WriteOnly);
   IOUtils::copy(&buf, file);
   buf.close();
-  Utf8String input = buf.data();
-  int pos = 0, markupPos;
+  // parsing on views, only markup data that are stored or used as keys are
+  // copied
+  Utf8StringView input(buf.data());
+  qsizetype pos = 0, markupPos;
   while ((markupPos = input.indexOf("<?", pos)) >= 0) {
-    output.append(input.mid(pos, markupPos-pos));
+    output.append(input.data()+pos, markupPos-pos);
     pos = markupPos+2;
     markupPos = input.indexOf("?>", pos);
-    auto markupContent = input.mid(pos, markupPos-pos).trimmed();
+    auto markupContent = input.mid(pos, markupPos < 0 ? -1 : markupPos-pos)
+                         .trimmed();
     int separatorPos = 0;
     while (markupContent.size() > separatorPos
            && ::isalpha(markupContent.at(separatorPos)))
       ++separatorPos;
     if (separatorPos >= markupContent.size()) {
       Log::warning() << "TemplatingHttpHandler found incorrect markup '"
-                     << markupContent << "'";
+                     << markupContent.toUtf8() << "'";
       output.append('?');
     } else {
       auto markupId = markupContent.left(separatorPos);
       if (markupContent.at(0) == '=') { // syntax: <?=percent_expression?>
         output.append(markupContent.mid(1) % context);
       } else if (markupId == "view") { // syntax: <?view:viewname?>
-        auto markupData = markupContent.mid(separatorPos+1);
+        auto markupData = markupContent.mid(separatorPos+1).toUtf8();
         TextView *view = _views.value(markupData);
         if (view) {
           output.append(view->text(&context, req.url()));
@@ -117,24 +120,25 @@ void TemplatingHttpHandler::applyTemplateFile(
         // rawvalue disables html encoding (escaping special chars and links
         // beautifying
         auto markupParams = markupContent.split_headed_list(separatorPos);
-        auto value = context.paramUtf8(markupParams.value(0))
+        auto value = context.paramUtf8(markupParams.value(0).toUtf8())
                      .toUtf16();
         if (!value.isNull()) {
-          value = markupParams.value(2, value);
+          if (markupParams.size() > 2)
+            value = markupParams[2].toUtf16();
         } else {
           if (markupParams.size() < 2) {
             Log::debug() << "TemplatingHttpHandler did not find value: '"
-                         << markupParams.value(0) << "'";
+                         << markupParams.value(0).toUtf8() << "'";
             [[unlikely]] value = u"?"_s;
           } else {
-            value = markupParams.value(1);
+            value = markupParams[1].toUtf16();
           }
         }
         convertData(&value, markupId == "rawvalue");
         output.append(value.toUtf8());
       } else if (markupId == "include") {
         // syntax: <?include:path_relative_to_current_file_dir?>
-        auto markupData = markupContent.mid(separatorPos+1);
+        auto markupData = markupContent.mid(separatorPos+1).toUtf8();
         auto includePath = file->fileName();
         includePath =
             includePath.left(includePath.lastIndexOf(_directorySeparatorRE));
@@ -151,7 +155,7 @@ void TemplatingHttpHandler::applyTemplateFile(
       } else if (markupId == "override") {
         // syntax: <?override:key:value?>
         auto markupParams = markupContent.split_headed_list(separatorPos);
-        auto key = markupParams.value(0);
+        auto key = markupParams.value(0).toUtf8();
         if (key.isEmpty()) {
           [[unlikely]];
           Log::debug() << "TemplatingHttpHandler cannot set parameter with "
@@ -162,13 +166,13 @@ void TemplatingHttpHandler::applyTemplateFile(
         }
       } else {
         Log::warning() << "TemplatingHttpHandler found unsupported markup: <?"
-                       << markupContent << "?>";
+                       << markupContent.toUtf8() << "?>";
         [[unlikely]] output.append('?');
       }
     }
     pos = markupPos+2;
   }
-  output.append(input.right(input.size()-pos));
+  output.append(input.data()+pos, input.size()-pos);
 }
 
 TemplatingHttpHandler *TemplatingHttpHandler::addView(TextView *view) {
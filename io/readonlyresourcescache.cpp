@@ -17,107 +17,193 @@
 #include <QNetworkReply>
 #include <QThread>
 #include <QTimer>
+#include <QFileInfo>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <limits>
 
 static QRegularExpression _startsWithValidUrlSchemeRE {
   "^[a-zA-Z][a-zA-Z0-9+.-]+:" };
 
+static QRegularExpression _cacheControlDirectiveRE {
+  "^\\s*([a-z-]+)\\s*(?:=\\s*\"?([0-9]+)\"?)?\\s*$" };
+
+/** local file path if pathOrUrl is a path or a file: url, or a null string */
+static QString localFilePath(const QString &pathOrUrl) {
+  if (!_startsWithValidUrlSchemeRE.match(pathOrUrl).hasMatch())
+    return pathOrUrl;
+  if (!pathOrUrl.startsWith("file:", Qt::CaseInsensitive))
+    return {};
+  QUrl url(pathOrUrl);
+  return url.isLocalFile() ? url.toLocalFile() : QString{};
+}
+
+static inline qint64 cost(const QString &pathOrUrl, const QByteArray &data) {
+  return pathOrUrl.size()*2+data.size();
+}
+
+/** Running fetch, shared with the threads waiting for its result, which is
+ * also given to them when it is not cacheable. */
+struct ReadOnlyResourcesCache::Fetching {
+  QWaitCondition _finished;
+  Resource _resource;
+  bool _done = false;
+};
+
 ReadOnlyResourcesCache::ReadOnlyResourcesCache(QObject *parent) :
-  QObject(parent), _nam(new QNetworkAccessManager(this)),
+  QObject(parent), _size(0), _maxSize(64*1024*1024),
+  _nam(new QNetworkAccessManager(this)),
   _defaultMaxAge(60), _defaultMaxStale(3600), _defaultNegativeMaxAge(60),
   _defaultRequestTimeout(30),
-  _shouldHonorHttpCacheMaxAge(true), _shouldHonorHttpCacheMaxStale(true) {
+  _shouldHonorHttpCacheMaxAge(true),
+  _shouldHonorHttpCacheStaleWhileRevalidate(true) {
   connect(_nam, &QNetworkAccessManager::finished,
           this, &ReadOnlyResourcesCache::requestFinished);
 }
 
 QByteArray ReadOnlyResourcesCache::fetchResource(
     QString pathOrUrl, qint32 waitForMsecs, QString *errorString) {
+  auto path = localFilePath(pathOrUrl);
+  if (!path.isNull())
+    return fetchLocalFile(pathOrUrl, path, errorString);
   QByteArray resource = fetchResourceFromCache(pathOrUrl);
-  //qDebug() << "ReadOnlyResourcesCache::fetchResource" << pathOrUrl
-  //         << waitForMsecs << !!errorString;
-  //qDebug().noquote() << asDebugString();
   if (!resource.isNull()) {
     // LATER increment cache hit stats
+    if (errorString)
+      errorString->clear();
     return resource;
   }
-  // LATER true asynchronous process rather than polling
-  // especialy because current behaviour is different depending on the thread
-  // - really blocking if not executed by owner thread, hence not depending
-  //   on calling code being reentrant
-  // - calling QCoreApplication::processEvents() during wait if executed by
-  //   owner thread, hence requiring reentrant caller code but supporting
-  //   processing QNetworkAccessManager signals callbacks on the same event
-  //   loop
-  BlockingTimer timer(
-        waitForMsecs, 100,
-        [this, pathOrUrl]() {
-    QMutexLocker ml(&_mutex);
-    return _staleTimestamp.value(pathOrUrl)
-        >= QDateTime::currentMSecsSinceEpoch();
-  }, QThread::currentThread() == thread());
-  timer.wait();
-  resource = fetchResourceFromCache(pathOrUrl, false);
+  QMutexLocker ml(&_mutex);
+  if (auto fetching = _fetching.value(pathOrUrl); fetching) {
+    if (QThread::currentThread() == thread()) {
+      // replies are processed by owner thread event loop, hence polling and
+      // calling QCoreApplication::processEvents() rather than blocking
+      ml.unlock();
+      BlockingTimer timer(
+            waitForMsecs, 100,
+            [this, fetching]() {
+        QMutexLocker ml(&_mutex);
+        return fetching->_done;
+      }, true);
+      timer.wait();
+      ml.relock();
+    } else {
+      QDeadlineTimer deadline(waitForMsecs);
+      while (!fetching->_done)
+        if (!fetching->_finished.wait(&_mutex, deadline))
+          break;
+    }
+    if (fetching->_done) {
+      // fetch result, even if it was not cacheable or already expired
+      if (errorString)
+        *errorString = fetching->_resource._errorString;
+      return fetching->_resource._data;
+    }
+  }
   // LATER increment cache hit or miss stats
-  if (errorString)
-    *errorString = _errorStrings.value(pathOrUrl);
-  //qDebug() << "threads:" << QThread::currentThread() << thread()
-  //         << _nam->thread();
-  //qDebug() << "return:" << resource.size();
-  //qDebug().noquote() << asDebugString();
+  auto it = _resources.find(pathOrUrl);
+  if (it != _resources.end()
+      && it->_staleUntil > QDateTime::currentMSecsSinceEpoch()) {
+    touch(&*it);
+    resource = it->_data;
+    if (errorString)
+      *errorString = it->_errorString;
+  } else if (errorString) {
+    *errorString = _fetching.contains(pathOrUrl)
+        ? QStringLiteral("Still fetching...") : QString{};
+  }
   return resource;
 }
 
 QByteArray ReadOnlyResourcesCache::fetchResourceFromCache(
     QString pathOrUrl, bool triggerAsyncFetchingIfNotFound) {
+  auto path = localFilePath(pathOrUrl);
+  if (!path.isNull())
+    return fetchLocalFile(pathOrUrl, path, nullptr);
   qint64 now = QDateTime::currentMSecsSinceEpoch();
   QByteArray resource;
   QMutexLocker ml(&_mutex);
-  if (_staleTimestamp.value(pathOrUrl) >= now) {
-    resource = _resources.value(pathOrUrl);
-    if (triggerAsyncFetchingIfNotFound
-        && _ageTimestamp.value(pathOrUrl) <= now) {
-      ml.unlock();
-      QMetaObject::invokeMethod(this, [this,pathOrUrl]() {
-          planResourceFetching(pathOrUrl);
-        });
-    }
-  } else {
-    _resources.remove(pathOrUrl);
-    _staleTimestamp.remove(pathOrUrl);
-    _ageTimestamp.remove(pathOrUrl);
-    if (triggerAsyncFetchingIfNotFound) {
-      ml.unlock();
-      QMetaObject::invokeMethod(this, [this,pathOrUrl]() {
-          planResourceFetching(pathOrUrl);
-        });
+  auto it = _resources.find(pathOrUrl);
+  if (it != _resources.end()) {
+    if (it->_staleUntil > now) {
+      resource = it->_data;
+      touch(&*it);
+      if (it->_freshUntil > now)
+        return resource;
+      // stale: serve it while refreshing
+    } else {
+      remove(it);
     }
   }
+  if (triggerAsyncFetchingIfNotFound)
+    planResourceFetching(pathOrUrl);
   return resource;
 }
 
-void ReadOnlyResourcesCache::planResourceFetching(QString pathOrUrl) {
+QByteArray ReadOnlyResourcesCache::fetchLocalFile(
+    QString pathOrUrl, QString path, QString *errorString) {
+  QFileInfo info(path);
+  auto lastModified = info.lastModified();
+  auto fileSize = info.size();
   QMutexLocker ml(&_mutex);
+  auto it = _resources.find(pathOrUrl);
+  if (it != _resources.end() && !it->_data.isNull()
+      && it->_lastModified == lastModified && it->_fileSize == fileSize) {
+    touch(&*it);
+    if (errorString)
+      errorString->clear();
+    return it->_data;
+  }
+  ml.unlock();
+  QFile file(path);
+  if (!info.isFile() || !file.open(QIODevice::ReadOnly)) {
+    if (errorString)
+      *errorString = info.exists() ? file.errorString()
+                                   : "file not found: "+path;
+    return {};
+  }
+  Resource resource;
+  resource._data = file.readAll();
+  if (resource._data.isNull())
+    resource._data = ""; // empty but not null
+  resource._freshUntil = resource._staleUntil =
+      std::numeric_limits<qint64>::max();
+  resource._lastModified = lastModified;
+  resource._fileSize = fileSize;
+  ml.relock();
+  insert(pathOrUrl, resource);
+  if (errorString)
+    errorString->clear();
+  return resource._data;
+}
+
+void ReadOnlyResourcesCache::planResourceFetching(QString pathOrUrl) {
   if (_fetching.contains(pathOrUrl))
     return;
-  QString realUrl = _startsWithValidUrlSchemeRE.match(pathOrUrl).hasMatch()
-      ? pathOrUrl : "file://"+pathOrUrl;
-  QUrl url(realUrl);
-  QNetworkRequest request(url);
+  _fetching.insert(pathOrUrl, std::make_shared<Fetching>());
+  // always queued: the mutex is locked and the fetch may end synchronously
+  QMetaObject::invokeMethod(this, [this,pathOrUrl]() {
+      startResourceFetching(pathOrUrl);
+    }, Qt::QueuedConnection);
+}
+
+void ReadOnlyResourcesCache::startResourceFetching(QString pathOrUrl) {
+  QNetworkRequest request(QUrl{pathOrUrl}); // never a local file
   request.setAttribute(QNetworkRequest::User, pathOrUrl);
   // LATER parametrize follow redirect features
-  QNetworkRequest nr;
   request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
                        QNetworkRequest::NoLessSafeRedirectPolicy);
   request.setMaximumRedirectsAllowed(5);
   QNetworkReply *reply = _nam->get(request);
-  //Log::fatal() << "ReadOnlyResourceCache::planResourceFetching " << pathOrUrl;
-  //qDebug() << "reply:" << reply->thread() << reply->parent();
-  if (!reply)
+  if (!reply) {
+    Resource resource;
+    resource._errorString = QStringLiteral("cannot start fetching");
+    QMutexLocker ml(&_mutex);
+    fetchingFinished(pathOrUrl, resource);
     return;
+  }
   QTimer::singleShot(_defaultRequestTimeout*1000, reply, &QNetworkReply::abort);
   // LATER set a maximum data size
-  _fetching.insert(pathOrUrl);
-  _errorStrings.insert(pathOrUrl, QStringLiteral("Still fetching..."));
 }
 
 void ReadOnlyResourcesCache::requestFinished(QNetworkReply *reply) {
@@ -125,63 +211,128 @@ void ReadOnlyResourcesCache::requestFinished(QNetworkReply *reply) {
     return;
   QString pathOrUrl = reply->request().attribute(QNetworkRequest::User)
       .toString();
-  //qDebug() << "ReadOnlyResourceCache::requestFinished" << pathOrUrl
-  //         << reply->errorString();
-  //Log::fatal() << "ReadOnlyResourceCache::requestFinished " << pathOrUrl << " "
-  //             << reply->errorString();
+  qint64 maxAge = _defaultMaxAge, maxStale = _defaultMaxStale;
+  bool noCache = false, noStore = false;
+  auto cacheControl = reply->rawHeader("Cache-Control").toLower();
+  for (const auto &directive: QString::fromLatin1(cacheControl).split(',')) {
+    auto match = _cacheControlDirectiveRE.match(directive);
+    if (!match.hasMatch())
+      continue;
+    auto name = match.captured(1);
+    auto value = match.captured(2).toLongLong();
+    if (_shouldHonorHttpCacheMaxAge) {
+      if (name == "max-age")
+        maxAge = value;
+      else if (name == "no-cache")
+        noCache = true;
+      else if (name == "no-store")
+        noStore = true;
+    }
+    if (_shouldHonorHttpCacheStaleWhileRevalidate
+        && name == "stale-while-revalidate")
+      maxStale = value;
+  }
+  if (noCache || noStore) // whatever the directives order
+    maxAge = maxStale = 0;
   qint64 now = QDateTime::currentMSecsSinceEpoch();
-  QByteArray resource = reply->readAll();
-  QMutexLocker ml(&_mutex);
-  _fetching.remove(pathOrUrl);
+  Resource resource;
   if (reply->error() == QNetworkReply::NoError) {
-    _resources.insert(pathOrUrl, resource);
-    // LATER implement Cache-Control: max-age
-    _ageTimestamp.insert(pathOrUrl, now+_defaultMaxAge*1000);
-    // LATER implement Cache-Control: max-stale
-    _staleTimestamp.insert(pathOrUrl, now+_defaultMaxStale*1000);
-    _errorStrings.remove(pathOrUrl);
+    resource._data = reply->readAll();
+    if (resource._data.isNull())
+      resource._data = ""; // empty but not null
+    resource._freshUntil = now+maxAge*1000;
+    resource._staleUntil = resource._freshUntil+maxStale*1000;
   } else {
-    _resources.remove(pathOrUrl);
-    _ageTimestamp.insert(pathOrUrl, now+_defaultNegativeMaxAge*1000);
-    _staleTimestamp.insert(pathOrUrl, now+_defaultNegativeMaxAge*1000);
     // LATER enrich errorString, with e.g. HTTP status
-    _errorStrings.insert(pathOrUrl, reply->errorString());
-    // LATER plan another fetch on certains conditions (e.g. last failures)
+    resource._errorString = reply->errorString();
   }
   reply->deleteLater();
+  QMutexLocker ml(&_mutex);
+  fetchingFinished(pathOrUrl, resource, !noStore);
+}
+
+void ReadOnlyResourcesCache::fetchingFinished(
+    QString pathOrUrl, Resource resource, bool cacheable) {
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  if (resource._data.isNull()) {
+    auto it = _resources.find(pathOrUrl);
+    if (it != _resources.end() && !it->_data.isNull()
+        && it->_staleUntil > now) {
+      // failed refresh: keep serving stale resource
+      resource._data = it->_data;
+      resource._staleUntil = it->_staleUntil;
+    } else {
+      resource._staleUntil = now+_defaultNegativeMaxAge*1000;
+    }
+    resource._freshUntil = now+_defaultNegativeMaxAge*1000;
+    // LATER plan another fetch on certains conditions (e.g. last failures)
+  }
+  if (cacheable) {
+    insert(pathOrUrl, resource);
+  } else if (auto it = _resources.find(pathOrUrl); it != _resources.end()) {
+    remove(it); // former version must not be served anymore either
+  }
+  if (auto fetching = _fetching.take(pathOrUrl); fetching) {
+    fetching->_resource = resource;
+    fetching->_done = true;
+    fetching->_finished.wakeAll();
+  }
+}
+
+void ReadOnlyResourcesCache::insert(QString pathOrUrl, Resource resource) {
+  auto it = _resources.find(pathOrUrl);
+  if (it != _resources.end())
+    remove(it);
+  resource._lru = _lru.insert(_lru.begin(), pathOrUrl);
+  _size += cost(pathOrUrl, resource._data);
+  _resources.insert(pathOrUrl, resource);
+  evict();
+}
+
+void ReadOnlyResourcesCache::remove(QHash<QString,Resource>::iterator it) {
+  _size -= cost(it.key(), it->_data);
+  _lru.erase(it->_lru);
+  _resources.erase(it);
+}
+
+void ReadOnlyResourcesCache::evict() {
+  // always keep most recent one, so that its fetcher can read it
+  while (_size > _maxSize && _lru.size() > 1)
+    remove(_resources.find(_lru.back()));
+}
+
+void ReadOnlyResourcesCache::setMaxSize(qint64 bytes) {
+  QMutexLocker ml(&_mutex);
+  _maxSize = bytes;
+  evict();
 }
 
 void ReadOnlyResourcesCache::clear() {
   QMutexLocker ml(&_mutex);
   _resources.clear();
-  _ageTimestamp.clear();
-  _staleTimestamp.clear();
-  // LATER clear _errorStrings but for "Still fetching..." ones
+  _lru.clear();
+  _size = 0;
 }
 
 QString ReadOnlyResourcesCache::asDebugString() {
   QMutexLocker ml(&_mutex);
   QString s;
-  s += "ReadOnlyResourcesCache {\n  resources: {\n";
-  for (const auto &key: _resources.keys())
-    s += "    " + key + ": " + QString::number(_resources.value(key).size())
-        + "\n";
-  s += "  }\n  age: {\n";
-  for (const auto &key: _ageTimestamp.keys())
-    s += "    " + key + ": "
-      + QDateTime::fromMSecsSinceEpoch(_ageTimestamp.value(key)).toString()
-      + "\n";
-  s += "  }\n  stale: {\n";
-  for (const auto &key: _staleTimestamp.keys())
-    s += "    " + key + ": "
-      + QDateTime::fromMSecsSinceEpoch(_staleTimestamp.value(key)).toString()
-      + "\n";
+  s += "ReadOnlyResourcesCache {\n  size: " + QString::number(_size) + "/"
+      + QString::number(_maxSize) + "\n  resources: {\n";
+  for (const auto &key: _lru) {
+    const auto &resource = _resources[key];
+    s += "    " + key + ": " + QString::number(resource._data.size())
+        + " fresh until: "
+        + QDateTime::fromMSecsSinceEpoch(resource._freshUntil).toString()
+        + " stale until: "
+        + QDateTime::fromMSecsSinceEpoch(resource._staleUntil).toString();
+    if (!resource._errorString.isEmpty())
+      s += " error: " + resource._errorString;
+    s += "\n";
+  }
   s += "  }\n  fetching: {\n";
-  for (const auto &key: _fetching)
+  for (const auto &key: _fetching.keys())
     s += "    " + key + "\n";
-  s += "  }\n  errorstrings: {\n";
-  for (const auto &key: _errorStrings.keys())
-    s += "    " + key + ": " + _errorStrings.value(key) + "\n";
-  s += "}\n";
+  s += "  }\n}\n";
   return s;
 }
@@ -17,33 +17,61 @@
 #include "libp6core_global.h"
 #include <QObject>
 #include <QMutex>
+#include <QDateTime>
 #include "util/utf8stringset.h"
+#include <list>
+#include <memory>
 
 class QNetworkAccessManager;
 class QNetworkReply;
+class QWaitCondition;
 
-// LATER provide a mean to set maximum cache size
-// LATER implement max-age and max-stale for real
 // LATER provide an exec: url scheme binded to QProcess (not enabled by default)
 // LATER have a way to force refresh (such as HTTP request's max-age=0)
 
 /** Local cache for read-only resources, being them remote (http, ftp...) or
  * local (file).
+ *
+ * Remote resources are fresh for max-age seconds, then stale for max-stale
+ * more seconds during which they are still served while being refreshed in
+ * background, then expired. Both durations are taken from HTTP response
+ * Cache-Control header (max-age, stale-while-revalidate) when present,
+ * otherwise from defaults. no-cache makes the resource expire at once and
+ * no-store prevents it from being cached at all: in both cases it is only
+ * given to the callers that waited for this fetch. Failures are cached for
+ * negative max-age seconds, and a failed refresh keeps serving the stale
+ * resource.
+ *
+ * Concurrent fetches of the same resource are coalesced into one request,
+ * waiters are woken up as soon as it finishes and get its result.
+ *
+ * Local files (paths or file: urls) are read directly by the calling thread
+ * and validated against their modification time and size on every access.
+ *
+ * Cached resources are evicted least recently used first when their total
+ * size exceeds maximum cache size.
  */
 class LIBP6CORESHARED_EXPORT ReadOnlyResourcesCache : public QObject {
   Q_OBJECT
+  struct Resource {
+    QByteArray _data; // null on error
+    QString _errorString;
+    qint64 _freshUntil = 0, _staleUntil = 0; // ms since 1970
+    QDateTime _lastModified; // local files only
+    qint64 _fileSize = -1; // local files only
+    std::list<QString>::iterator _lru;
+  };
+  struct Fetching;
   QMutex _mutex;
-  QHash<QString,QByteArray> _resources;
-  QHash<QString,qint64> _ageTimestamp;
-  QHash<QString,qint64> _staleTimestamp;
-  QSet<QString> _fetching;
-  QHash<QString,QString> _errorStrings;
+  QHash<QString,Resource> _resources;
+  std::list<QString> _lru; // most recently used first
+  QHash<QString,std::shared_ptr<Fetching>> _fetching;
+  qint64 _size, _maxSize; // in bytes
   QNetworkAccessManager *_nam;
-  // LATER make these actual parameters
   qint64 _defaultMaxAge, _defaultMaxStale, _defaultNegativeMaxAge; // in seconds
   qint64 _defaultRequestTimeout;
   bool _shouldHonorHttpCacheMaxAge; // Cache-Control: max-age=42
-  bool _shouldHonorHttpCacheMaxStale; // Cache-Control: max-stale=42
+  bool _shouldHonorHttpCacheStaleWhileRevalidate; // stale-while-revalidate=42
 
 public:
   ReadOnlyResourcesCache(QObject *parent = 0);
@@ -54,7 +82,8 @@ public:
                            QString *errorString = 0);
   QByteArray fetchResource(QString pathOrUrl, QString *errorString = 0) {
     return fetchResource(pathOrUrl, 1000, errorString); }
-  /** Fetch a resource, if and only if it is available in cache */
+  /** Fetch a resource, if and only if it is available in cache (or is a
+   * local file) */
   QByteArray fetchResourceFromCache(
       QString pathOrUrl, bool triggerAsyncFetchingIfNotFound = true);
   /** Clear the cache, but doesn't cancel currently running fetching requests.
@@ -62,18 +91,40 @@ public:
   void clear();
   /** defaults to: 60 (1') */
   void setDefaultMaxAge(qint64 secs) { _defaultMaxAge = secs; }
-  /** defaults to: 3600 (60') */
+  /** time after max-age during which a resource is served while being
+   * refreshed, defaults to: 3600 (60') */
   void setDefaultStaleAge(qint64 secs) { _defaultMaxStale = secs; }
   /** defaults to: 60 (1') */
   void setDefaultNegativeMaxAge(qint64 secs) { _defaultNegativeMaxAge = secs; }
+  /** total size of cached resources, defaults to: 64 MB
+   * the last fetched resource is always kept, even if larger */
+  void setMaxSize(qint64 bytes);
+  /** locks the mutex */
+  QString asDebugString();
 
 private:
-  /** must be called by owner thread (because of qnam), locks the mutex */
+  /** locks the mutex */
+  QByteArray fetchLocalFile(QString pathOrUrl, QString path,
+                            QString *errorString);
+  /** must be called with mutex locked, coalesces with running fetching */
   void planResourceFetching(QString pathOrUrl);
+  /** must be called by owner thread (because of qnam) */
+  void startResourceFetching(QString pathOrUrl);
   /** locks the mutex */
   void requestFinished(QNetworkReply *reply);
-  /** locks the mutex*/
-  QString asDebugString();
+  /** must be called with mutex locked
+   * @param cacheable false for Cache-Control: no-store */
+  void fetchingFinished(QString pathOrUrl, Resource resource,
+                        bool cacheable = true);
+  /** must be called with mutex locked */
+  void insert(QString pathOrUrl, Resource resource);
+  /** must be called with mutex locked */
+  void remove(QHash<QString,Resource>::iterator it);
+  /** must be called with mutex locked */
+  inline void touch(Resource *resource) {
+    _lru.splice(_lru.begin(), _lru, resource->_lru); }
+  /** must be called with mutex locked */
+  void evict();
 };
 
 #endif // READONLYRESOURCECACHE_H
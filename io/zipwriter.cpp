@@ -0,0 +1,313 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "zipwriter.h"
+#include <QtEndian>
+#include <zlib.h>
+
+namespace {
+
+const qsizetype BufferSize = 65536;
+const qint64 MaxSize = 0xffff'ffff; // without zip64 extensions
+const quint32 LocalHeaderSignature = 0x0403'4b50;
+const quint32 DataDescriptorSignature = 0x0807'4b50;
+const quint32 CentralHeaderSignature = 0x0201'4b50;
+const quint32 EndOfCentralDirectorySignature = 0x0605'4b50;
+const quint16 VersionNeeded = 20; // 2.0: deflate and directories
+const quint16 DataDescriptorFlag = 1 << 3;
+const quint16 Utf8NamesFlag = 1 << 11;
+
+inline void append16(QByteArray *ba, quint16 i) {
+  char le[2];
+  qToLittleEndian(i, le);
+  ba->append(le, 2);
+}
+
+inline void append32(QByteArray *ba, quint32 i) {
+  char le[4];
+  qToLittleEndian(i, le);
+  ba->append(le, 4);
+}
+
+/** zlib uses uInt for sizes, hence processing large data by pieces */
+inline quint32 crc32_update(quint32 crc, QByteArrayView data) {
+  auto p = reinterpret_cast<const Bytef *>(data.data());
+  for (qsizetype n = data.size(); n > 0; ) {
+    uInt len = static_cast<uInt>(qMin<qsizetype>(n, 1 << 30));
+    crc = ::crc32(crc, p, len);
+    p += len;
+    n -= len;
+  }
+  return crc;
+}
+
+} // unnamed namespace
+
+ZipDeflater::ZipDeflater(QIODevice *output, int level)
+  : _output(output), _stream(new z_stream{}),
+    _buffer(BufferSize, Qt::Uninitialized) {
+  // negative window bits: raw deflate stream, without zlib header and trailer
+  if (!output || deflateInit2(_stream, level, Z_DEFLATED, -MAX_WBITS, 8,
+                              Z_DEFAULT_STRATEGY) != Z_OK) {
+    delete _stream;
+    _stream = nullptr;
+    _success = false;
+    return;
+  }
+  _stream->next_out = reinterpret_cast<Bytef *>(_buffer.data());
+  _stream->avail_out = BufferSize;
+}
+
+ZipDeflater::~ZipDeflater() {
+  if (_stream) {
+    deflateEnd(_stream);
+    delete _stream;
+  }
+}
+
+bool ZipDeflater::write(QByteArrayView data) {
+  if (!_success || _finished)
+    return false;
+  _crc32 = crc32_update(_crc32, data);
+  _uncompressedSize += data.size();
+  auto p = reinterpret_cast<const Bytef *>(data.data());
+  for (qsizetype n = data.size(); n > 0; ) {
+    uInt len = static_cast<uInt>(qMin<qsizetype>(n, 1 << 30));
+    _stream->next_in = const_cast<Bytef *>(p);
+    _stream->avail_in = len;
+    if (!compress(Z_NO_FLUSH))
+      return false;
+    p += len;
+    n -= len;
+  }
+  return true;
+}
+
+bool ZipDeflater::finish() {
+  if (!_success || _finished)
+    return _success;
+  _finished = true;
+  _stream->next_in = nullptr;
+  _stream->avail_in = 0;
+  return compress(Z_FINISH) && flushBuffer();
+}
+
+bool ZipDeflater::compress(int flush) {
+  forever {
+    if (::deflate(_stream, flush) == Z_STREAM_ERROR)
+      return _success = false;
+    if (_stream->avail_out) // input consumed or, on Z_FINISH, stream ended
+      return true;
+    if (!flushBuffer())
+      return false;
+  }
+}
+
+bool ZipDeflater::flushBuffer() {
+  qsizetype n = BufferSize-_stream->avail_out;
+  if (n && _output->write(_buffer.constData(), n) != n)
+    return _success = false;
+  _compressedSize += n;
+  _stream->next_out = reinterpret_cast<Bytef *>(_buffer.data());
+  _stream->avail_out = BufferSize;
+  return true;
+}
+
+ZipWriter::ZipWriter(QIODevice *output, QDateTime timestamp)
+  : _output(output), _success(output) {
+  if (!timestamp.isValid())
+    timestamp = QDateTime::currentDateTime();
+  auto date = timestamp.date();
+  auto time = timestamp.time();
+  if (date.year() < 1980) { // dos epoch
+    date = QDate(1980, 1, 1);
+    time = QTime(0, 0);
+  }
+  _dosDate = ((date.year()-1980) << 9) | (date.month() << 5) | date.day();
+  _dosTime = (time.hour() << 11) | (time.minute() << 5) | (time.second()/2);
+}
+
+ZipWriter::~ZipWriter() {
+  delete _deflater;
+}
+
+bool ZipWriter::writeBytes(QByteArrayView data) {
+  if (_output->write(data.data(), data.size()) != data.size())
+    return _success = false;
+  _offset += data.size();
+  return true;
+}
+
+bool ZipWriter::startEntry(const Utf8String &name, Method method) {
+  if (!_success || _inEntry || name.size() > 0xffff || _offset > MaxSize)
+    return _success = false;
+  Entry entry { name, method, Utf8NamesFlag };
+  if (_output->isSequential())
+    entry._flags |= DataDescriptorFlag;
+  entry._offset = _offset;
+  _entries.append(entry);
+  QByteArray ba;
+  ba.reserve(30+name.size());
+  append32(&ba, LocalHeaderSignature);
+  append16(&ba, VersionNeeded);
+  append16(&ba, entry._flags);
+  append16(&ba, method);
+  append16(&ba, _dosTime);
+  append16(&ba, _dosDate);
+  append32(&ba, 0); // crc32, sizes: patched or in data descriptor
+  append32(&ba, 0);
+  append32(&ba, 0);
+  append16(&ba, name.size());
+  append16(&ba, 0); // extra field length
+  ba.append(name);
+  return writeBytes(ba);
+}
+
+bool ZipWriter::beginEntry(const Utf8String &name, Method method, int level) {
+  if (!startEntry(name, method))
+    return false;
+  _inEntry = true;
+  if (method == Deflated) {
+    _deflater = new ZipDeflater(_output, level);
+    if (_deflater->failed())
+      return _success = false;
+  } else {
+    _storedCrc32 = 0;
+    _storedSize = 0;
+  }
+  return true;
+}
+
+bool ZipWriter::writeEntryData(QByteArrayView data) {
+  if (!_success || !_inEntry)
+    return _success = false;
+  if (_deflater)
+    return _deflater->write(data) ? true : _success = false;
+  _storedCrc32 = crc32_update(_storedCrc32, data);
+  _storedSize += data.size();
+  return writeBytes(data);
+}
+
+bool ZipWriter::endEntry() {
+  if (!_success || !_inEntry)
+    return _success = false;
+  _inEntry = false;
+  if (!_deflater)
+    return completeEntry(&_entries.last(), _storedCrc32, _storedSize,
+                         _storedSize);
+  if (!_deflater->finish())
+    return _success = false;
+  _offset += _deflater->compressedSize();
+  auto crc32 = _deflater->crc32();
+  auto compressedSize = _deflater->compressedSize();
+  auto uncompressedSize = _deflater->uncompressedSize();
+  delete _deflater;
+  _deflater = nullptr;
+  return completeEntry(&_entries.last(), crc32, compressedSize,
+                       uncompressedSize);
+}
+
+bool ZipWriter::addEntry(const Utf8String &name, QByteArrayView data,
+                         Method method, int level) {
+  return beginEntry(name, method, level) && writeEntryData(data)
+      && endEntry();
+}
+
+bool ZipWriter::addDeflatedEntry(const Utf8String &name, QIODevice *input,
+                                 quint32 crc32, qint64 uncompressedSize) {
+  if (!input || !startEntry(name, Deflated))
+    return _success = false;
+  QByteArray buffer(BufferSize, Qt::Uninitialized);
+  qint64 compressedSize = 0;
+  forever {
+    auto n = input->read(buffer.data(), buffer.size());
+    if (n < 0)
+      return _success = false;
+    if (n == 0)
+      break;
+    if (!writeBytes(QByteArrayView(buffer.constData(), n)))
+      return false;
+    compressedSize += n;
+  }
+  return completeEntry(&_entries.last(), crc32, compressedSize,
+                       uncompressedSize);
+}
+
+bool ZipWriter::completeEntry(Entry *entry, quint32 crc32,
+                              qint64 compressedSize, qint64 uncompressedSize) {
+  if (compressedSize > MaxSize || uncompressedSize > MaxSize)
+    return _success = false;
+  entry->_crc32 = crc32;
+  entry->_compressedSize = compressedSize;
+  entry->_uncompressedSize = uncompressedSize;
+  QByteArray ba;
+  if (entry->_flags & DataDescriptorFlag) {
+    append32(&ba, DataDescriptorSignature);
+    append32(&ba, crc32);
+    append32(&ba, compressedSize);
+    append32(&ba, uncompressedSize);
+    return writeBytes(ba);
+  }
+  // patching local header crc32 and sizes fields (at offset 14)
+  auto end = _output->pos();
+  auto header = end-(_offset-entry->_offset);
+  append32(&ba, crc32);
+  append32(&ba, compressedSize);
+  append32(&ba, uncompressedSize);
+  if (!_output->seek(header+14)
+      || _output->write(ba) != ba.size()
+      || !_output->seek(end))
+    return _success = false;
+  return true;
+}
+
+bool ZipWriter::finish() {
+  if (_inEntry)
+    endEntry();
+  if (!_success || _entries.size() > 0xffff || _offset > MaxSize)
+    return _success = false;
+  auto directoryOffset = _offset;
+  QByteArray ba;
+  for (const auto &entry: std::as_const(_entries)) {
+    append32(&ba, CentralHeaderSignature);
+    append16(&ba, VersionNeeded); // version made by: 2.0, ms-dos attributes
+    append16(&ba, VersionNeeded);
+    append16(&ba, entry._flags);
+    append16(&ba, entry._method);
+    append16(&ba, _dosTime);
+    append16(&ba, _dosDate);
+    append32(&ba, entry._crc32);
+    append32(&ba, entry._compressedSize);
+    append32(&ba, entry._uncompressedSize);
+    append16(&ba, entry._name.size());
+    append16(&ba, 0); // extra field length
+    append16(&ba, 0); // comment length
+    append16(&ba, 0); // disk number
+    append16(&ba, 0); // internal attributes
+    append32(&ba, 0); // external attributes
+    append32(&ba, entry._offset);
+    ba.append(entry._name);
+  }
+  auto directorySize = ba.size();
+  if (directoryOffset+directorySize > MaxSize)
+    return _success = false;
+  append32(&ba, EndOfCentralDirectorySignature);
+  append16(&ba, 0); // this disk number
+  append16(&ba, 0); // central directory disk number
+  append16(&ba, _entries.size());
+  append16(&ba, _entries.size());
+  append32(&ba, directorySize);
+  append32(&ba, directoryOffset);
+  append16(&ba, 0); // comment length
+  return writeBytes(ba);
+}
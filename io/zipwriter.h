@@ -0,0 +1,117 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ZIPWRITER_H
+#define ZIPWRITER_H
+
+#include "util/utf8string.h"
+#include <QIODevice>
+#include <QDateTime>
+
+/** Streaming raw deflate (RFC 1951) compressor, writing to a QIODevice as
+ * data is appended and keeping track of what a ZIP entry needs to know about
+ * its data (crc32, sizes).
+ *
+ * Can be used standalone to compress data ahead of
+ * ZipWriter::addDeflatedEntry(), e.g. when several entries are produced in an
+ * interleaved way, as XlsxWriter sheets are.
+ */
+class LIBP6CORESHARED_EXPORT ZipDeflater {
+  QIODevice *_output;
+  struct z_stream_s *_stream;
+  QByteArray _buffer;
+  quint32 _crc32 = 0;
+  qint64 _uncompressedSize = 0, _compressedSize = 0;
+  bool _finished = false, _success = true;
+
+public:
+  /** @param level zlib compression level, 0 (none) to 9 (best) */
+  explicit ZipDeflater(QIODevice *output, int level = 6);
+  ZipDeflater(const ZipDeflater &) = delete;
+  ZipDeflater &operator=(const ZipDeflater &) = delete;
+  ~ZipDeflater();
+  bool write(QByteArrayView data);
+  /** Flush compressor and terminate deflate stream. */
+  bool finish();
+  quint32 crc32() const { return _crc32; }
+  qint64 uncompressedSize() const { return _uncompressedSize; }
+  qint64 compressedSize() const { return _compressedSize; }
+  bool failed() const { return !_success; }
+
+private:
+  inline bool compress(int flush);
+  inline bool flushBuffer();
+};
+
+/** Streaming ZIP archive writer (stored and deflated entries).
+ *
+ * Entries are written one after the other, either all at once (addEntry()),
+ * by appending data (beginEntry(), writeEntryData()..., endEntry()) which is
+ * compressed on the fly, or by copying already deflated data
+ * (addDeflatedEntry()). The central directory is written by finish().
+ *
+ * When output is seekable, local headers are patched with crc and sizes once
+ * an entry is complete, otherwise data descriptors are used.
+ * Names are stored as UTF-8. ZIP64 is not supported, which means that entries
+ * and archive are limited to 4 GB.
+ */
+class LIBP6CORESHARED_EXPORT ZipWriter {
+public:
+  enum Method : quint16 { Stored = 0, Deflated = 8 };
+
+private:
+  struct Entry {
+    Utf8String _name;
+    Method _method;
+    quint16 _flags;
+    quint32 _crc32 = 0, _compressedSize = 0, _uncompressedSize = 0,
+    _offset = 0;
+  };
+  QIODevice *_output;
+  QList<Entry> _entries;
+  qint64 _offset = 0; // bytes written so far
+  quint16 _dosTime, _dosDate;
+  ZipDeflater *_deflater = nullptr; // current entry, if deflated
+  quint32 _storedCrc32 = 0; // current entry, if stored
+  qint64 _storedSize = 0; // current entry, if stored
+  bool _inEntry = false, _success = true;
+
+public:
+  /** @param timestamp modification time of every entry, default: now */
+  explicit ZipWriter(QIODevice *output, QDateTime timestamp = {});
+  ZipWriter(const ZipWriter &) = delete;
+  ZipWriter &operator=(const ZipWriter &) = delete;
+  ~ZipWriter();
+  bool beginEntry(const Utf8String &name, Method method = Deflated,
+                  int level = 6);
+  bool writeEntryData(QByteArrayView data);
+  bool endEntry();
+  /** Convenience method for beginEntry(), writeEntryData(), endEntry(). */
+  bool addEntry(const Utf8String &name, QByteArrayView data,
+                Method method = Deflated, int level = 6);
+  /** Add an entry which data has already been compressed as a raw deflate
+   * stream, e.g. with a ZipDeflater, reading it from input up to its end. */
+  bool addDeflatedEntry(const Utf8String &name, QIODevice *input,
+                        quint32 crc32, qint64 uncompressedSize);
+  /** Write central directory. Output is not closed. */
+  bool finish();
+  bool failed() const { return !_success; }
+
+private:
+  inline bool writeBytes(QByteArrayView data);
+  inline bool startEntry(const Utf8String &name, Method method);
+  inline bool completeEntry(Entry *entry, quint32 crc32, qint64 compressedSize,
+                            qint64 uncompressedSize);
+};
+
+#endif // ZIPWRITER_H
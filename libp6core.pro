@@ -29,6 +29,7 @@ CONFIG(debug,debug|release): BUILD_TYPE=debug
 CONFIG(release,debug|release): BUILD_TYPE=release
 
 DEFINES += LIBP6CORE_LIBRARY
+LIBS += -lz
 exists(/usr/bin/ccache):QMAKE_CXX = \
   CCACHE_SLOPPINESS=pch_defines,time_macros ccache $$QMAKE_CXX
 exists(/usr/bin/ccache):QMAKE_CXXFLAGS += -fdiagnostics-color=always
@@ -64,7 +65,9 @@ PRECOMPILED_HEADER *= \
 
 SOURCES *= \
     eg/entity.cpp \
+    eg/world.cpp \
     format/graphvizparser.cpp \
+    format/graphvizrendercache.cpp \
     format/graphvizrenderer.cpp \
     format/svgwriter.cpp \
     io/opensshcommand.cpp \
@@ -78,6 +81,7 @@ SOURCES *= \
     util/typedvalue.cpp \
     util/typedvaluelist.cpp \
     util/utf8string.cpp \
+    util/utf8kernels.cpp \
     util/utf8stringlist.cpp \
     util/paramsprovider.cpp \
     util/paramset.cpp \
@@ -127,8 +131,10 @@ SOURCES *= \
     log/loggerthread.cpp \
     log/multiplexerlogger.cpp \
     httpd/uploadhttphandler.cpp \
+    httpd/tableexporthttphandler.cpp \
     csv/csvfile.cpp \
     csv/csvfilemodel.cpp \
+    csv/csvreader.cpp \
     modelview/shareduiitemdocumentmanager.cpp \
     modelview/shareduiitemlist.cpp \
     util/paramsprovidermerger.cpp \
@@ -163,13 +169,16 @@ SOURCES *= \
     ostore/objectslistmodel.cpp \
     ostore/sqlobjectsstore.cpp \
     io/directorywatcher.cpp \
+    io/zipwriter.cpp \
     modelview/stringhashmodel.cpp \
     format/jsonformats.cpp \
     modelview/stringlistdiffmodel.cpp
 
 HEADERS *=\
     eg/entity.h \
+    eg/world.h \
     format/graphvizparser.h \
+    format/graphvizrendercache.h \
     format/graphvizrenderer.h \
     format/svgwriter.h \
     io/opensshcommand.h \
@@ -187,8 +196,10 @@ HEADERS *=\
     util/typedvalue.h \
     util/typedvaluelist.h \
     util/utf8string.h \
+    util/utf8kernels.h \
     util/utf8stringlist.h \
     util/utf8stringset.h \
+    util/utf8stringview.h \
     util/paramsprovider.h \
     util/paramset.h \
     util/paramsprovidermerger.h \
@@ -240,8 +251,10 @@ HEADERS *=\
     modelview/shareduiitemstreemodel.h \
     util/relativedatetime.h \
     httpd/uploadhttphandler.h \
+    httpd/tableexporthttphandler.h \
     csv/csvfile.h \
     csv/csvfilemodel.h \
+    csv/csvreader.h \
     modelview/shareduiitemdocumentmanager.h \
     modelview/shareduiitemlist.h \
     thread/atomicvalue.h \
@@ -261,6 +274,8 @@ HEADERS *=\
     io/dummysocket.h \
     util/containerutils.h \
     util/radixtree.h \
+    util/frozenradixtree.h \
+    util/concurrentradixtree.h \
     io/readonlyresourcescache.h \
     format/csvformatter.h \
     format/abstracttextformatter.h \
@@ -279,6 +294,7 @@ HEADERS *=\
     ostore/objectslistmodel.h \
     ostore/sqlobjectsstore.h \
     io/directorywatcher.h \
+    io/zipwriter.h \
     modelview/stringhashmodel.h \  \
     format/jsonformats.h \
     modelview/paramsetmodel.h \
@@ -15,7 +15,7 @@
 #define INCOMINGMESSAGEDISPATCHER_H
 
 #include "message.h"
-#include "util/radixtree.h"
+#include "util/concurrentradixtree.h"
 
 /** Dispatch incoming messages among registred handlers, depending on their
  * root node name. */
@@ -25,15 +25,17 @@ public:
   using MessageHandler = std::function<void(Message)>;
 
 private:
-  RadixTree<MessageHandler> _handlers;
+  ConcurrentRadixTree<MessageHandler> _handlers;
 
 public:
-  /** not thread-safe, must only be called once at process initialization */
+  /** thread-safe, can be called while messages are being dispatched */
   void setHandlers(const RadixTree<MessageHandler> &handlers) {
-    _handlers = handlers; }
+    _handlers.replace(handlers); }
+  /** thread-safe, can be called while messages are being dispatched */
+  void registerHandler(const char *name, MessageHandler handler) {
+    _handlers.insert(name, handler); }
   /** not thread-safe, must only be called by connection handler thread:
-   * actually thread-safe per se (provided setHandlers() is not called
-   * meanwhile) but the called handlers are not thread-safe */
+   * actually thread-safe per se but the called handlers are not thread-safe */
   bool dispatch(Message message);
 };
 
@@ -91,10 +91,10 @@ QList<GenericSharedUiItem> GenericSharedUiItem::fromCsv(
   if (!csvFile)
     return list;
   Utf8StringList section_names;
-  for (Utf8String header: csvFile->headers())
+  for (const Utf8String &header: csvFile->utf8Headers())
     section_names.append(header.toIdentifier());
   for (int i = 0; i < csvFile->rowCount(); ++i) {
-    Utf8StringList row = csvFile->row(i);
+    Utf8StringList row = csvFile->utf8Row(i);
     auto id = row.value(idColumn);
     QVariantList values;
     for (const auto &value: row)
@@ -17,6 +17,36 @@
 
 SharedUiItemDocumentManager::SharedUiItemDocumentManager(QObject *parent)
   : QObject(parent) {
+  // direct connections so that indexes are up to date before any other slot
+  connect(this, &SharedUiItemDocumentManager::itemChanged,
+          this, &SharedUiItemDocumentManager::updateSectionIndexes,
+          Qt::DirectConnection);
+  connect(this, &SharedUiItemDocumentManager::dataReset, this, [this]() {
+    _sectionIndexes.clear();
+  }, Qt::DirectConnection);
+  connect(this, &SharedUiItemDocumentManager::itemChanged, this, [this](
+          const SharedUiItem &new_item, const SharedUiItem &old_item,
+          const Utf8String &qualifier) {
+    if (_changesBatchDepth)
+      _changesBatch.append({ new_item, old_item, qualifier });
+  }, Qt::DirectConnection);
+}
+
+void SharedUiItemDocumentManager::beginChangesBatch(
+    SharedUiItemDocumentTransaction *transaction) {
+  if (!_changesBatchDepth++)
+    beginCommit(transaction);
+}
+
+void SharedUiItemDocumentManager::endChangesBatch(
+    SharedUiItemDocumentTransaction *transaction) {
+  if (--_changesBatchDepth)
+    return;
+  endCommit(transaction);
+  auto changes = std::move(_changesBatch);
+  _changesBatch.clear();
+  if (!changes.isEmpty())
+    emit itemsChanged(changes);
 }
 
 SharedUiItem SharedUiItemDocumentManager::itemById(
@@ -438,13 +468,10 @@ bool SharedUiItemDocumentManager::delayedChecks(
     auto qualifier = oldItem.qualifier();
     for (const ForeignKey &fk: _foreignKeys) {
       if (fk._referenceQualifier == qualifier) {
-        auto oldReferenceId = oldItem.uiString(fk._referenceSection);
-        SharedUiItemList newItems =
-            transaction->itemsByQualifier(qualifier);
-        // LATER optimize this: full scan of reference for each fk is just awful
-        for (const SharedUiItem &newItem: newItems)
-          if (newItem.uiString(fk._referenceSection) == oldReferenceId)
-            goto reference_still_exists;
+        auto oldReferenceId = oldItem.uiUtf8(fk._referenceSection);
+        if (!transaction->itemsBySectionValue(
+              qualifier, fk._referenceSection, oldReferenceId).isEmpty())
+          continue; // reference still exists
         SharedUiItemList sources = transaction->foreignKeySources(
               fk._sourceQualifier, fk._sourceSection, oldItem.id());
         if (!sources.isEmpty()) {
@@ -455,12 +482,50 @@ bool SharedUiItemDocumentManager::delayedChecks(
           return false;
         }
       }
-reference_still_exists:;
     }
   }
   return true;
 }
 
+QList<Utf8String> SharedUiItemDocumentManager::indexedItemIds(
+    const Utf8String &qualifier, int section, const Utf8String &value) const {
+  auto key = qMakePair(qualifier, section);
+  auto it = _sectionIndexes.find(key);
+  if (it == _sectionIndexes.end()) {
+    QMultiHash<Utf8String,Utf8String> index;
+    for (const auto &item: itemsByQualifier(qualifier))
+      index.insert(item.uiUtf8(section), item.id());
+    it = _sectionIndexes.insert(key, index);
+  }
+  return it->values(value);
+}
+
+void SharedUiItemDocumentManager::updateSectionIndexes(
+    const SharedUiItem &new_item, const SharedUiItem &old_item,
+    const Utf8String &qualifier) {
+  for (auto it = _sectionIndexes.begin(); it != _sectionIndexes.end(); ++it) {
+    if (it.key().first != qualifier)
+      continue;
+    int section = it.key().second;
+    if (!old_item.isNull())
+      it->remove(old_item.uiUtf8(section), old_item.id());
+    if (!new_item.isNull())
+      it->insert(new_item.uiUtf8(section), new_item.id());
+  }
+}
+
+void SharedUiItemDocumentManager::beginCommit(
+    SharedUiItemDocumentTransaction *) {
+}
+
+void SharedUiItemDocumentManager::endCommit(
+    SharedUiItemDocumentTransaction *) {
+}
+
+void SharedUiItemDocumentManager::transactionDestroyed(
+    SharedUiItemDocumentTransaction *) {
+}
+
 SharedUiItem SharedUiItemDocumentManager::itemById(
     const Utf8String&, const Utf8String&) const {
   return {};
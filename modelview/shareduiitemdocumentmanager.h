@@ -78,6 +78,11 @@ public:
   };
   Q_DECLARE_FLAGS(TriggerFlags, TriggerFlag)
   Q_FLAGS(TriggerFlags)
+  struct ItemChange {
+    SharedUiItem _new_item, _old_item;
+    Utf8String _qualifier;
+  };
+  using ItemChanges = QList<ItemChange>;
 
 private:
   struct ForeignKey {
@@ -106,6 +111,11 @@ protected:
   QMultiHash<Utf8String,ChangeItemTrigger> _triggersAfterCreate;
   QMultiHash<Utf8String,ChangeItemTrigger> _triggersBeforeDelete;
   QMultiHash<Utf8String,ChangeItemTrigger> _triggersAfterDelete;
+  // reverse indexes: (qualifier,section) -> section value -> ids
+  mutable QHash<QPair<Utf8String,int>,QMultiHash<Utf8String,Utf8String>>
+  _sectionIndexes;
+  int _changesBatchDepth = 0;
+  ItemChanges _changesBatch;
 
   explicit SharedUiItemDocumentManager(QObject *parent = nullptr);
 
@@ -263,6 +273,10 @@ public:
                            const Utf8String &prefix = {}) const {
     return generateNewId(nullptr, qualifier, prefix);
   }
+  /** True while a transaction is being committed (or undone), i.e. while
+   * emitting itemChanged() signals that will be followed by an
+   * itemsChanged() signal. */
+  bool isCommittingChanges() const { return _changesBatchDepth > 0; }
 
 signals:
   /** Emited whenever an item changes.
@@ -283,6 +297,14 @@ signals:
    */
   void itemChanged(const SharedUiItem &new_item, const SharedUiItem &old_item,
                    const Utf8String &qualifier);
+  /** Emited once per committed (or undone) transaction, after every
+   * itemChanged() of the transaction, with the same changes in the same
+   * order.
+   *
+   * Listeners that apply many changes at once (e.g. models) should connect to
+   * this signal and ignore itemChanged() while isCommittingChanges().
+   * @see SharedUiItemsModel::changeItems() */
+  void itemsChanged(const SharedUiItemDocumentManager::ItemChanges &changes);
   /** Emited when all data is reset as a whole, for instance when switching
    * from a document to another one. */
   void dataReset();
@@ -332,6 +354,19 @@ protected:
   virtual void commitChangeItem(
       const SharedUiItem &new_item, const SharedUiItem &old_item,
       const Utf8String &qualifier) = 0;
+  /** Called before the commitChangeItem() calls that commit (or undo) a
+   * transaction, e.g. to group them within a single database transaction.
+   * Default: do nothing. */
+  virtual void beginCommit(SharedUiItemDocumentTransaction *transaction);
+  /** Called after the commitChangeItem() calls that commit (or undo) a
+   * transaction, before itemsChanged() is emited.
+   * Default: do nothing. */
+  virtual void endCommit(SharedUiItemDocumentTransaction *transaction);
+  /** Called when a transaction is destroyed, being it committed or not, e.g.
+   * to discard resources held since prepareChangeItem().
+   * Default: do nothing. */
+  virtual void transactionDestroyed(
+      SharedUiItemDocumentTransaction *transaction);
   // FIXME doc
   void storeItemChange(
       SharedUiItemDocumentTransaction *transaction,
@@ -388,6 +423,19 @@ private:
    * integrity checks. */
   bool delayedChecks(SharedUiItemDocumentTransaction *transaction,
                      QString *errorString);
+  /** Ids of committed items of type qualifier which section value is value,
+   * using a reverse index built on first call for this (qualifier,section)
+   * and then kept up to date by itemChanged() and dataReset() signals.
+   * Used by foreign keys processing instead of full scans. */
+  QList<Utf8String> indexedItemIds(
+      const Utf8String &qualifier, int section, const Utf8String &value) const;
+  void updateSectionIndexes(const SharedUiItem &new_item,
+                            const SharedUiItem &old_item,
+                            const Utf8String &qualifier);
+  /** Call beginCommit() when entering outermost batch. */
+  void beginChangesBatch(SharedUiItemDocumentTransaction *transaction);
+  /** Call endCommit() and emit itemsChanged() when leaving outermost batch. */
+  void endChangesBatch(SharedUiItemDocumentTransaction *transaction);
 
   friend class SharedUiItemDocumentTransaction; // needed for many methods and fields
   friend class SharedUiItemDocumentTransaction::ChangeItemCommand; // needed to call back commitChangeItem()
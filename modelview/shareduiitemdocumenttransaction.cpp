@@ -17,17 +17,28 @@
 void SharedUiItemDocumentTransaction::storeItemChange(
     const SharedUiItem &newItem, const SharedUiItem &oldItem,
     const Utf8String &qualifier) {
-  ChangeItemCommand *command =
-      new ChangeItemCommand(_dm, newItem, oldItem, qualifier, this);
-  switch (childCount()) {
-  case 1:
-    setText(command->text());
-    break;
-  case 2:
-    setText(text()+" and other changes");
-    break;
-  }
   auto oldId = oldItem.id(), newId = newItem.id();
+  // coalesce with previous command on the same item if any
+  auto &lastCommands = _lastCommands[qualifier];
+  auto currentId = oldItem.isNull() ? newId : oldId;
+  ChangeItemCommand *command = lastCommands.value(currentId);
+  ChangeItemCommand change(_dm, newItem, oldItem, qualifier, nullptr);
+  if (command && command->mergeWith(&change)) {
+    lastCommands.remove(currentId);
+    if (childCount() == 1)
+      setText(command->text());
+  } else {
+    command = new ChangeItemCommand(_dm, newItem, oldItem, qualifier, this);
+    switch (childCount()) {
+    case 1:
+      setText(command->text());
+      break;
+    case 2:
+      setText(text()+" and other changes");
+      break;
+    }
+  }
+  lastCommands.insert(newItem.isNull() ? oldId : newId, command);
   auto &changingItems = _changingItems[qualifier];
   if (!oldItem.isNull() && !changingItems.contains(oldId))
     _originalItems[qualifier].insert(oldId, oldItem);
@@ -84,21 +95,23 @@ SharedUiItemList SharedUiItemDocumentTransaction::originalItems() const {
   return SharedUiItem();
 }*/
 
-SharedUiItemList SharedUiItemDocumentTransaction::foreignKeySources(
-    const Utf8String &sourceQualifier, int sourceSection,
-    const Utf8String &referenceId) const {
-  SharedUiItemList sources;
-  auto changingItems = _changingItems.value(sourceQualifier);
-  for (const auto &item: changingItems.values()) {
-    if (item.uiData(sourceSection) == referenceId)
-      sources.append(item);
+SharedUiItemList SharedUiItemDocumentTransaction::itemsBySectionValue(
+    const Utf8String &qualifier, int section, const Utf8String &value) const {
+  SharedUiItemList items;
+  auto changingItems = _changingItems.value(qualifier);
+  for (const auto &item: changingItems) {
+    if (!item.isNull() && item.uiUtf8(section) == value)
+      items.append(item);
   }
-  for (const auto &item: _dm->itemsByQualifier(sourceQualifier)) {
-    if (item.uiData(sourceSection) == referenceId
-        && !changingItems.contains(item.id()))
-      sources.append(item);
+  for (const auto &id: _dm->indexedItemIds(qualifier, section, value)) {
+    if (changingItems.contains(id))
+      continue;
+    auto item = _dm->itemById(qualifier, id);
+    // double check in case some implementation forgot to emit itemChanged()
+    if (!item.isNull() && item.uiUtf8(section) == value)
+      items.append(item);
   }
-  return sources;
+  return items;
 }
 
 bool SharedUiItemDocumentTransaction::changeItemByUiData(
@@ -155,6 +168,27 @@ SharedUiItem SharedUiItemDocumentTransaction::createNewItem(
   }
 }
 
+SharedUiItemDocumentTransaction::~SharedUiItemDocumentTransaction() {
+  if (_dm)
+    _dm->transactionDestroyed(this);
+}
+
+void SharedUiItemDocumentTransaction::redo() {
+  if (!_dm)
+    return;
+  _dm->beginChangesBatch(this);
+  CoreUndoCommand::redo();
+  _dm->endChangesBatch(this);
+}
+
+void SharedUiItemDocumentTransaction::undo() {
+  if (!_dm)
+    return;
+  _dm->beginChangesBatch(this);
+  CoreUndoCommand::undo();
+  _dm->endChangesBatch(this);
+}
+
 Utf8String SharedUiItemDocumentTransaction::generateNewId(
     const Utf8String &qualifier, const Utf8String &prefix) const {
   return _dm->generateNewId(this, qualifier, prefix);
@@ -166,21 +200,28 @@ SharedUiItemDocumentTransaction::ChangeItemCommand::ChangeItemCommand(
     CoreUndoCommand *parent)
   : CoreUndoCommand(parent), _dm(dm), _newItem(newItem), _oldItem(oldItem),
     _qualifier(qualifier)  {
-  if (newItem.isNull())
-    setText("Deleting a "+oldItem.qualifier());
-  else if (oldItem.isNull())
-    setText("Creating a "+newItem.qualifier());
+  updateText();
+}
+
+void SharedUiItemDocumentTransaction::ChangeItemCommand::updateText() {
+  if (_newItem.isNull() && _oldItem.isNull())
+    setText("Nothing to change on a "+_qualifier);
+  else if (_newItem.isNull())
+    setText("Deleting a "+_qualifier);
+  else if (_oldItem.isNull())
+    setText("Creating a "+_qualifier);
   else
-    setText("Changing a "+oldItem.qualifier());
+    setText("Changing a "+_qualifier);
 }
 
 void SharedUiItemDocumentTransaction::ChangeItemCommand::redo() {
-  if (_dm)
+  // both items are null when a creation was merged with a deletion
+  if (_dm && (!_newItem.isNull() || !_oldItem.isNull()))
     _dm->commitChangeItem(_newItem, _oldItem, _qualifier);
 }
 
 void SharedUiItemDocumentTransaction::ChangeItemCommand::undo() {
-  if (_dm)
+  if (_dm && (!_newItem.isNull() || !_oldItem.isNull()))
     _dm->commitChangeItem(_oldItem, _newItem, _qualifier);
 }
 
@@ -190,9 +231,21 @@ int SharedUiItemDocumentTransaction::ChangeItemCommand::id() const {
 
 bool SharedUiItemDocumentTransaction::ChangeItemCommand::mergeWith(
     const CoreUndoCommand *command) {
+  if (!command || command->id() != id())
+    return false;
   const ChangeItemCommand *other =
       static_cast<const ChangeItemCommand *>(command);
-  Q_UNUSED(other)
-  // LATER implement this or find another way to compress commands within a transaction in case the same item is changed several times in chain
-  return false;
+  if (other->_qualifier != _qualifier)
+    return false;
+  // other must start where this one ends
+  if (_newItem.isNull() ? !other->_oldItem.isNull()
+                        : other->_oldItem.id() != _newItem.id())
+    return false;
+  // other must not rename the item
+  if (!other->_oldItem.isNull() && !other->_newItem.isNull()
+      && other->_oldItem.id() != other->_newItem.id())
+    return false;
+  _newItem = other->_newItem;
+  updateText();
+  return true;
 }
@@ -25,7 +25,7 @@ class SharedUiItemDocumentManager;
  * performed within the transaction but not yet commited to the DM. */
 class LIBP6CORESHARED_EXPORT SharedUiItemDocumentTransaction
     : public CoreUndoCommand {
-  SharedUiItemDocumentManager *_dm;
+  QPointer<SharedUiItemDocumentManager> _dm;
   QHash<Utf8String,QHash<Utf8String,SharedUiItem>> _changingItems,
   _originalItems;
 
@@ -46,10 +46,30 @@ public:
     void redo() override;
     void undo() override;
     int	id() const override;
+    /** Merge a following change of the same item into this command, keeping
+     * only the net change (e.g. create then update becomes create, create
+     * then delete becomes nothing).
+     * Changes renaming the item are never merged, since moving them earlier
+     * could conflict with ids used in between. */
     bool mergeWith(const CoreUndoCommand *command) override;
+
+  private:
+    void updateText();
   };
 
+private:
+  // qualifier -> current id (or deleted id) -> command that last touched it
+  QHash<Utf8String,QHash<Utf8String,ChangeItemCommand*>> _lastCommands;
+
+public:
   SharedUiItemDocumentTransaction(SharedUiItemDocumentManager *dm) : _dm(dm) { }
+  ~SharedUiItemDocumentTransaction();
+  /** Commit every change, grouping their notifications.
+   * @see SharedUiItemDocumentManager::itemsChanged() */
+  void redo() override;
+  /** Undo every change, grouping their notifications.
+   * @see SharedUiItemDocumentManager::itemsChanged() */
+  void undo() override;
   SharedUiItem itemById(
       const Utf8String &qualifier, const Utf8String &id) const;
   /** Downcast blindly trusting caller that qualifier implies T */
@@ -75,9 +95,15 @@ public:
     auto list = itemsByQualifier(qualifier);
     return list.isEmpty() ? SharedUiItem{} : list.last();
   }
+  /** Items of type qualifier which section value is value, as seen from
+   * within the transaction. Uses document manager reverse indexes rather than
+   * scanning every item. */
+  SharedUiItemList itemsBySectionValue(
+      const Utf8String &qualifier, int section, const Utf8String &value) const;
   SharedUiItemList foreignKeySources(
       const Utf8String &sourceQualifier, int sourceSection,
-      const Utf8String &referenceId) const;
+      const Utf8String &referenceId) const {
+    return itemsBySectionValue(sourceQualifier, sourceSection, referenceId); }
 
   bool changeItemByUiData(
       const SharedUiItem &oldItem, int section, const QVariant &value,
@@ -143,7 +143,14 @@ void SharedUiItemsModel::setDocumentManager(
   resetData();
   if (_documentManager) {
     connect(_documentManager, &SharedUiItemDocumentManager::itemChanged,
-            this, &SharedUiItemsModel::changeItem);
+            this, [this](const SharedUiItem &newItem,
+            const SharedUiItem &oldItem, const Utf8String &qualifier) {
+      // changes within a transaction will be received by changeItems()
+      if (!_documentManager->isCommittingChanges())
+        changeItem(newItem, oldItem, qualifier);
+    });
+    connect(_documentManager, &SharedUiItemDocumentManager::itemsChanged,
+            this, &SharedUiItemsModel::changeItems);
     connect(_documentManager, &SharedUiItemDocumentManager::dataReset,
             this, &SharedUiItemsModel::resetData);
   }
@@ -212,3 +219,9 @@ void SharedUiItemsModel::insertItemAt(
 void SharedUiItemsModel::changeItem(
     const SharedUiItem &, const SharedUiItem &, const Utf8String &) {
 }
+
+void SharedUiItemsModel::changeItems(
+    const SharedUiItemDocumentManager::ItemChanges &changes) {
+  for (const auto &change: changes)
+    changeItem(change._new_item, change._old_item, change._qualifier);
+}
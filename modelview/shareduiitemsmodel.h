@@ -14,7 +14,7 @@
 #ifndef SHAREDUIITEMSMODEL_H
 #define SHAREDUIITEMSMODEL_H
 
-#include "shareduiitem.h"
+#include "shareduiitemdocumentmanager.h"
 #include <QAbstractItemModel>
 #include <QAbstractProxyModel>
 
@@ -161,6 +161,17 @@ public slots:
   virtual void changeItem(
       const SharedUiItem &newItem, const SharedUiItem &oldItem,
       const Utf8String &qualifier) = 0;
+  /** Operate several changes within this model.
+   *
+   * Default implementation calls changeItem() for each change, subclasses may
+   * process large batches at once, e.g. with a single model reset.
+   *
+   * This slot is connected to SharedUiItemDocumentManager::itemsChanged() by
+   * setDocumentManager(), which then ignores itemChanged() signals while
+   * SharedUiItemDocumentManager::isCommittingChanges().
+   */
+  virtual void changeItems(
+      const SharedUiItemDocumentManager::ItemChanges &changes);
   /** Short for changeItem(newItem, SharedUiItem(), newItem.qualifier()). */
   void createOrUpdateItem(SharedUiItem newItem) {
     changeItem(newItem, SharedUiItem(), newItem.qualifier()); }
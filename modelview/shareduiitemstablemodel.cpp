@@ -19,7 +19,8 @@
 SharedUiItemsTableModel::SharedUiItemsTableModel(QObject *parent)
   : SharedUiItemsModel(parent),
     _defaultInsertionPoint(SharedUiItemsTableModel::LastItem),
-    _maxrows(INT_MAX) {
+    _maxrows(INT_MAX), _rowIndexShift(0), _rowIndexIsValid(false),
+    _rowIndexHasDuplicates(false), _resetThreshold(100), _resetting(false) {
 }
 
 SharedUiItemsTableModel::SharedUiItemsTableModel(
@@ -27,7 +28,8 @@ SharedUiItemsTableModel::SharedUiItemsTableModel(
     QObject *parent)
   : SharedUiItemsModel(parent),
     _defaultInsertionPoint(defaultInsertionPoint),
-    _maxrows(INT_MAX) {
+    _maxrows(INT_MAX), _rowIndexShift(0), _rowIndexIsValid(false),
+    _rowIndexHasDuplicates(false), _resetThreshold(100), _resetting(false) {
   setHeaderDataFromTemplate(templateItem);
 }
 
@@ -51,18 +53,20 @@ void SharedUiItemsTableModel::setItems(const SharedUiItemList &original_items) {
   SharedUiItemList limited_items = original_items;
   qsizetype new_size = limited_items.size(), old_size = _items.size();
   if (new_size > _maxrows) {
-    limited_items.remove(new_size, new_size-_maxrows);
+    limited_items.remove(_maxrows, new_size-_maxrows);
     limited_items.squeeze();
     new_size = _maxrows;
   }
   if (old_size) {
     beginRemoveRows({}, 0, old_size-1);
     _items.clear();
+    invalidateRowIndex();
     endRemoveRows();
   }
   if (new_size) {
     beginInsertRows({}, 0, new_size-1);
     _items = limited_items;
+    invalidateRowIndex();
     endInsertRows();
   }
 }
@@ -71,15 +75,34 @@ void SharedUiItemsTableModel::insertItemAt(const SharedUiItem &newItem,
     int row, const QModelIndex &parent) {
   if (row < 0 || row > rowCount() || parent.isValid())
     return;
-  beginInsertRows(QModelIndex(), row, row);
+  if (!_resetting)
+    beginInsertRows(QModelIndex(), row, row);
   _items.insert(row, newItem);
-  endInsertRows();
+  if (_rowIndexIsValid) {
+    auto id = newItem.qualifiedId();
+    if (_rowIndex.contains(id) || _rowIndexShift == INT_MAX) {
+      invalidateRowIndex(); // duplicate id (first row must win) or overflow
+    } else if (row == _items.size()-1) {
+      _rowIndex.insert(id, row-_rowIndexShift);
+    } else if (row == 0) {
+      ++_rowIndexShift;
+      _rowIndex.insert(id, -_rowIndexShift);
+    } else {
+      invalidateRowIndex();
+    }
+  }
+  if (!_resetting)
+    endInsertRows();
   int toBeRemoved = _items.size() - _maxrows;
   if (toBeRemoved > 0) {
     int deletionPoint = (_defaultInsertionPoint == FirstItem) ? _maxrows : 0;
-    beginRemoveRows(QModelIndex(), deletionPoint, deletionPoint+toBeRemoved-1);
+    if (!_resetting)
+      beginRemoveRows(QModelIndex(), deletionPoint,
+                      deletionPoint+toBeRemoved-1);
+    unindexRows(deletionPoint, deletionPoint+toBeRemoved-1);
     _items.remove(deletionPoint, toBeRemoved);
-    endRemoveRows();
+    if (!_resetting)
+      endRemoveRows();
   }
   //emit itemChanged(item, SharedUiItem());
 }
@@ -90,12 +113,15 @@ bool SharedUiItemsTableModel::removeItems(int first, int last) {
     return false;
   if (last >= rowCount)
     last = rowCount-1;
-  beginRemoveRows(QModelIndex(), first, last);
+  if (!_resetting)
+    beginRemoveRows(QModelIndex(), first, last);
+  unindexRows(first, last);
   while (first <= last--) {
     //emit itemChanged(SharedUiItem(), _items.value(first));
     _items.removeAt(first);
   }
-  endRemoveRows();
+  if (!_resetting)
+    endRemoveRows();
   return true;
 }
 
@@ -138,23 +164,83 @@ void SharedUiItemsTableModel::changeItem(
     } else { // update (incl. rename)
       QModelIndex oldIndex = indexOf(oldItem);
       _items[oldIndex.row()] = newItem;
-      emit dataChanged(index(oldIndex.row(), 0),
-                       index(oldIndex.row(), columnCount()-1));
+      auto oldId = oldItem.qualifiedId(), newId = newItem.qualifiedId();
+      if (_rowIndexIsValid && oldId != newId) { // renamed
+        _rowIndex.remove(oldId);
+        if (_rowIndexHasDuplicates || _rowIndex.contains(newId))
+          invalidateRowIndex();
+        else
+          _rowIndex.insert(newId, oldIndex.row()-_rowIndexShift);
+      }
+      if (!_resetting)
+        emit dataChanged(index(oldIndex.row(), 0),
+                         index(oldIndex.row(), columnCount()-1));
     }
   }
   emit itemChanged(newItem, oldItem);
 }
 
+void SharedUiItemsTableModel::changeItems(
+    const SharedUiItemDocumentManager::ItemChanges &changes) {
+  if (changes.size() < _resetThreshold || _resetting) {
+    SharedUiItemsModel::changeItems(changes);
+    return;
+  }
+  beginResetModel();
+  _resetting = true;
+  SharedUiItemsModel::changeItems(changes);
+  _resetting = false;
+  endResetModel();
+}
+
 QModelIndex SharedUiItemsTableModel::indexOf(
     const Utf8String &qualifiedId) const {
-  // TODO add index to improve lookup performance
-  // see SharedUiItemsTreeModel for index example
-  // don't forget to update index changeItem when id changes (= item renamed)
-  if (!qualifiedId.isNull())
-    for (int row = 0; row < _items.size(); ++row)
-      if (_items[row].qualifiedId() == qualifiedId)
-        return createIndex(row, 0);
-  return QModelIndex();
+  if (qualifiedId.isNull())
+    return QModelIndex();
+  if (!_rowIndexIsValid)
+    rebuildRowIndex();
+  auto it = _rowIndex.constFind(qualifiedId);
+  if (it == _rowIndex.cend())
+    return QModelIndex();
+  int row = *it+_rowIndexShift;
+  if (row < 0 || row >= _items.size()
+      || _items[row].qualifiedId() != qualifiedId) {
+    // should not happen, unless _items has been changed behind our back
+    rebuildRowIndex();
+    it = _rowIndex.constFind(qualifiedId);
+    if (it == _rowIndex.cend())
+      return QModelIndex();
+    row = *it;
+  }
+  return createIndex(row, 0);
+}
+
+void SharedUiItemsTableModel::rebuildRowIndex() const {
+  _rowIndex.clear();
+  _rowIndex.reserve(_items.size());
+  _rowIndexShift = 0;
+  // backward, so that first row wins if some ids are duplicated
+  for (int row = _items.size()-1; row >= 0; --row)
+    _rowIndex.insert(_items[row].qualifiedId(), row);
+  _rowIndexHasDuplicates = _rowIndex.size() < _items.size();
+  _rowIndexIsValid = true;
+}
+
+void SharedUiItemsTableModel::unindexRows(int first, int last) {
+  if (!_rowIndexIsValid)
+    return;
+  // removing a duplicated id may unindex its other rows
+  if ((first != 0 && last != _items.size()-1) || _rowIndexHasDuplicates) {
+    invalidateRowIndex();
+    return;
+  }
+  for (int row = first; row <= last; ++row) {
+    auto it = _rowIndex.find(_items[row].qualifiedId());
+    if (it != _rowIndex.end() && *it+_rowIndexShift == row)
+      _rowIndex.erase(it);
+  }
+  if (first == 0)
+    _rowIndexShift -= last+1;
 }
 
 bool SharedUiItemsTableModel::removeRows(
@@ -32,8 +32,19 @@ public:
 private:
   DefaultInsertionPoint _defaultInsertionPoint;
   int _maxrows;
+  // qualified id -> row - _rowIndexShift, shifting makes inserting or removing
+  // at first row O(1), other structural changes invalidate the whole index
+  mutable QHash<Utf8String,int> _rowIndex;
+  mutable int _rowIndexShift;
+  mutable bool _rowIndexIsValid;
+  // some ids are duplicated, only first row being indexed, so that removing
+  // an indexed id may need indexing another row
+  mutable bool _rowIndexHasDuplicates;
+  int _resetThreshold;
+  bool _resetting; // within changeItems() model reset, hence no row signals
 
 protected:
+  /** Subclasses changing _items directly must call invalidateRowIndex(). */
   SharedUiItemList _items;
 
 public:
@@ -60,6 +71,13 @@ public:
    * "Older" rows are determined as opposite sides from defaultInsertionPoint().
    * Default: INT_MAX */
   void setMaxrows(int maxrows) { _maxrows = maxrows; }
+  int resetThreshold() const { return _resetThreshold; }
+  /** Set minimum number of changes received at once by changeItems() for
+   * them to be processed within a single model reset rather than emitting
+   * signals for every row.
+   * Default: 100 */
+  void setResetThreshold(int resetThreshold) {
+    _resetThreshold = resetThreshold; }
   void sortAndSetItems(const SharedUiItemList &items) {
     setItems(items.sorted()); }
   void insertItemAt(const SharedUiItem &newItem, int row,
@@ -74,6 +92,8 @@ public:
   QModelIndex indexOf(const Utf8String &qualifiedId) const override;
   void changeItem(const SharedUiItem &newItem, const SharedUiItem &oldItem,
                   const Utf8String &qualifier) override;
+  void changeItems(
+      const SharedUiItemDocumentManager::ItemChanges &changes) override;
   bool removeRows(int row, int count,
                   const QModelIndex &parent = QModelIndex()) override;
   Qt::ItemFlags flags(const QModelIndex &index) const override;
@@ -87,7 +107,14 @@ public:
 public slots:
   virtual void setItems(const SharedUiItemList &items);
 
+protected:
+  void invalidateRowIndex() { _rowIndexIsValid = false; }
+
 private:
+  void rebuildRowIndex() const;
+  /** To be called before actually removing rows from _items. */
+  void unindexRows(int first, int last);
+
   // hide functions that cannot work with SharedUiItem paradigm to avoid
   // misunderstanding
   using QAbstractItemModel::insertRows;
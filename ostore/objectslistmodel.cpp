@@ -13,6 +13,7 @@
  */
 #include "objectslistmodel.h"
 #include "format/stringutils.h"
+#include "objectsstore.h"
 #include <QMetaProperty>
 
 ObjectsListModel::ObjectsListModel(
@@ -46,6 +47,8 @@ int ObjectsListModel::rowCount(const QModelIndex &parent) const {
 
 QVariant ObjectsListModel::data(const QModelIndex &index, int role) const {
   QObject *object = _objects.value(index.row());
+  if (!object && _store && index.isValid() && index.row() < _pks.size())
+    object = const_cast<ObjectsListModel*>(this)->loadRow(index.row());
   if (!object || !index.isValid())
     return QVariant();
   if (role == _baseUserRole)
@@ -83,6 +86,89 @@ void ObjectsListModel::append(QList<QObject*> objects) {
   endInsertRows();
 }
 
+bool ObjectsListModel::canFetchMore(const QModelIndex &parent) const {
+  return !parent.isValid() && _store && _store->canFetchMore();
+}
+
+void ObjectsListModel::fetchMore(const QModelIndex &parent) {
+  if (!parent.isValid() && _store)
+    _store->fetchMore();
+}
+
+void ObjectsListModel::setStore(ObjectsStore *store) {
+  beginResetModel();
+  if (_store)
+    disconnect(_store, nullptr, this, nullptr);
+  _objects.clear();
+  _pks.clear();
+  _loadedRows.clear();
+  _store = store;
+  if (store) {
+    connect(store, &ObjectsStore::keysFetched,
+            this, &ObjectsListModel::appendKeys);
+    connect(store, &ObjectsStore::fetched,
+            this, &ObjectsListModel::objectFetched);
+    connect(store, &ObjectsStore::disposed,
+            this, &ObjectsListModel::remove);
+  }
+  endResetModel();
+}
+
+void ObjectsListModel::appendKeys(const QVariantList &pks) {
+  if (pks.isEmpty())
+    return;
+  beginInsertRows(QModelIndex(), _objects.size(),
+                  _objects.size()+pks.size()-1);
+  _objects.resize(_objects.size()+pks.size());
+  _pks.append(pks);
+  endInsertRows();
+}
+
+void ObjectsListModel::objectFetched(QObject *object) {
+  if (_loadingRow >= 0)
+    return; // being loaded by loadRow()
+  int row = _loadedRows.value(object, -1);
+  if (row >= 0) {
+    QModelIndex index = this->index(row);
+    emit dataChanged(index, index);
+    return;
+  }
+  if (_store->canFetchMore())
+    return; // new object, its key will come with a next page
+  row = _objects.size();
+  beginInsertRows(QModelIndex(), row, row);
+  _objects.append(object);
+  _pks.append(_store->primaryKey(object));
+  _loadedRows.insert(object, row);
+  endInsertRows();
+}
+
+QObject *ObjectsListModel::loadRow(int row) {
+  _loadingRow = row;
+  QObject *object = _store->load(_pks[row]);
+  _loadingRow = -1;
+  if (!object)
+    return nullptr;
+  _objects[row] = object;
+  _loadedRows.insert(object, row);
+  if (_loadedRows.size() > _windowSize)
+    releaseFarFrom(row);
+  return object;
+}
+
+void ObjectsListModel::releaseFarFrom(int row) {
+  QList<QObject*> far;
+  for (auto [object, i]: _loadedRows.asKeyValueRange())
+    if (qAbs(i-row) > _windowSize/2)
+      far.append(object);
+  for (QObject *object: far) {
+    // released objects are still in _loadedRows, since the store may emit
+    // fetched() when writing their pending changes
+    _store->release(object);
+    _objects[_loadedRows.take(object)] = nullptr;
+  }
+}
+
 void ObjectsListModel::update(QObject *object) {
   int n = _objects.size();
   for (int i = 0; i < n; ++i) {
@@ -98,6 +184,20 @@ void ObjectsListModel::update(QObject *object) {
 
 void ObjectsListModel::remove(QObject *object) {
   //qDebug() << "ObjectsListModel::remove" << object;
+  if (_store) {
+    int row = _loadedRows.value(object, -1);
+    if (row < 0)
+      return;
+    beginRemoveRows(QModelIndex(), row, row);
+    _objects.removeAt(row);
+    _pks.removeAt(row);
+    _loadedRows.remove(object);
+    for (auto &i: _loadedRows)
+      if (i > row)
+        --i;
+    endRemoveRows();
+    return;
+  }
   int n = _objects.size();
   for (int i = 0; i < n; ++i) {
     if (_objects.value(i) == object) {
@@ -18,6 +18,9 @@
 #include <QAbstractListModel>
 #include "util/utf8stringset.h"
 #include <QMetaProperty>
+#include <QPointer>
+
+class ObjectsStore;
 
 /** Model for a list of same class QObjects, mapping their properties to roles,
  * and the QObject itself to an object role, in order to make the object and
@@ -30,11 +33,21 @@
  *
  * Can work standalone but designed to be used with ObjectsStore.
  *
+ * With stores supporting paged access, setStore() enables a paged mode in
+ * which rows are primary keys fetched by pages when views need them
+ * (canFetchMore()/fetchMore()) and objects are loaded only when their row
+ * data is read, and released again when they are far from the rows being
+ * read, so that only a window of objects is kept in memory.
+ *
  * @see ObjectsStore
  */
 class LIBP6CORESHARED_EXPORT ObjectsListModel : public QAbstractListModel {
   Q_OBJECT
-  QList<QObject*> _objects;
+  QList<QObject*> _objects; // null for not loaded rows in paged mode
+  QList<QVariant> _pks; // primary keys, only in paged mode
+  QHash<QObject*,int> _loadedRows; // object -> row, only in paged mode
+  QPointer<ObjectsStore> _store; // only in paged mode
+  int _windowSize = 1000, _loadingRow = -1;
   QHash<int, QByteArray> _roleNames;
   int _baseUserRole;
   QList<QMetaProperty> _storedProperties;
@@ -57,6 +70,17 @@ public:
   QVariant headerData(int section, Qt::Orientation orientation,
                       int role = Qt::DisplayRole) const override;
   QHash<int, QByteArray> roleNames() const override;
+  bool canFetchMore(const QModelIndex &parent) const override;
+  void fetchMore(const QModelIndex &parent) override;
+  /** Enable paged mode, resetting the model.
+   * Store signals are connected by the model itself, there is no need to
+   * connect them to update() and remove(). */
+  void setStore(ObjectsStore *store);
+  /** Max number of loaded objects in paged mode, objects more than half
+   * the window away from the last read row are released when reached.
+   * Default: 1000. */
+  int windowSize() const { return _windowSize; }
+  void setWindowSize(int windowSize) { _windowSize = qMax(windowSize, 2); }
 
 public slots:
   /** notify changes to views, will append object if not already in the list
@@ -70,6 +94,10 @@ private:
   void append(QObject *object);
   /** do not take ownership, but the object must remain valid until removed */
   void append(QList<QObject *> objects);
+  void appendKeys(const QVariantList &pks);
+  void objectFetched(QObject *object);
+  QObject *loadRow(int row);
+  void releaseFarFrom(int row);
 };
 
 #endif // OBJECTSLISTMODEL_H
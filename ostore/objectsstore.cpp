@@ -35,6 +35,16 @@ ObjectsStore::Result ObjectsStore::persist(QObject *) {
   return Result();
 }
 
+ObjectsStore::Result ObjectsStore::persistAll() {
+  Result result(true);
+  apply([this,&result](QObject *o) {
+    Result r = persist(o);
+    if (result.success() && !r.success())
+      result = r;
+  });
+  return result;
+}
+
 ObjectsStore::Result ObjectsStore::dispose(QObject *, bool) {
   return Result();
 }
@@ -42,3 +52,22 @@ ObjectsStore::Result ObjectsStore::dispose(QObject *, bool) {
 ObjectsStore::Result ObjectsStore::fetch() {
   return Result();
 }
+
+bool ObjectsStore::canFetchMore() const {
+  return false;
+}
+
+ObjectsStore::Result ObjectsStore::fetchMore() {
+  return Result(false, "unsupported", "paged access not supported");
+}
+
+QObject *ObjectsStore::load(const QVariant &) {
+  return nullptr;
+}
+
+void ObjectsStore::release(QObject *) {
+}
+
+QVariant ObjectsStore::primaryKey(QObject *) const {
+  return QVariant();
+}
@@ -84,6 +84,19 @@ public:
                          size_t index)> f) = 0;
   /** Apply f to every object in the store */
   virtual size_t apply(std::function<void(QObject *object)> f);
+  /** Paged access: true if more primary keys can be fetched by fetchMore().
+   * Default: false, paged access not supported. */
+  virtual bool canFetchMore() const;
+  /** Paged access: load object given its primary key (emitting fetched()),
+   * or return it if already loaded.
+   * Default: return nullptr. */
+  virtual QObject *load(const QVariant &pk);
+  /** Paged access: write pending changes of the object, then delete it from
+   * memory, without removing it from the store, it can be loaded again later.
+   * Default: do nothing. */
+  virtual void release(QObject *object);
+  /** Default: return null QVariant */
+  virtual QVariant primaryKey(QObject *object) const;
 
 public slots:
   /** Create a new object in the store and fetch it.
@@ -93,6 +106,9 @@ public slots:
       const QHash<QString,QVariant> &params = { }) = 0;
   /** Persist an object in the store, i.e. ensure its state is saved. */
   virtual ObjectsStore::Result persist(QObject *object) = 0;
+  /** Persist every object in the store, as a batch if the store supports it.
+   * Default: call persist() for every object, return first failure if any. */
+  virtual ObjectsStore::Result persistAll();
   /** Remove an object from the store and optionally delete it.
    * disposed() is emitted.
    * If required object deletion is done using deleteLater() rather than
@@ -105,6 +121,10 @@ public slots:
   /** Fetch initial (all if possible) data and emit fetched() signals to
    * populate connected models */
   virtual ObjectsStore::Result fetch() = 0;
+  /** Paged access: fetch next page of primary keys and emit keysFetched(),
+   * without loading any object.
+   * Default: fail, paged access not supported. */
+  virtual ObjectsStore::Result fetchMore();
 
 signals:
   /** emitted by fetchAll(), create(), persist() and even spontaneously e.g.
@@ -112,6 +132,8 @@ signals:
   void fetched(QObject *object);
   /** emitted by destroy() and spontaneously */
   void disposed(QObject *object);
+  /** emitted by fetchMore(), keys are in store order */
+  void keysFetched(const QVariantList &pks);
 };
 
 Q_DECLARE_METATYPE(ObjectsStore::Result)
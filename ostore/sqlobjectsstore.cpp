@@ -42,6 +42,21 @@ SqlObjectsStore::SqlObjectsStore(const QMetaObject *metaobject,
     if (method.methodSignature() == "persistSenderSlot()")
       _persistSenderSlot = method;
   }
+  for (int i = 0; i < _storedProperties.size(); ++i) {
+    const QMetaProperty &prop = _storedProperties[i];
+    if (prop.name() == _pkPropName)
+      continue;
+    _allColumns.append(i);
+    if (prop.hasNotifySignal())
+      _columnsByNotifySignal[prop.notifySignalIndex()].append(i);
+  }
+  _flushTimer.setSingleShot(true);
+  _flushTimer.setInterval(0);
+  connect(&_flushTimer, &QTimer::timeout, this, &SqlObjectsStore::flush);
+}
+
+SqlObjectsStore::~SqlObjectsStore() {
+  flush(); // objects are children, hence still alive
 }
 
 ObjectsStore::Result SqlObjectsStore::create(
@@ -118,6 +133,9 @@ inline QObject *SqlObjectsStore::mapToObject(const QSqlRecord &r) {
       connect(object, method, this, _persistSenderSlot,
               Qt::UniqueConnection);
   }
+  connect(object, &QObject::destroyed, this, [this](QObject *object) {
+    _dirties.remove(object);
+  });
   QString pk = object->property(_pkPropName).toString();
   if (pk.isEmpty()) {
     qWarning() << "error when fetching object: empty primary key"
@@ -133,7 +151,7 @@ inline QObject *SqlObjectsStore::mapToObject(const QSqlRecord &r) {
 
 ObjectsStore::Result SqlObjectsStore::fetch() {
   // TODO sanitize table and keys names
-  // LATER limit fetched rows count
+  // for large tables, paged access should be used instead, see fetchMore()
   QSqlQuery query(_db);
   QString sql = "SELECT * from "+_tableName;
   query.prepare(sql);
@@ -147,45 +165,163 @@ ObjectsStore::Result SqlObjectsStore::fetch() {
                 error.driverText()+" "+error.databaseText()+" : "+sql);
 }
 
+void SqlObjectsStore::setPageSize(int pageSize) {
+  _pageSize = qMax(pageSize, 0);
+  _lastFetchedPk = QVariant();
+  _allKeysFetched = false;
+}
+
+ObjectsStore::Result SqlObjectsStore::fetchMore() {
+  // TODO sanitize table and keys names
+  if (!canFetchMore())
+    return Result(true);
+  QSqlQuery query(_db);
+  QString sql = "SELECT "+_pkPropName+" FROM "+_tableName;
+  if (_lastFetchedPk.isValid())
+    sql += " WHERE "+_pkPropName+" > ?";
+  sql += " ORDER BY "+_pkPropName+" LIMIT "+QString::number(_pageSize);
+  query.prepare(sql);
+  if (_lastFetchedPk.isValid())
+    query.bindValue(0, _lastFetchedPk);
+  if (!query.exec()) {
+    QSqlError error = query.lastError();
+    return Result(false, error.nativeErrorCode(),
+                  error.driverText()+" "+error.databaseText()+" : "+sql);
+  }
+  QVariantList pks;
+  while (query.next())
+    pks.append(query.value(0));
+  if (pks.size() < _pageSize)
+    _allKeysFetched = true;
+  if (!pks.isEmpty()) {
+    _lastFetchedPk = pks.last();
+    emit keysFetched(pks);
+  }
+  return Result(true);
+}
+
+QObject *SqlObjectsStore::load(const QVariant &pk) {
+  // TODO sanitize table and keys names
+  if (QObject *object = _byPk.value(pk.toString()))
+    return object;
+  if (_loadStatement.lastQuery().isEmpty()) {
+    _loadStatement = QSqlQuery(_db);
+    _loadStatement.prepare("SELECT * FROM "+_tableName+" WHERE "+_pkPropName
+                           +" = ?");
+  }
+  _loadStatement.bindValue(0, pk);
+  if (!_loadStatement.exec() || !_loadStatement.next()) {
+    QSqlError error = _loadStatement.lastError();
+    qWarning() << "cannot load object" << _metaobject->className() << pk
+               << "error:" << error.nativeErrorCode() << error.driverText()
+               << error.databaseText();
+    return nullptr;
+  }
+  QSqlRecord r = _loadStatement.record();
+  _loadStatement.finish();
+  return mapToObject(r);
+}
+
+void SqlObjectsStore::release(QObject *object) {
+  if (!object)
+    return;
+  auto it = _dirties.find(object);
+  if (it != _dirties.end()) {
+    auto columns = it.value();
+    _dirties.erase(it);
+    update(object, columns);
+  }
+  disconnect(object, 0, this, 0);
+  _byPk.remove(object->property(_pkPropName).toString());
+  object->deleteLater();
+}
+
+QVariant SqlObjectsStore::primaryKey(QObject *object) const {
+  return object ? object->property(_pkPropName) : QVariant();
+}
+
 void SqlObjectsStore::persistSenderSlot() {
-  // TODO add a buffer when there are several changes in the object at the
-  // same time (in the same event loop iteration) to avoid calling persist()
-  // this could probably be achieved e.g. using a "QSet<QObject*> _dirties"
-  // and calling actual persist() method in next loop iteration, only once
-  // per object (or calling a batch persist(QSet<>) once for all objects)
-  persist(sender());
+  // record changed columns, actual update will be done by flush()
+  QObject *object = sender();
+  auto columns = _columnsByNotifySignal.value(senderSignalIndex(), _allColumns);
+  auto &dirty = _dirties[object];
+  for (int column: columns) {
+    auto it = std::lower_bound(dirty.begin(), dirty.end(), column);
+    if (it == dirty.end() || *it != column)
+      dirty.insert(it, column);
+  }
+  if (!_flushTimer.isActive())
+    _flushTimer.start();
+}
+
+void SqlObjectsStore::flush() {
+  _flushTimer.stop();
+  if (_dirties.isEmpty())
+    return;
+  auto dirties = std::move(_dirties);
+  _dirties.clear();
+  bool transaction = _db.transaction();
+  for (auto [object, columns]: dirties.asKeyValueRange())
+    update(object, columns);
+  if (transaction && !_db.commit()) {
+    QSqlError error = _db.lastError();
+    qWarning() << "cannot commit database transaction for objects"
+               << _metaobject->className() << "error:"
+               << error.nativeErrorCode() << error.driverText()
+               << error.databaseText();
+    _db.rollback();
+  }
 }
 
 ObjectsStore::Result SqlObjectsStore::persist(QObject *object) {
-  // TODO sanitize table and keys names
   if (!object)
     return Result(false, "null", "null object");
+  _dirties.remove(object);
+  return update(object, _allColumns);
+}
+
+ObjectsStore::Result SqlObjectsStore::persistAll() {
+  _dirties.clear();
+  _flushTimer.stop();
+  bool transaction = _db.transaction();
+  Result result(true);
+  for (QObject *object: std::as_const(_byPk)) {
+    Result r = update(object, _allColumns);
+    if (result.success() && !r.success())
+      result = r;
+  }
+  if (transaction && !_db.commit()) {
+    QSqlError error = _db.lastError();
+    _db.rollback();
+    return Result(false, error.nativeErrorCode(),
+                  error.driverText()+" "+error.databaseText()+" : COMMIT");
+  }
+  return result;
+}
+
+ObjectsStore::Result SqlObjectsStore::update(
+    QObject *object, const QList<int> &columns) {
+  // TODO sanitize table and keys names
   QVariant pk = object->property(_pkPropName);
   if (!pk.isValid())
     return Result(false, "bad_pk", "invalid primary key");
-  QSqlQuery query(_db);
-  QString sql = "UPDATE "+_tableName+" SET ";
-  const QMetaObject *metaobject = object->metaObject();
-  int first = metaobject->propertyOffset();
-  int count = metaobject->propertyCount();
-  QList<QMetaProperty> props;
-  for (int i = first, j = 0; i < count; ++i) {
-    QMetaProperty prop = metaobject->property(i);
-    if (!prop.isStored())
-      continue;
-    if (prop.name() == _pkPropName)
-      continue;
-    props.append(prop);
-    if (j)
-      sql += ", ";
-    sql += QString::fromLatin1(prop.name())+" = ?";
-    ++j;
+  auto it = _updateStatements.find(columns);
+  if (it == _updateStatements.end()) {
+    QString sql = "UPDATE "+_tableName+" SET ";
+    for (int i = 0; i < columns.size(); ++i) {
+      if (i)
+        sql += ", ";
+      sql += QString::fromLatin1(_storedProperties[columns[i]].name())+" = ?";
+    }
+    sql += " WHERE "+_pkPropName+" = ?";
+    QSqlQuery query(_db);
+    query.prepare(sql);
+    it = _updateStatements.insert(columns, query);
   }
-  sql += " WHERE "+_pkPropName+" = ?";
-  query.prepare(sql);
+  QSqlQuery &query = it.value();
   int i = 0;
-  for (const QMetaProperty &prop: props) {
-    query.bindValue(i, prop.read(object));
+  for (int column: columns) {
+    query.bindValue(i, _storedProperties[column].read(object));
     ++i;
   }
   query.bindValue(i, pk);
@@ -196,9 +332,10 @@ ObjectsStore::Result SqlObjectsStore::persist(QObject *object) {
   QSqlError error = query.lastError();
   qWarning() << "cannot update database for object" << _metaobject->className()
              << pk << "error:" << error.nativeErrorCode() << error.driverText()
-             << error.databaseText() << "request:" << sql;
+             << error.databaseText() << "request:" << query.lastQuery();
   return Result(false, error.nativeErrorCode(),
-                error.driverText()+" "+error.databaseText()+" : "+sql);
+                error.driverText()+" "+error.databaseText()+" : "
+                +query.lastQuery());
 }
 
 ObjectsStore::Result SqlObjectsStore::dispose(
@@ -215,6 +352,7 @@ ObjectsStore::Result SqlObjectsStore::dispose(
   query.bindValue(0, pk);
   if (query.exec()) {
     disconnect(object, 0, this, 0);
+    _dirties.remove(object);
     _byPk.remove(pk.toString());
     emit disposed(object);
     if (shouldDelete)
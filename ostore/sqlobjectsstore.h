@@ -17,9 +17,22 @@
 #include "objectsstore.h"
 #include <QSqlDatabase>
 #include <QMetaMethod>
+#include <QSqlQuery>
+#include <QTimer>
 
 /** RDBMS implementation for ObjectsStore.
  * Currently only SQLite is supported for real.
+ *
+ * Objects changes notified by their properties notify signals are not written
+ * immediatly: changed objects and properties are recorded and flushed at once
+ * in next event loop iteration (or after flushInterval()), within a single
+ * database transaction and only updating changed columns.
+ *
+ * When pageSize() is set, paged access is enabled: fetchMore() fetches primary
+ * keys page by page (keyset pagination, ordered by primary key, rather than
+ * offsets) and objects are created only by load(), typically when an
+ * ObjectsListModel row is read, which makes it possible to browse large tables
+ * while keeping only a window of objects in memory.
  * @see ObjectsStore
  */
 class LIBP6CORESHARED_EXPORT SqlObjectsStore : public ObjectsStore {
@@ -30,6 +43,15 @@ class LIBP6CORESHARED_EXPORT SqlObjectsStore : public ObjectsStore {
   QList<QMetaProperty> _storedProperties;
   QHash<QByteArray,QMetaProperty> _storedPropertiesByName;
   QMetaMethod _persistSenderSlot;
+  QList<int> _allColumns; // indexes in _storedProperties, but pk
+  QHash<int,QList<int>> _columnsByNotifySignal; // signal index -> columns
+  QHash<QObject*,QList<int>> _dirties; // object -> changed columns, sorted
+  QHash<QList<int>,QSqlQuery> _updateStatements; // columns -> update
+  QTimer _flushTimer;
+  int _pageSize = 0;
+  QVariant _lastFetchedPk; // last key returned by fetchMore()
+  bool _allKeysFetched = false;
+  QSqlQuery _loadStatement;
 
 public:
   /** @param metaobject type of objects that will be stored
@@ -48,16 +70,38 @@ public:
   SqlObjectsStore(
       const QMetaObject *metaobject, QSqlDatabase db, QObject *parent)
     : SqlObjectsStore(metaobject, db, QByteArray(), "id", parent) { }
+  ~SqlObjectsStore();
   Result create(const QHash<QString, QVariant> &params = { }) override;
   Result fetch() override;
   Result persist(QObject *object) override;
+  /** Persist every object within a single database transaction. */
+  Result persistAll() override;
+  Result fetchMore() override;
+  bool canFetchMore() const override {
+    return _pageSize > 0 && !_allKeysFetched; }
+  QObject *load(const QVariant &pk) override;
+  void release(QObject *object) override;
+  QVariant primaryKey(QObject *object) const override;
+  /** Number of keys fetched at once by fetchMore(), 0 disables paged access.
+   * Setting it restarts paging from first key. Default: 0. */
+  int pageSize() const { return _pageSize; }
+  void setPageSize(int pageSize);
   Result dispose(QObject *object, bool shouldDelete = true) override;
   size_t apply(
       std::function<void(QObject*,ObjectsStore*,size_t)> f) override;
   using ObjectsStore::apply;
+  /** Delay before writing changes notified by objects, in milliseconds.
+   * Default: 0, i.e. next event loop iteration. */
+  int flushInterval() const { return _flushTimer.interval(); }
+  void setFlushInterval(int msecs) { _flushTimer.setInterval(msecs); }
+
+public slots:
+  /** Write pending changes now, within a single database transaction. */
+  void flush();
 
 private:
   inline QObject *mapToObject(const QSqlRecord &r);
+  Result update(QObject *object, const QList<int> &columns);
   Q_INVOKABLE void persistSenderSlot();
 };
 
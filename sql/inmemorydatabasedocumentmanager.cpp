@@ -48,10 +48,34 @@ bool InMemoryDatabaseDocumentManager::prepareChangeItem(
     const SharedUiItem &old_item, const Utf8String &qualifier,
     QString *errorString) {
   Q_ASSERT(errorString != 0);
-  if (!changeItemInDatabase(transaction, new_item, old_item, qualifier,
-                            errorString, true)) {
+  if (_pending_transaction != transaction) {
+    rollbackPendingTransaction();
+    if (!_db.transaction()) {
+      *errorString = "database error: cannot start transaction "
+          +_db.lastError().text();
+      qWarning() << "InMemoryDatabaseDocumentManager" << *errorString;
+      return false;
+    }
+    _pending_transaction = transaction;
+  }
+  // the savepoint makes it possible to reject this change alone, keeping
+  // previous changes of the same transaction written
+  if (!execQuery("savepoint p6_change"_u8, errorString)) {
+    rollbackPendingTransaction();
+    return false;
+  }
+  if (!writeChangeInDatabase(new_item, old_item, qualifier, errorString)) {
+    QString reason;
+    if (!execQuery("rollback to savepoint p6_change"_u8, &reason)) {
+      qDebug() << "InMemoryDatabaseDocumentManager" << reason;
+      rollbackPendingTransaction();
+    }
     qDebug() << "InMemoryDatabaseDocumentManager::prepareChangeItem: "
-                "test transaction failed:" << *errorString;
+                "change rejected by database:" << *errorString;
+    return false;
+  }
+  if (!execQuery("release savepoint p6_change"_u8, errorString)) {
+    rollbackPendingTransaction();
     return false;
   }
   storeItemChange(transaction, new_item, old_item, qualifier);
@@ -61,104 +85,161 @@ bool InMemoryDatabaseDocumentManager::prepareChangeItem(
 void InMemoryDatabaseDocumentManager::commitChangeItem(
     const SharedUiItem &new_item, const SharedUiItem &old_item,
     const Utf8String &qualifier) {
-  QString errorString;
-  SharedUiItemDocumentTransaction transaction(this);
-  if (!changeItemInDatabase(&transaction, new_item, old_item, qualifier,
-                            &errorString, false)) {
-    // this should only occur on severe technical error (filesystem full,
-    // network connection to the database lost, etc.)
-    qWarning() << "InMemoryDatabaseDocumentManager cannot write to database "
-                  "prepared change:" << new_item << old_item << ":"
-               << errorString;
-  } else {
-    //qDebug() << "InMemoryDatabaseDocumentManager::commitChangeItem"
-    //         << newItem << oldItem;
-    InMemorySharedUiItemDocumentManager::commitChangeItem(
-          new_item, old_item, qualifier);
+  if (!_committing_pending) {
+    // change was not written by prepareChangeItem(), e.g. on undo
+    QString errorString;
+    bool own_transaction = !_committing_batch;
+    bool ok = (!own_transaction || _db.transaction())
+        && writeChangeInDatabase(new_item, old_item, qualifier, &errorString)
+        && (!own_transaction || _db.commit());
+    if (!ok) {
+      if (own_transaction)
+        _db.rollback();
+      if (errorString.isEmpty())
+        errorString = _db.lastError().text();
+      // this should only occur on severe technical error (filesystem full,
+      // network connection to the database lost, etc.)
+      qWarning() << "InMemoryDatabaseDocumentManager cannot write to database "
+                    "prepared change:" << new_item << old_item << ":"
+                 << errorString;
+      return;
+    }
   }
+  //qDebug() << "InMemoryDatabaseDocumentManager::commitChangeItem"
+  //         << newItem << oldItem;
+  InMemorySharedUiItemDocumentManager::commitChangeItem(
+        new_item, old_item, qualifier);
 }
 
-bool InMemoryDatabaseDocumentManager::changeItemInDatabase(
-    SharedUiItemDocumentTransaction *transaction, const SharedUiItem &new_item,
-    const SharedUiItem &old_item, const Utf8String &qualifier,
-    QString *errorString, bool dry_run) {
-  Q_ASSERT(errorString != 0);
-  Q_ASSERT(!new_item.isNull() || !old_item.isNull());
-  if (!_db.transaction()) {
-    *errorString = "database error: cannot start transaction "
-        +_db.lastError().text();
-    return false;
-  }
-  if (!old_item.isNull()) {
-    QSqlQuery query(_db);
-    query.prepare("delete from "+qualifier+" where "
-                  +old_item.uiSectionName(
-                    _id_sections.value(qualifier)).toIdentifier()
-                  +" = ?");
-    query.bindValue(0, old_item.id());
-    if (!query.exec()) {
-      *errorString = tr("database error: cannot delete from table %1 %2 %3 %4")
-                     .arg(qualifier).arg(old_item.id())
-                     .arg(query.lastError().text()).arg(query.executedQuery());
-      goto failed;
-    }
-  }
-  if (!new_item.isNull()
-      && !insertItemInDatabase(transaction, new_item, errorString)) {
-    if (!_db.rollback()) {
-      qDebug() << "InMemoryDatabaseDocumentManager database error: cannot "
-                  "rollback transaction" << _db.lastError().text();
-    }
-    goto failed;
+void InMemoryDatabaseDocumentManager::beginCommit(
+    SharedUiItemDocumentTransaction *transaction) {
+  if (transaction && transaction == _pending_transaction) {
+    // changes were already written by prepareChangeItem()
+    _committing_batch = _committing_pending = true;
+    return;
   }
-  if (dry_run) {
-    if (!_db.rollback()) {
-      qDebug() << "InMemoryDatabaseDocumentManager database error: cannot "
-                  "rollback transaction" << _db.lastError().text();
-      return false;
-    }
-  } else {
-    if (!_db.commit()) {
-      *errorString = "database error: cannot commit transaction "
-          +_db.lastError().text();
-      goto failed;
-    }
+  rollbackPendingTransaction();
+  _committing_batch = _db.transaction();
+  if (!_committing_batch) // will fall back to one transaction per change
+    qDebug() << "InMemoryDatabaseDocumentManager database error: cannot "
+                "start transaction" << _db.lastError().text();
+}
+
+void InMemoryDatabaseDocumentManager::endCommit(
+    SharedUiItemDocumentTransaction *) {
+  if (!_committing_batch)
+    return;
+  _committing_batch = _committing_pending = false;
+  _pending_transaction = nullptr;
+  if (!_db.commit()) {
+    // same as above: severe technical error, memory and database diverge
+    qWarning() << "InMemoryDatabaseDocumentManager cannot commit database "
+                  "transaction:" << _db.lastError().text();
+    _db.rollback();
   }
-  return true;
-failed:;
-  _db.rollback();
-  qWarning() << "InMemoryDatabaseDocumentManager" << *errorString;
+}
+
+void InMemoryDatabaseDocumentManager::transactionDestroyed(
+    SharedUiItemDocumentTransaction *transaction) {
+  if (transaction == _pending_transaction) // never committed
+    rollbackPendingTransaction();
+}
+
+void InMemoryDatabaseDocumentManager::rollbackPendingTransaction() {
+  if (!_pending_transaction)
+    return;
+  _pending_transaction = nullptr;
+  if (!_db.rollback())
+    qDebug() << "InMemoryDatabaseDocumentManager database error: cannot "
+                "rollback transaction" << _db.lastError().text();
+}
+
+bool InMemoryDatabaseDocumentManager::execQuery(
+    const Utf8String &sql, QString *errorString) {
+  QSqlQuery query(_db);
+  if (query.exec(sql))
+    return true;
+  *errorString = tr("database error: %1: %2")
+                 .arg(sql).arg(query.lastError().text());
   return false;
 }
 
-bool InMemoryDatabaseDocumentManager::insertItemInDatabase(
-    SharedUiItemDocumentTransaction *transaction, const SharedUiItem &new_item,
+InMemoryDatabaseDocumentManager::Statements *
+InMemoryDatabaseDocumentManager::statements(
+    const Utf8String &qualifier, const SharedUiItem &item,
     QString *errorString) {
-  Q_UNUSED(transaction)
+  auto it = _statements.find(qualifier);
+  if (it != _statements.end())
+    return &it.value();
+  Utf8StringList columnNames, placeholders, assignments;
+  for (int i = 0; i < item.uiSectionCount(); ++i) {
+    auto columnName = item.uiSectionName(i).toIdentifier();
+    columnNames << columnName;
+    placeholders << "?"_u8;
+    assignments << columnName+" = ?";
+  }
+  auto idColumnName = columnNames.value(_id_sections.value(qualifier));
+  Statements statements { QSqlQuery(_db), QSqlQuery(_db), QSqlQuery(_db) };
+  if (!statements._delete.prepare(
+        "delete from "+qualifier+" where "+idColumnName+" = ?")
+      || !statements._insert.prepare(
+        "insert into "+qualifier+" ("+columnNames.join(',')+") values ("
+        +placeholders.join(',')+")")
+      || !statements._update.prepare(
+        "update "+qualifier+" set "+assignments.join(',')+" where "
+        +idColumnName+" = ?")) {
+    *errorString = tr("database error: cannot prepare statements for table "
+                      "%1: %2").arg(qualifier).arg(_db.lastError().text());
+    return nullptr;
+  }
+  return &_statements.insert(qualifier, statements).value();
+}
+
+bool InMemoryDatabaseDocumentManager::writeChangeInDatabase(
+    const SharedUiItem &new_item, const SharedUiItem &old_item,
+    const Utf8String &qualifier, QString *errorString) {
   Q_ASSERT(errorString != 0);
-  Creator creator = _creators.value(new_item.qualifier());
-  if (new_item.isNull() || !creator) {
-    *errorString = "cannot insert into database item: "+new_item.qualifiedId()
-        +" creator: "+(creator?"true":"false");
+  Q_ASSERT(!new_item.isNull() || !old_item.isNull());
+  auto s = statements(qualifier, new_item.isNull() ? old_item : new_item,
+                      errorString);
+  if (!s)
     return false;
+  if (!new_item.isNull() && !old_item.isNull()
+      && new_item.id() == old_item.id()) {
+    // tables have no unique index, hence update in place rather than upsert
+    int count = new_item.uiSectionCount();
+    for (int i = 0; i < count; ++i)
+      s->_update.bindValue(i, new_item.uiData(
+                             i, SharedUiItem::ExternalDataRole));
+    s->_update.bindValue(count, old_item.id());
+    if (!s->_update.exec()) {
+      *errorString = tr("database error: cannot update table %1 %2: %3")
+                     .arg(qualifier).arg(old_item.id())
+                     .arg(s->_update.lastError().text());
+      return false;
+    }
+    if (s->_update.numRowsAffected() > 0)
+      return true;
+    // row is missing or driver cannot tell: fall back to delete and insert
   }
-  QString qualifier = new_item.qualifier();
-  QStringList columnNames, placeholders;
-  for (int i = 0; i < new_item.uiSectionCount(); ++i) {
-    columnNames << new_item.uiSectionName(i).toIdentifier();
-    placeholders << u"?"_s;
-  }
-  QSqlQuery query(_db);
-  query.prepare("insert into "+qualifier+" ("+columnNames.join(',')
-                +") values ("+placeholders.join(',')+")");
-  for (int i = 0; i < new_item.uiSectionCount(); ++i) {
-    query.bindValue(i, new_item.uiData(i, SharedUiItem::ExternalDataRole));
+  if (!old_item.isNull()) {
+    s->_delete.bindValue(0, old_item.id());
+    if (!s->_delete.exec()) {
+      *errorString = tr("database error: cannot delete from table %1 %2 %3 %4")
+                     .arg(qualifier).arg(old_item.id())
+                     .arg(s->_delete.lastError().text())
+                     .arg(s->_delete.executedQuery());
+      return false;
+    }
   }
-  if (!query.exec()) {
+  if (new_item.isNull())
+    return true;
+  for (int i = 0; i < new_item.uiSectionCount(); ++i)
+    s->_insert.bindValue(i, new_item.uiData(i, SharedUiItem::ExternalDataRole));
+  if (!s->_insert.exec()) {
     *errorString = tr("database error: cannot insert into table %1 %2: %3")
                    .arg(qualifier).arg(new_item.id())
-                   .arg(query.lastError().text());
-    qDebug() << "InMemoryDatabaseDocumentManager" << *errorString;
+                   .arg(s->_insert.lastError().text());
     return false;
   }
   return true;
@@ -166,6 +247,8 @@ bool InMemoryDatabaseDocumentManager::insertItemInDatabase(
 
 bool InMemoryDatabaseDocumentManager::setDatabase(
     QSqlDatabase db, QString *errorString) {
+  rollbackPendingTransaction();
+  _statements.clear();
   _repository.clear();
   _db = db;
   emit dataReset();
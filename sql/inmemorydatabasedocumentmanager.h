@@ -16,6 +16,7 @@
 
 #include "modelview/inmemoryshareduiitemdocumentmanager.h"
 #include <QSqlDatabase>
+#include <QSqlQuery>
 
 /** Simple generic implementation of SharedUiItemDocumentManager holding in
  * memory a repository of items by qualifier and id, with database
@@ -31,6 +32,13 @@
  * All items must support SharedUiItem::ExternalDataRole role in their
  * uiData() and setUiData() implementation.
  *
+ * Database writes use prepared statements cached per qualifier and are
+ * grouped in one database transaction per SharedUiItemDocumentTransaction:
+ * changes are written within a savepoint by prepareChangeItem() (which makes
+ * it possible for the database to reject them) and the whole transaction is
+ * committed when the SharedUiItemDocumentTransaction is, or rolled back if it
+ * is destroyed without being committed.
+ *
  * To enable holding items, registerItemType() must be called for every
  * qualifier, in such a way:
  *   dm->registerItemType(
@@ -53,6 +61,13 @@ class LIBP6CORESHARED_EXPORT InMemoryDatabaseDocumentManager
   QSqlDatabase _db;
   QHash<Utf8String,int> _id_sections; // qualifier -> section containing id
   Utf8StringList _ordered_qualifiers; // in order of registration
+  struct Statements {
+    QSqlQuery _delete, _insert, _update;
+  };
+  QHash<Utf8String,Statements> _statements; // qualifier -> prepared statements
+  // transaction which changes were written in the pending database transaction
+  SharedUiItemDocumentTransaction *_pending_transaction = nullptr;
+  bool _committing_pending = false, _committing_batch = false;
 
 public:
   InMemoryDatabaseDocumentManager(QObject *parent = 0);
@@ -111,17 +126,25 @@ public:
       const Utf8String &qualifier) override;
   // TODO add a way to notify user of database errors, such as a signal
 
+protected:
+  void beginCommit(SharedUiItemDocumentTransaction *transaction) override;
+  void endCommit(SharedUiItemDocumentTransaction *transaction) override;
+  void transactionDestroyed(
+      SharedUiItemDocumentTransaction *transaction) override;
+
 private:
   bool createTableAndSelectData(
       const Utf8String &qualifier, Setter setter, Creator creator,
       int id_section, QString *errorString);
-  bool insertItemInDatabase(
-      SharedUiItemDocumentTransaction *transaction,
-      const SharedUiItem &new_item, QString *errorString);
-  bool changeItemInDatabase(
-      SharedUiItemDocumentTransaction *transaction,
+  /** Write change using cached prepared statements, within the current
+   * database transaction, if any. */
+  bool writeChangeInDatabase(
       const SharedUiItem &new_item, const SharedUiItem &old_item,
-      const Utf8String &qualifier, QString *errorString, bool dry_run);
+      const Utf8String &qualifier, QString *errorString);
+  Statements *statements(const Utf8String &qualifier, const SharedUiItem &item,
+                         QString *errorString);
+  bool execQuery(const Utf8String &sql, QString *errorString);
+  void rollbackPendingTransaction();
   using InMemorySharedUiItemDocumentManager::registerItemType; // hide
 };
 
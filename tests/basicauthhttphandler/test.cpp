@@ -0,0 +1,81 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "httpd/basicauthhttphandler.h"
+#include "log/log.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QtDebug>
+
+// accepts alice with current password and counts calls
+class CountingAuthenticator : public Authenticator {
+public:
+  mutable int _calls = 0;
+  QString _password = "secret";
+  QString authenticate(QString login, QString password,
+                       ParamSet) const override {
+    ++_calls;
+    return login == "alice" && password == _password ? login : QString();
+  }
+};
+
+// @return status code and user id set in context
+static QString get(BasicAuthHttpHandler *handler, const QByteArray &login,
+                   const QByteArray &password) {
+  HttpRequest req(nullptr, nullptr);
+  HttpResponse res(nullptr);
+  ParamsProviderMerger context;
+  if (!req.parse_and_add_header(
+        "Authorization: Basic "+(login+":"+password).toBase64()))
+    return "cannot set header";
+  handler->handleRequest(req, res, context);
+  return QString::number(res.status())+" "
+      +context.paramRawUtf8("userid").toString();
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  CountingAuthenticator authenticator;
+  BasicAuthHttpHandler handler;
+  handler.setAuthenticator(&authenticator);
+  handler.enableMandatoryAuth();
+  // cache hit does not call authenticator
+  qDebug() << get(&handler, "alice", "secret")
+           << get(&handler, "alice", "secret") << authenticator._calls;
+  // failures are never cached
+  qDebug() << get(&handler, "alice", "wrong")
+           << get(&handler, "alice", "wrong") << authenticator._calls;
+  // changed() clears the cache, credentials are verified again
+  authenticator._password = "other";
+  emit authenticator.changed();
+  qDebug() << get(&handler, "alice", "secret")
+           << get(&handler, "alice", "other")
+           << get(&handler, "alice", "other") << authenticator._calls;
+  // so does setRealm(), since realm is part of authentication context
+  handler.setRealm("elsewhere");
+  qDebug() << get(&handler, "alice", "other")
+           << get(&handler, "alice", "other") << authenticator._calls;
+  // entries expire after ttl
+  handler.setCredentialsCacheTtl(100);
+  qDebug() << get(&handler, "alice", "other")
+           << get(&handler, "alice", "other") << authenticator._calls;
+  QThread::msleep(200);
+  qDebug() << get(&handler, "alice", "other") << authenticator._calls;
+  // 0 disables the cache
+  handler.setCredentialsCacheTtl(0);
+  qDebug() << get(&handler, "alice", "other")
+           << get(&handler, "alice", "other") << authenticator._calls;
+  return 0;
+}
@@ -0,0 +1,50 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <QElapsedTimer>
+#include <QtDebug>
+#include <type_traits>
+
+/** Run f() once and print name, count, unit and elapsed ms, followed by f()
+ * result if any (which is meant to keep the compiler from optimizing the
+ * work away), e.g. "  persistAll 2000 objects: 12 ms".
+ * @return elapsed ms */
+template<typename F>
+inline qint64 bench(const char *name, qint64 count, const char *unit, F f) {
+  QElapsedTimer timer;
+  timer.start();
+  if constexpr (std::is_void_v<decltype(f())>) {
+    f();
+    auto elapsed = timer.elapsed();
+    qDebug().noquote() << name << count << unit << elapsed << "ms";
+    return elapsed;
+  } else {
+    auto result = f();
+    auto elapsed = timer.elapsed();
+    qDebug().noquote() << name << count << unit << elapsed << "ms" << result;
+    return elapsed;
+  }
+}
+
+// one function per benchmark, count meaning depends on benchmark
+void benchUtf8String(qint64 count);
+void benchWorld(qint64 count);
+void benchSqlObjectsStore(qint64 count);
+void benchInMemoryRulesAuthorizer(qint64 count);
+void benchInMemoryAuthenticator(qint64 count);
+void benchXlsxWriter(qint64 count);
+
+#endif // BENCH_H
@@ -0,0 +1,34 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+#include "auth/inmemoryauthenticator.h"
+
+void benchInMemoryAuthenticator(qint64 count) {
+  InMemoryAuthenticator authenticator;
+  authenticator.insertUser("carol",
+                           InMemoryAuthenticator::encodePbkdf2Sha256("secret"),
+                           InMemoryAuthenticator::Pbkdf2Sha256);
+  bench("  pbkdf2 success", count, "authentications:", [&]() {
+    for (qint64 i = 0; i < count; ++i)
+      authenticator.authenticate("carol", "secret");
+  });
+  bench("  pbkdf2 failure", count, "authentications:", [&]() {
+    for (qint64 i = 0; i < count; ++i)
+      authenticator.authenticate("carol", "wrong"+QString::number(i));
+  });
+  bench("  cached failure", count, "authentications:", [&]() {
+    for (qint64 i = 0; i < count; ++i)
+      authenticator.authenticate("carol", "wrong0");
+  });
+}
@@ -0,0 +1,34 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+#include "auth/inmemoryrulesauthorizer.h"
+#include "auth/inmemoryusersdatabase.h"
+
+void benchInMemoryRulesAuthorizer(qint64 count) {
+  InMemoryUsersDatabase db;
+  db.insertUser("bob", { "reader" });
+  db.insertUser("carol", { "reader", "writer" });
+  InMemoryRulesAuthorizer authorizer(&db);
+  authorizer.deny("reader", "DELETE");
+  for (int i = 0; i < 100; ++i)
+    authorizer.allow("writer", "PUT|POST", "^/data/"+QString::number(i)+"/");
+  authorizer.allow("reader", "GET|HEAD").deny();
+  bench("  authorize", count, "authorizations:", [&]() {
+    qint64 allowed = 0;
+    for (qint64 i = 0; i < count; ++i)
+      allowed += authorizer.authorize(
+            "carol", "POST", "/data/"+QString::number(i%200)+"/foo");
+    return allowed;
+  });
+}
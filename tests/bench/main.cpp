@@ -0,0 +1,53 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+#include "log/log.h"
+#include <QCoreApplication>
+
+static const struct {
+  const char *name;
+  qint64 defaultCount;
+  void (*run)(qint64 count);
+} _benches[] = {
+  { "utf8string", 1000, benchUtf8String }, // input repetitions
+  { "world", 10'000'000, benchWorld }, // triplets
+  { "sqlobjectsstore", 2000, benchSqlObjectsStore }, // objects
+  { "inmemoryrulesauthorizer", 1'000'000,
+    benchInMemoryRulesAuthorizer }, // authorizations
+  { "inmemoryauthenticator", 10, benchInMemoryAuthenticator }, // logins
+  { "xlsxwriter", 1'000'000, benchXlsxWriter }, // rows
+};
+
+// usage: bench [name [count]], runs every benchmark when no name is given
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  bool found = false;
+  for (const auto &entry: _benches) {
+    if (argc > 1 && qstrcmp(argv[1], entry.name))
+      continue;
+    found = true;
+    qDebug() << entry.name;
+    entry.run(argc > 2 ? QByteArray(argv[2]).toLongLong()
+                       : entry.defaultCount);
+  }
+  if (!found) {
+    qDebug() << "usage:" << argv[0] << "[name [count]], with name among:";
+    for (const auto &entry: _benches)
+      qDebug() << " " << entry.name;
+    return 1;
+  }
+  return 0;
+}
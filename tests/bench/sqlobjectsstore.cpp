@@ -0,0 +1,71 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+#include "ostore/sqlobjectsstore.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QSqlQuery>
+
+class Item : public QObject {
+  Q_OBJECT
+  Q_PROPERTY(int id MEMBER _id NOTIFY idChanged)
+  Q_PROPERTY(QString name MEMBER _name NOTIFY nameChanged)
+  Q_PROPERTY(int count MEMBER _count NOTIFY countChanged)
+  int _id = 0, _count = 0;
+  QString _name;
+
+public:
+  Q_INVOKABLE Item(QObject *parent) : QObject(parent) { }
+
+signals:
+  void idChanged();
+  void nameChanged();
+  void countChanged();
+};
+
+void benchSqlObjectsStore(qint64 count) {
+  QTemporaryDir dir;
+  {
+    auto db = QSqlDatabase::addDatabase("QSQLITE", "bench");
+    db.setDatabaseName(dir.filePath("bench.db"));
+    db.open();
+    QSqlQuery(db).exec("create table items (id integer primary key, "
+                       "name text, count integer)");
+    SqlObjectsStore store(&Item::staticMetaObject, db);
+    QList<QObject*> items;
+    while (items.size() < count)
+      items.append(store.create({ { "name", "" }, { "count", 0 } }).object());
+    bench("  persist every change", count, "objects:", [&]() {
+      for (int i = 0; i < count; ++i) {
+        items[i]->setProperty("count", i+1);
+        store.persist(items[i]);
+        items[i]->setProperty("name", "x"+QString::number(i));
+        store.persist(items[i]);
+      }
+    });
+    bench("  coalesced flush     ", count, "objects:", [&]() {
+      for (int i = 0; i < count; ++i) {
+        items[i]->setProperty("count", i+2);
+        items[i]->setProperty("name", "y"+QString::number(i));
+      }
+      QCoreApplication::processEvents();
+    });
+    bench("  persistAll          ", count, "objects:", [&]() {
+      store.persistAll();
+    });
+  }
+  QSqlDatabase::removeDatabase("bench");
+}
+
+#include "sqlobjectsstore.moc"
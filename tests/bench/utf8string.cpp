@@ -0,0 +1,53 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+#include "util/utf8kernels.h"
+#include "util/utf8string.h"
+
+// repeat f(input) during about one second, then print throughput
+template<typename F>
+static void throughput(const char *name, const Utf8String &input, F f) {
+  QElapsedTimer timer;
+  qsizetype n = 0, total = 0;
+  timer.start();
+  for (; timer.elapsed() < 1000; ++n)
+    total += f(input);
+  auto mbps = double(input.size())*n/timer.nsecsElapsed()*1e3;
+  qDebug().noquote() << name << input.size() << "bytes:" << mbps << "MB/s"
+                     << total;
+}
+
+void benchUtf8String(qint64 count) {
+  Utf8String ascii =
+      "The quick brown fox jumps over the lazy dog 0123456789 @[`{ "_u8
+      .repeated(40*count);
+  Utf8String mixed =
+      ("a\u00e9\u00c9b\u20ac\u00a2\u03c3 quick BROWN fox \xef\xbb\xbf"_u8)
+      .repeated(40*count);
+  for (const auto &[label, input] : { std::pair{"ascii", ascii},
+                                      std::pair{"mixed", mixed} }) {
+    qDebug() << label;
+    throughput("  utf8size", input, [](const Utf8String &s) {
+      return s.utf8size(); });
+    throughput("  toUpper ", input, [](const Utf8String &s) {
+      return s.toUpper().size(); });
+    throughput("  toLower ", input, [](const Utf8String &s) {
+      return s.toLower().size(); });
+    throughput("  cleaned ", input, [](const Utf8String &s) {
+      return s.cleaned().size(); });
+    throughput("  validate", input, [](const Utf8String &s) {
+      return p6::utf8::valid_prefix_size(s.constData(),
+                                         s.constData()+s.size()); });
+  }
+}
@@ -0,0 +1,63 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+#include "eg/world.h"
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+
+using namespace p6;
+
+void benchWorld(qint64 count) {
+  const quint64 n = count, first = 0x10000, entities = n/8+1, predicates = 16;
+  auto random = QRandomGenerator(42);
+  auto any_entity = [&]() { return first+random.bounded(entities); };
+  auto any_predicate = [&]() {
+    return first+entities+random.bounded(predicates); };
+  QTemporaryDir dir;
+  World big;
+  bench("  insert    ", n, "triplets:", [&]() {
+    for (quint64 i = 0; i < n; ++i) {
+      big.add(any_entity(), first+entities+i%predicates,
+              Entity{any_entity()});
+      if (i % 1'000'000 == 999'999)
+        big.commit();
+    }
+    return big.commit().size();
+  });
+  bench("  write file", n, "triplets:", [&]() {
+    big.open(dir.filePath("big"));
+  });
+  World mapped;
+  WorldView wv;
+  bench("  open file ", n, "triplets:", [&]() {
+    mapped.open(dir.filePath("big"));
+    wv = mapped.view();
+    return wv.size();
+  });
+  const int lookups = 1'000'000;
+  auto lookup = [&](const char *name, auto f) {
+    bench(name, lookups, "lookups:", [&]() {
+      quint64 total = 0;
+      for (int i = 0; i < lookups; ++i)
+        total += f();
+      return total;
+    });
+  };
+  lookup("  s,p,*", [&]() {
+    return wv.match(any_entity(), any_predicate()).size(); });
+  lookup("  *,p,o", [&]() {
+    return wv.match(0, any_predicate(), any_entity()).size(); });
+  lookup("  *,*,o", [&]() { return wv.match(0, 0, any_entity()).size(); });
+  lookup("  kinds", [&]() { return wv.kinds(any_entity()).size(); });
+}
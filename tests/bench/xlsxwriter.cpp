@@ -0,0 +1,59 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench.h"
+#include "format/xlsxwriter.h"
+#include <QDate>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+void benchXlsxWriter(qint64 count) {
+  const QDate date(2023, 1, 1);
+  QTemporaryDir dir;
+  auto archive = dir.filePath("bench.xlsx");
+  // appending and total (i.e. including archive writing) durations
+  auto write = [&](const char *name, auto append) {
+    QElapsedTimer timer;
+    timer.start();
+    XlsxWriter writer(dir.filePath("workdir"));
+    append(writer);
+    auto appended = timer.elapsed();
+    writer.write(archive);
+    qDebug().noquote() << name << count << "rows:" << appended
+                       << "ms appending" << timer.elapsed() << "ms total"
+                       << QFileInfo(archive).size() << "bytes";
+  };
+  write("  appendRow    ", [&](XlsxWriter &writer) {
+    for (qint64 i = 0; i < count; ++i)
+      writer.appendRow({ i, "label"+QString::number(i%100), i*.5, date,
+                         "id"+QString::number(i) });
+  });
+  write("  appendColumns", [&](XlsxWriter &writer) {
+    const qint64 batch = 10'000;
+    for (qint64 i = 0; i < count; i += batch) {
+      QList<qint64> ints;
+      Utf8StringList labels;
+      QList<double> doubles;
+      QList<QDate> dates;
+      XlsxWriter::InlineStrings ids;
+      for (qint64 j = i; j < i+batch && j < count; ++j) {
+        ints << j;
+        labels << "label"+Utf8String::number(j%100);
+        doubles << j*.5;
+        dates << date;
+        ids << "id"+Utf8String::number(j);
+      }
+      writer.appendColumns({ ints, labels, doubles, dates, ids });
+    }
+  });
+}
@@ -18,10 +18,63 @@
 #include <QtDebug>
 #include <QCoreApplication>
 #include <QDateTime>
+#include <QFileInfo>
 #include <QTimer>
 
 int main(int, char **) {
   CsvFile f;
   f.open("./file1.csv", QIODevice::ReadOnly);
   qDebug() << f.columnCount() << f.rowCount() << f.cell(0, 0) << f.cell(0, 1) << f.cell(1, 0) << f.cell(1,1) << f.cell(3,0) << f.cell(3,1) << f.cell(4,0);
+  QFile::remove("./journaled.csv");
+  QFile::remove("./journaled.csv.journal");
+  CsvFile j;
+  j.enableJournaling().setCompactionThreshold(4);
+  j.open("./journaled.csv", QIODevice::ReadWrite);
+  j.setHeaders({"name", "age"});
+  j.appendRow({"John", "40"});
+  j.appendRow({"Billy", "8"});
+  j.updateRow(0, {"John", "41"});
+  j.insertRow(0, {"James,Harry", "72"});
+  j.appendRow({"Drop\nTable", ""});
+  j.close();
+  j.open(QIODevice::ReadOnly);
+  qDebug() << j.rowCount() << j.row(0) << j.row(1) << j.row(3)
+           << QFile::exists("./journaled.csv.journal");
+  j.open(QIODevice::ReadWrite);
+  j.removeRows(0, 1);
+  j.close();
+  j.open(QIODevice::ReadOnly);
+  qDebug() << j.rowCount() << j.row(0) << j.row(1);
+  // a file written by another tool without final newline loses nothing...
+  QFile::remove("./journaled.csv.appending");
+  QFile raw("./journaled.csv");
+  raw.open(QIODevice::WriteOnly|QIODevice::Truncate);
+  raw.write("name,age\nJohn,40\nBilly,8");
+  raw.close();
+  j.open(QIODevice::ReadWrite);
+  qDebug() << j.rowCount() << j.row(1);
+  j.appendRow({"Jim", "12"});
+  j.close();
+  j.open(QIODevice::ReadOnly);
+  qDebug() << j.rowCount() << j.row(1) << j.row(2)
+           << QFile::exists("./journaled.csv.appending");
+  j.close();
+  // ...but an interrupted append session leaves a torn row which is dropped
+  raw.open(QIODevice::WriteOnly|QIODevice::Append);
+  raw.write("Jo");
+  raw.close();
+  QFile marker("./journaled.csv.appending");
+  marker.open(QIODevice::WriteOnly);
+  marker.close();
+  j.open(QIODevice::ReadWrite);
+  qDebug() << j.rowCount() << j.row(2) << QFileInfo(raw).size();
+  j.close();
+  CsvFile b;
+  b.enableHeaders(false).openReadonly(QByteArray("a\\,b,\"c,d\"\r\ne,f"));
+  qDebug() << b.rowCount() << b.row(0) << b.row(1);
+  QFile::remove("./file1.csv.index");
+  CsvFile l;
+  l.enableLazyLoading().open("./file1.csv", QIODevice::ReadOnly);
+  qDebug() << l.rowCount() << l.columnCount() << l.cell(1, 0) << l.cell(3, 0)
+           << QFile::exists("./file1.csv.index");
 }
@@ -0,0 +1,78 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "util/datacache.h"
+#include "log/log.h"
+#include <QCoreApplication>
+#include <QtDebug>
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  // concurrent misses on the same keys: creator() called once per key
+  ShardedDataCache<int,QString> cache { 1024 };
+  std::atomic<int> calls[64];
+  for (auto &c: calls)
+    c = 0;
+  std::atomic<int> wrong_values = 0;
+  QList<QThread*> threads;
+  for (int i = 0; i < 8; ++i)
+    threads.append(QThread::create([&]() {
+      for (int key = 0; key < 64; ++key) {
+        auto value = cache.get_or_create(key, [&calls,key]() {
+          ++calls[key];
+          QThread::msleep(2); // widen the race window
+          return QString::number(key);
+        });
+        if (value != QString::number(key))
+          ++wrong_values;
+      }
+    }));
+  for (auto thread: threads)
+    thread->start();
+  for (auto thread: threads) {
+    thread->wait();
+    delete thread;
+  }
+  int created_once = 0;
+  for (auto &c: calls)
+    created_once += c == 1;
+  auto stats = cache.stats();
+  qDebug() << created_once << wrong_values << stats.hits << stats.misses
+           << stats.evictions;
+  // creator() may ask for another key
+  qDebug() << cache.get_or_create(1000, [&cache]() {
+    return "1000 then "+cache.get_or_create(1001, []() {
+      return QString("1001"); });
+  }) << cache.get_or_create(1001, []() { return QString(); });
+  // capacity: maxCost/Shards per shard
+  ShardedDataCache<int,int,4> small { 8 };
+  for (int key = 0; key < 100; ++key)
+    small.get_or_create(key, [key]() { return key; });
+  stats = small.stats();
+  qDebug() << stats.misses << stats.evictions;
+  // capacity with a cost function, a value costing more than maxCost is
+  // returned but not kept
+  ShardedDataCache<int,QByteArray,1> costly {
+    10, [](const QByteArray &value) { return value.size(); } };
+  for (int key = 0; key < 5; ++key)
+    costly.get_or_create(key, []() { return QByteArray(4, 'x'); });
+  qDebug() << costly.get_or_create(5, []() { return QByteArray(11, 'x'); })
+              .size();
+  costly.get_or_create(4, []() { return QByteArray(); }); // hit
+  costly.get_or_create(5, []() { return QByteArray(); }); // miss
+  stats = costly.stats();
+  qDebug() << stats.misses << stats.evictions << stats.hits;
+  return 0;
+}
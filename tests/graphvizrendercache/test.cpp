@@ -0,0 +1,104 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "format/graphvizrendercache.h"
+#include "log/log.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtDebug>
+#include <atomic>
+
+static QString stats(const GraphvizRenderCache &cache) {
+  auto s = cache.stats();
+  return QString("hits=%1 disk_hits=%2 misses=%3 failures=%4 coalesced=%5")
+      .arg(s.hits).arg(s.disk_hits).arg(s.misses).arg(s.failures)
+      .arg(s.coalesced);
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  int renders = 0;
+  auto render = [&renders](const Utf8String &output, bool ok = true) {
+    return [&renders, output, ok](bool *success) {
+      ++renders;
+      *success = ok;
+      return output;
+    };
+  };
+  auto k1 = GraphvizRenderCache::key("digraph { a -> b }",
+                                     GraphvizRenderer::Dot,
+                                     GraphvizRenderer::Svg);
+  auto k2 = GraphvizRenderCache::key("digraph { a -> b }",
+                                     GraphvizRenderer::Dot,
+                                     GraphvizRenderer::Png);
+  auto k3 = GraphvizRenderCache::key("digraph { a -> c }",
+                                     GraphvizRenderer::Dot,
+                                     GraphvizRenderer::Svg);
+  qDebug() << (k1 != k2) << (k1 != k3) << (k1 == GraphvizRenderCache::key(
+               "digraph { a -> b }", GraphvizRenderer::Dot,
+               GraphvizRenderer::Svg));
+  // miss then hit, failures are not cached
+  GraphvizRenderCache cache(10);
+  bool success;
+  qDebug() << cache.get_or_render(k1, render("svg1")) << cache.get_or_render(
+                k1, render("other")) << renders << stats(cache);
+  qDebug() << cache.get_or_render(k2, render("", false), &success) << success
+           << cache.get_or_render(k2, render("", false), &success) << success
+           << renders << stats(cache);
+  // memory bound evicts least recently used
+  cache.get_or_render(k2, render("png1!!!"));
+  qDebug() << cache.get_or_render(k1, render("svg2")) << renders
+           << stats(cache);
+  // spill directory keeps outputs beyond memory eviction and across caches
+  QTemporaryDir dir;
+  {
+    GraphvizRenderCache spilling(10, dir.filePath("spill"));
+    spilling.get_or_render(k3, render("svg3"));
+    spilling.clear();
+    qDebug() << spilling.get_or_render(k3, render("other")) << renders
+             << stats(spilling);
+  }
+  GraphvizRenderCache reopened(10, dir.filePath("spill"));
+  qDebug() << reopened.get_or_render(k3, render("other"))
+           << reopened.get_or_render(k3, render("other")) << renders
+           << stats(reopened);
+  // concurrent renderings of the same key run only once, the rendering
+  // thread waiting until every other one is waiting for it
+  GraphvizRenderCache concurrent;
+  std::atomic<int> concurrent_renders = 0, same_outputs = 0;
+  const int threads_count = 8;
+  QList<QThread*> threads;
+  for (int i = 0; i < threads_count; ++i)
+    threads.append(QThread::create([&]() {
+      auto output = concurrent.get_or_render(k1, [&](bool *success) {
+        ++concurrent_renders;
+        while (concurrent.stats().coalesced < threads_count-1)
+          QThread::msleep(1);
+        *success = true;
+        return "svg4"_u8;
+      });
+      if (output == "svg4")
+        ++same_outputs;
+    }));
+  for (auto thread: threads)
+    thread->start();
+  for (auto thread: threads)
+    thread->wait();
+  qDeleteAll(threads);
+  qDebug() << concurrent_renders.load() << same_outputs.load()
+           << stats(concurrent);
+  return 0;
+}
@@ -0,0 +1,188 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "httpd/httpserver.h"
+#include "httpd/graphvizimagehttphandler.h"
+#include "log/log.h"
+#include <QCoreApplication>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QEventLoop>
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <QtDebug>
+#include <functional>
+
+// stands for graphviz dot: outputs its source after a while, fails with a
+// "syntax error" on sources containing "error", and logs every rendering
+static const char *fakeDot =
+    "#!/bin/sh\n"
+    "src=$(cat)\n"
+    "printf '%s\\n' \"$src\" >> \"$(dirname \"$0\")/renders\"\n"
+    "sleep 0.3\n"
+    "case \"$src\" in *error*) echo 'syntax error' >&2; exit 1;; esac\n"
+    "printf '%s' \"$src\"\n";
+
+static QtMessageHandler previousMessageHandler;
+
+// hide GraphvizRenderer's own messages, they contain timings
+static void messageHandler(QtMsgType type, const QMessageLogContext &context,
+                           const QString &msg) {
+  if (!msg.startsWith("graphviz rendering process"))
+    previousMessageHandler(type, context, msg);
+}
+
+// run action then count contentChanged() signals during millis ms
+static int contentChanges(ImageHttpHandler *handler,
+                          std::function<void()> action, int millis = 1500) {
+  int count = 0;
+  QEventLoop loop;
+  QObject::connect(handler, &ImageHttpHandler::contentChanged,
+                   &loop, [&count]() { ++count; });
+  QTimer::singleShot(millis, &loop, &QEventLoop::quit);
+  action();
+  loop.exec();
+  return count;
+}
+
+// handler that does not return etag along with image, relying on etag()
+class StaticImageHttpHandler : public ImageHttpHandler {
+public:
+  StaticImageHttpHandler() : ImageHttpHandler("/static") { }
+  QByteArray imageData(HttpRequest &, ParamsProviderMerger &, int,
+                       QByteArray *) override {
+    return "static image"; }
+  QByteArray contentType(
+      HttpRequest &, ParamsProviderMerger &) const override {
+    return "text/plain"; }
+  QByteArray etag(HttpRequest &, ParamsProviderMerger &) const override {
+    return "\"static\""; }
+};
+
+// @return status code, ETag header and body
+static QList<QByteArray> get(quint16 port, const QByteArray &path,
+                             const QByteArray &ifNoneMatch = {}) {
+  QTcpSocket socket;
+  socket.connectToHost(QHostAddress::LocalHost, port);
+  if (!socket.waitForConnected(5000))
+    return { "cannot connect" };
+  socket.write("GET "+path+" HTTP/1.1\r\nHost: localhost\r\n"
+               +(ifNoneMatch.isNull()
+                 ? "" : "If-None-Match: "+ifNoneMatch+"\r\n")+"\r\n");
+  while (socket.state() == QAbstractSocket::ConnectedState)
+    socket.waitForReadyRead(5000);
+  auto response = socket.readAll();
+  auto i = response.indexOf("\r\n\r\n");
+  QByteArray etag;
+  for (auto line: response.left(i).split('\n'))
+    if (line.toLower().startsWith("etag:"))
+      etag = line.mid(5).trimmed();
+  return { response.split(' ').value(1), etag, response.mid(i+4) };
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  auto server = new HttpServer(2);
+  auto graphviz = new GraphvizImageHttpHandler;
+  server->appendHandler(new StaticImageHttpHandler);
+  server->appendHandler(graphviz);
+  server->listen(QHostAddress::LocalHost);
+  auto port = server->serverPort();
+  // etag returned along with image data
+  graphviz->setFormat(GraphvizImageHttpHandler::Plain);
+  QByteArray etag;
+  HttpRequest req;
+  ParamsProviderMerger context;
+  qDebug() << graphviz->imageData(req, context, 5000, &etag) << etag.size()
+           << (graphviz->etag(req, context) == etag);
+  // conditional requests
+  auto response = get(port, "/graph");
+  qDebug() << response.value(0) << (response.value(1) == etag)
+           << response.value(2);
+  qDebug() << get(port, "/graph", etag).value(0)
+           << get(port, "/graph", "W/"+etag).value(0)
+           << get(port, "/graph", "\"foo\", "+etag).value(0)
+           << get(port, "/graph", "*").value(0)
+           << get(port, "/graph", "\"foo\"").value(0);
+  // etag changes along with format, previous one no longer matches
+  graphviz->setFormat(GraphvizImageHttpHandler::Svg);
+  response = get(port, "/graph", etag);
+  qDebug() << response.value(0) << (response.value(1) == etag);
+  // fallback to etag() when imageData() does not set it
+  qDebug() << get(port, "/static") << get(port, "/static", "\"static\"");
+  // background rendering, through a fake dot found first in PATH
+  previousMessageHandler = qInstallMessageHandler(messageHandler);
+  QTemporaryDir dir;
+  QFile script(dir.filePath("dot"));
+  script.open(QIODevice::WriteOnly);
+  script.write(fakeDot);
+  script.close();
+  script.setPermissions(QFile::ReadOwner|QFile::WriteOwner|QFile::ExeOwner);
+  qputenv("PATH", dir.path().toUtf8()+":"+qgetenv("PATH"));
+  auto renders = [&dir]() {
+    QFile file(dir.filePath("renders"));
+    file.open(QIODevice::ReadOnly);
+    auto lines = file.readAll().trimmed().split('\n');
+    file.remove();
+    return lines;
+  };
+  graphviz->enableBackgroundRendering();
+  auto before = get(port, "/graph");
+  // last good image is served while a new one is being rendered
+  QList<QByteArray> stale;
+  auto changes = contentChanges(graphviz, [&]() {
+    graphviz->setSource("a");
+    stale = get(port, "/graph");
+  });
+  auto after = get(port, "/graph");
+  qDebug() << (stale == before) << changes << after.value(2)
+           << (after.value(1) != before.value(1))
+           << get(port, "/graph", after.value(1)).value(0)
+           << get(port, "/graph", before.value(1)).value(0) << renders();
+  // setSource() calls during a rendering are merged into one more rendering
+  changes = contentChanges(graphviz, [&]() {
+    graphviz->setSource("b");
+    QThread::msleep(100);
+    graphviz->setSource("c");
+    graphviz->setSource("d");
+    graphviz->setSource("e");
+  });
+  auto last = get(port, "/graph");
+  qDebug() << changes << last.value(2) << renders();
+  // failed rendering keeps last good image and its etag, without signal
+  changes = contentChanges(graphviz, [&]() {
+    graphviz->setSource("error");
+  });
+  qDebug() << changes << (get(port, "/graph") == last)
+           << get(port, "/graph", last.value(1)).value(0) << renders();
+  // failed first rendering is served without etag, thus never 304
+  auto failing = new GraphvizImageHttpHandler;
+  auto server2 = new HttpServer(2);
+  server2->appendHandler(failing);
+  server2->listen(QHostAddress::LocalHost);
+  failing->setFormat(GraphvizImageHttpHandler::Plain);
+  failing->setSource("error");
+  qDebug() << get(server2->serverPort(), "/graph")
+           << get(server2->serverPort(), "/graph", "*").value(0)
+           << failing->etag(req, context).isEmpty();
+  // and background rendering of a good image eventually replaces it
+  failing->enableBackgroundRendering();
+  changes = contentChanges(failing, [&]() { failing->setSource("f"); });
+  response = get(server2->serverPort(), "/graph");
+  qDebug() << changes << response.value(2) << response.value(1).size()
+           << get(server2->serverPort(), "/graph", response.value(1)).value(0);
+  return 0;
+}
@@ -0,0 +1,58 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "auth/inmemoryauthenticator.h"
+#include "log/log.h"
+#include <QElapsedTimer>
+#include <QtDebug>
+
+int main() {
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  InMemoryAuthenticator authenticator;
+  int changes = 0;
+  QObject::connect(&authenticator, &Authenticator::changed,
+                   [&changes]() { ++changes; });
+  // RFC 7914 PBKDF2-HMAC-SHA256 test vector, with OpenLDAP adapted base64
+  authenticator.insertUser(
+        "alice", "{PBKDF2-SHA256}1$c2FsdA$VawEblbjCJ/sFpHCJUS2BflBhSFt3gRl5oud"
+        "V8INrLxJypzM8Xm2RZkWZLOdd.8xfHG4RbHjC9UJESBB06GXgw",
+        InMemoryAuthenticator::OpenLdapStyle);
+  authenticator.insertUser("bob", InMemoryAuthenticator::encodePbkdf2Sha256(
+                             "secret", 1000),
+                           InMemoryAuthenticator::encodingFromString("pbkdf2"));
+  qDebug() << authenticator.authenticate("alice", "passwd")
+           << authenticator.authenticate("alice", "password")
+           << authenticator.authenticate("bob", "secret")
+           << authenticator.authenticate("bob", "Secret") << changes;
+  authenticator.clearUsers();
+  qDebug() << authenticator.authenticate("bob", "secret") << changes
+           << InMemoryAuthenticator::encodingToString(
+                InMemoryAuthenticator::Pbkdf2Sha256);
+  // failed slow authentications are remembered, until users change
+  authenticator.insertUser("dave", InMemoryAuthenticator::encodePbkdf2Sha256(
+                             "secret", 200'000),
+                           InMemoryAuthenticator::Pbkdf2Sha256);
+  QElapsedTimer elapsed;
+  elapsed.start();
+  auto first = authenticator.authenticate("dave", "Secret");
+  auto derivation = elapsed.restart();
+  auto second = authenticator.authenticate("dave", "Secret");
+  auto cached = elapsed.elapsed();
+  authenticator.insertUser("dave", InMemoryAuthenticator::encodePbkdf2Sha256(
+                             "Secret", 1000),
+                           InMemoryAuthenticator::Pbkdf2Sha256);
+  qDebug() << first << second << (cached*4 < derivation)
+           << authenticator.authenticate("dave", "Secret");
+  return 0;
+}
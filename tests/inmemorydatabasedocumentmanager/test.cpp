@@ -0,0 +1,109 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "sql/inmemorydatabasedocumentmanager.h"
+#include "modelview/shareduiitemdocumenttransaction.h"
+#include "modelview/genericshareduiitem.h"
+#include "log/log.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QSqlQuery>
+#include <QtDebug>
+
+static GenericSharedUiItem item(const char *id, const char *value) {
+  return GenericSharedUiItem("generic"_u8, Utf8String(id), { "id", "value" },
+                             { id, value });
+}
+
+static void registerTypes(InMemoryDatabaseDocumentManager *dm) {
+  dm->registerItemType(
+        "generic"_u8, &GenericSharedUiItem::setUiData<0>,
+        [](const Utf8String &id) {
+    return GenericSharedUiItem("generic"_u8, id, { "id", "value" },
+                               { id.toString() });
+  }, 0);
+}
+
+// rows as written in database, followed by items as held in memory
+static void dump(QSqlDatabase db, const InMemoryDatabaseDocumentManager &dm) {
+  QStringList rows, items;
+  QSqlQuery query("select id, value from generic order by id", db);
+  while (query.next())
+    rows.append(query.value(0).toString()+"="+query.value(1).toString());
+  for (auto item: dm.itemsByQualifier("generic"_u8))
+    items.append(item.id().toString()+"="+item.uiString(1));
+  items.sort();
+  qDebug() << rows.join(' ') << items.join(' ');
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  QTemporaryDir dir;
+  auto db = QSqlDatabase::addDatabase("QSQLITE");
+  db.setDatabaseName(dir.filePath("test.db"));
+  db.open();
+  InMemoryDatabaseDocumentManager dm(db);
+  registerTypes(&dm);
+  QString errorString;
+  // a committed batch persists every item
+  {
+    SharedUiItemDocumentTransaction t(&dm);
+    t.changeItem(item("a", "1"), {}, "generic"_u8, &errorString);
+    t.changeItem(item("b", "2"), {}, "generic"_u8, &errorString);
+    t.changeItem(item("c", "3"), {}, "generic"_u8, &errorString);
+    t.changeItem(item("c", "4"), item("c", "3"), "generic"_u8, &errorString);
+    t.redo();
+  }
+  dump(db, dm);
+  // changes already written under savepoints are rolled back with the
+  // pending database transaction when the document transaction is dropped
+  {
+    SharedUiItemDocumentTransaction t(&dm);
+    t.changeItem(item("a", "10"), item("a", "1"), "generic"_u8, &errorString);
+    t.changeItem({}, item("b", "2"), "generic"_u8, &errorString);
+    t.changeItem(item("d", "5"), {}, "generic"_u8, &errorString);
+  }
+  dump(db, dm);
+  // a change prepared by a dropped transaction does not leak into next one
+  {
+    SharedUiItemDocumentTransaction dropped(&dm);
+    dropped.changeItem(item("e", "6"), {}, "generic"_u8, &errorString);
+    SharedUiItemDocumentTransaction t(&dm);
+    t.changeItem(item("f", "7"), {}, "generic"_u8, &errorString);
+    t.redo();
+  }
+  dump(db, dm);
+  // update of a row missing in database falls back to delete and insert
+  QSqlQuery(db).exec("delete from generic where id = 'b'");
+  dump(db, dm);
+  qDebug() << dm.changeItem(item("b", "20"), dm.itemById("generic"_u8, "b"_u8),
+                            "generic"_u8, &errorString);
+  dump(db, dm);
+  // undo is written to database too, in its own database transaction
+  {
+    SharedUiItemDocumentTransaction t(&dm);
+    t.changeItem(item("a", "30"), item("a", "1"), "generic"_u8, &errorString);
+    t.changeItem({}, item("f", "7"), "generic"_u8, &errorString);
+    t.redo();
+    dump(db, dm);
+    t.undo();
+    dump(db, dm);
+  }
+  // another manager reloads what was persisted
+  InMemoryDatabaseDocumentManager reloaded(db);
+  registerTypes(&reloaded);
+  dump(db, reloaded);
+  return 0;
+}
@@ -0,0 +1,51 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "auth/inmemoryrulesauthorizer.h"
+#include "auth/inmemoryusersdatabase.h"
+#include "log/log.h"
+#include <QtDebug>
+
+int main() {
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  InMemoryUsersDatabase db;
+  db.insertUser("alice", { "admin" });
+  db.insertUser("bob", { "reader" });
+  db.insertUser("carol", { "reader", "writer" });
+  InMemoryRulesAuthorizer authorizer(&db);
+  authorizer.deny("reader", "POST", "^/secret")
+      .allow("reader", "GET|HEAD")
+      .allow("writer", "POST", "^/data/")
+      .allow("admin")
+      .deny();
+  // first rule matching action scope but not data scope, then next ones
+  qDebug() << authorizer.authorize("bob", "GET", "/x")
+           << authorizer.authorize("bob", "POST", "/data/1")
+           << authorizer.authorize("carol", "POST", "/data/1")
+           << authorizer.authorize("carol", "POST", "/secret/1")
+           << authorizer.authorize("carol", "GET", "/secret")
+           << authorizer.authorize("carol", "POST", "/other");
+  qDebug() << authorizer.authorize("alice", "DELETE", "/x")
+           << authorizer.authorize("dave", "GET", "/x")
+           << authorizer.authorize("bob", "GET", "/x"); // cached
+  // cached decisions are not used anymore once rules change
+  authorizer.prependRule({ "reader" }, QRegularExpression("GET"),
+                         QRegularExpression(), QRegularExpression(), false);
+  qDebug() << authorizer.authorize("bob", "GET", "/x")
+           << authorizer.authorize("carol", "GET", "/x")
+           << authorizer.authorize("alice", "GET", "/x");
+  authorizer.clearRules();
+  qDebug() << authorizer.authorize("alice", "GET", "/x");
+  return 0;
+}
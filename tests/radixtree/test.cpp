@@ -13,7 +13,9 @@
  */
 
 #include <QtDebug>
-#include "util/radixtree.h"
+#include "util/frozenradixtree.h"
+#include "util/concurrentradixtree.h"
+#include <QThread>
 #include <functional>
 #include <string>
 
@@ -39,5 +41,54 @@ int main(int, char **) {
   qDebug().noquote() << rt5.toDebugString();
   RadixTree<int> rt6 { { "!foo", 1 }, { "", 7, true } };
   qDebug().noquote() << rt6.toDebugString();
+  FrozenRadixTree<int> frt5 { rt5 };
+  qDebug().noquote() << frt5.toDebugString();
+  for (auto key : { "foo", "fo", "f", "fxx", "bar", "barx", "", "x" }) {
+    int ml1 = -1, ml2 = -1;
+    auto v1 = rt5.value(key, -1, &ml1), v2 = frt5.value(key, -1, &ml2);
+    qDebug() << "frozen lookup" << key << v1 << ml1 << v2 << ml2
+             << (v1 == v2 && ml1 == ml2 ? "ok" : "KO");
+  }
+  FrozenRadixTree<int> frt7 {
+    { "/rest/customers/", 1, true }, { "/rest/customers/count", 2 },
+    { "/rest/a_rather_long_path_not_inlined/", 3, true }, { "\xc3\xa9t\xc3\xa9", 4 },
+  };
+  qDebug().noquote() << frt7.toDebugString();
+  qDebug() << "frozen lookup" << frt7.value("/rest/customers/434909", -1)
+           << frt7.value("/rest/customers/count", -1)
+           << frt7.value("/rest/a_rather_long_path_not_inlined/42", -1)
+           << frt7.value("\xc3\xa9t\xc3\xa9", -1)
+           << frt7.value("/rest/", -1);
+  ConcurrentRadixTree<int> crt5 { rt5 };
+  crt5.insert("foobar", 5);
+  crt5.insert("fa", 6, true);
+  for (auto key : { "foo", "fo", "f", "fxx", "foobar", "fab", "bar" }) {
+    int ml = -1;
+    auto v = crt5.value(key, -1, &ml);
+    qDebug() << "concurrent lookup" << key << v << ml;
+  }
+  ConcurrentRadixTree<QByteArray> crt8;
+  QAtomicInt stop, mismatches;
+  QList<QThread*> readers;
+  for (int i = 0; i < 4; ++i) // several readers, on distinct counters stripes
+    readers.append(QThread::create([&]() {
+      while (!stop.loadAcquire()) {
+        auto v = crt8.value("key7");
+        if (!v.isEmpty() && v != "value7")
+          mismatches.ref();
+      }
+    }));
+  for (auto reader: readers)
+    reader->start();
+  for (int i = 0; i < 1000; ++i)
+    crt8.insert("key"+QByteArray::number(i%10),
+                "value"+QByteArray::number(i%10));
+  stop.storeRelease(1);
+  for (auto reader: readers) {
+    reader->wait();
+    delete reader;
+  }
+  qDebug() << "concurrent insertions" << crt8.keys().size() << crt8["key7"]
+           << "mismatches:" << mismatches.loadRelaxed();
   return 0;
 }
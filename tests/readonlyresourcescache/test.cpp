@@ -0,0 +1,168 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "io/readonlyresourcescache.h"
+#include "log/log.h"
+#include <QCoreApplication>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <QTemporaryDir>
+#include <QUrl>
+#include <QFile>
+#include <QtDebug>
+#include <functional>
+
+// Cache-Control header served for each path
+static const QHash<QByteArray,QByteArray> _cacheControls {
+  { "/fresh", "max-age=1, stale-while-revalidate=1" },
+  { "/nocache", "stale-while-revalidate=60, no-cache" },
+  { "/nostore", "no-store" },
+  { "/swr", "max-age=0, stale-while-revalidate=60" },
+  { "/default", "" },
+};
+
+// process events until condition is met, for at most 5 seconds
+static void processEventsUntil(std::function<bool()> condition) {
+  auto deadline = QDateTime::currentMSecsSinceEpoch()+5000;
+  while (!condition() && QDateTime::currentMSecsSinceEpoch() < deadline)
+    QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+}
+
+// cached resources paths, most recently used first
+static QList<QByteArray> lruPaths(ReadOnlyResourcesCache &cache) {
+  QList<QByteArray> paths;
+  for (auto line: cache.asDebugString().split('\n'))
+    if (line.contains(" fresh until: "))
+      paths << QUrl(line.trimmed().section(' ', 0, 0).chopped(1)).path()
+               .toUtf8();
+  return paths;
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  QTcpServer server;
+  server.listen(QHostAddress::LocalHost);
+  int hits = 0;
+  QObject::connect(&server, &QTcpServer::newConnection, [&]() {
+    auto socket = server.nextPendingConnection();
+    QObject::connect(socket, &QTcpSocket::readyRead, [&hits,socket]() {
+      auto request = socket->peek(socket->bytesAvailable());
+      if (!request.contains("\r\n\r\n"))
+        return;
+      socket->readAll();
+      auto path = request.split(' ').value(1);
+      auto body = path.mid(1)+" "+QByteArray::number(++hits);
+      auto cacheControl = _cacheControls.value(path);
+      auto respond = [socket,body,cacheControl]() {
+        socket->write("HTTP/1.1 200 OK\r\nConnection: close\r\n"
+                      "Content-Length: "+QByteArray::number(body.size())+"\r\n"
+                      +(cacheControl.isEmpty()
+                        ? "" : "Cache-Control: "+cacheControl+"\r\n")
+                      +"\r\n"+body);
+        socket->disconnectFromHost();
+      };
+      if (path == "/slow") // let concurrent fetchers pile up
+        QTimer::singleShot(500, socket, respond);
+      else
+        respond();
+    });
+    QObject::connect(socket, &QTcpSocket::disconnected,
+                     socket, &QTcpSocket::deleteLater);
+  });
+  auto url = [&server](const char *path) {
+    return "http://127.0.0.1:"+QString::number(server.serverPort())+path;
+  };
+  ReadOnlyResourcesCache cache;
+  // fresh, then stale (still served), then expired
+  qDebug() << cache.fetchResource(url("/fresh"), 5000)
+           << cache.fetchResourceFromCache(url("/fresh"), false);
+  QThread::msleep(1200);
+  qDebug() << cache.fetchResourceFromCache(url("/fresh"), false);
+  QThread::msleep(1200);
+  qDebug() << cache.fetchResourceFromCache(url("/fresh"), false).isNull();
+  // no-cache and no-store: only given to the caller waiting for the fetch
+  qDebug() << cache.fetchResource(url("/nocache"), 5000)
+           << cache.fetchResourceFromCache(url("/nocache"), false).isNull()
+           << cache.fetchResource(url("/nostore"), 5000)
+           << cache.fetchResourceFromCache(url("/nostore"), false).isNull()
+           << cache.asDebugString().contains("/nostore");
+  // max-age=0 with stale-while-revalidate: stale at once, but served
+  qDebug() << cache.fetchResource(url("/swr"), 5000)
+           << cache.fetchResourceFromCache(url("/swr"), false);
+  // no Cache-Control: default max-age
+  qDebug() << cache.fetchResource(url("/default"), 5000)
+           << cache.fetchResourceFromCache(url("/default"), false) << hits;
+  // stale-while-revalidate: stale resource returned at once, then refreshed
+  auto stale = cache.fetchResource(url("/swr"), 5000);
+  processEventsUntil([&]() {
+    return cache.fetchResourceFromCache(url("/swr"), false) != stale; });
+  qDebug() << stale << cache.fetchResourceFromCache(url("/swr"), false)
+           << hits;
+  // concurrent fetches of the same resource: only one request
+  QList<QByteArray> results(4);
+  QList<QThread*> threads;
+  for (auto &result: results) {
+    threads << QThread::create([&cache,&result,url]() {
+      result = cache.fetchResource(url("/slow"), 5000); });
+    threads.last()->start();
+  }
+  processEventsUntil([&threads]() {
+    for (auto thread: threads)
+      if (!thread->isFinished())
+        return false;
+    return true;
+  });
+  qDebug() << results << hits;
+  qDeleteAll(threads);
+  // least recently used resources are evicted first
+  ReadOnlyResourcesCache lru;
+  auto cost = [&url](const char *path, const QByteArray &data) {
+    return url(path).size()*2+data.size(); };
+  auto a = lru.fetchResource(url("/a"), 5000);
+  lru.fetchResource(url("/b"), 5000);
+  auto c = lru.fetchResource(url("/c"), 5000);
+  lru.fetchResourceFromCache(url("/a"), false);
+  qDebug() << lruPaths(lru);
+  lru.setMaxSize(cost("/a", a)+cost("/c", c)+2);
+  qDebug() << lruPaths(lru);
+  lru.fetchResource(url("/d"), 5000);
+  qDebug() << lruPaths(lru) << lru.fetchResourceFromCache(url("/c"), false)
+           .isNull();
+  // local files are reloaded when their modification time or size changes
+  QTemporaryDir dir;
+  auto path = dir.filePath("resource");
+  auto mtime = QDateTime::fromSecsSinceEpoch(
+                 QDateTime::currentSecsSinceEpoch()-60);
+  auto writeFile = [&path](const QByteArray &data, const QDateTime &mtime) {
+    QFile file(path);
+    file.open(QIODevice::WriteOnly|QIODevice::Truncate);
+    file.write(data);
+    file.flush();
+    file.setFileTime(mtime, QFileDevice::FileModificationTime);
+  };
+  writeFile("one", mtime);
+  auto one = cache.fetchResource(path, 1000);
+  writeFile("two", mtime); // neither mtime nor size changed: still cached
+  auto cached = cache.fetchResource(path, 1000);
+  writeFile("two", mtime.addSecs(2));
+  auto two = cache.fetchResource(path, 1000);
+  writeFile("three", mtime.addSecs(2));
+  qDebug() << one << cached << two << cache.fetchResource(path, 1000)
+           << cache.fetchResource(
+                QUrl::fromLocalFile(path).toString(), 1000);
+  return 0;
+}
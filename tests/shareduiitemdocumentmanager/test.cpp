@@ -0,0 +1,149 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "modelview/inmemoryshareduiitemdocumentmanager.h"
+#include "modelview/shareduiitemdocumenttransaction.h"
+#include "modelview/genericshareduiitem.h"
+#include "log/log.h"
+#include <QCoreApplication>
+#include <QtDebug>
+
+static GenericSharedUiItem item(const char *id, int value) {
+  return GenericSharedUiItem("generic"_u8, Utf8String(id), { "id", "value" },
+                             { id, value });
+}
+
+static GenericSharedUiItem colored(const char *id, const char *color) {
+  return GenericSharedUiItem("colored"_u8, Utf8String(id), { "id", "color" },
+                             { id, color });
+}
+
+// items by color, as seen by transaction, through reverse index, followed by
+// whether a full scan agrees
+static QString colors(const SharedUiItemDocumentTransaction &transaction) {
+  QStringList result;
+  bool consistent = true;
+  for (auto color: { "red", "green", "blue" }) {
+    QStringList indexed, scanned;
+    for (auto item: transaction.itemsBySectionValue("colored"_u8, 1, color))
+      indexed.append(item.id().toString());
+    for (auto item: transaction.itemsByQualifier("colored"_u8))
+      if (item.uiUtf8(1) == color)
+        scanned.append(item.id().toString());
+    indexed.sort();
+    scanned.sort();
+    consistent &= indexed == scanned;
+    result.append(color+QString("=")+indexed.join(','));
+  }
+  return result.join(' ')+(consistent ? " ok" : " mismatch");
+}
+
+static QString describe(const SharedUiItem &item) {
+  return item.isNull() ? "-" : item.id().toString()+"="+item.uiString(1);
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  InMemorySharedUiItemDocumentManager dm;
+  int singleChanges = 0;
+  QStringList batches;
+  QObject::connect(&dm, &SharedUiItemDocumentManager::itemChanged, [&]() {
+    ++singleChanges;
+  });
+  QObject::connect(&dm, &SharedUiItemDocumentManager::itemsChanged, [&](
+                   const SharedUiItemDocumentManager::ItemChanges &changes) {
+    QStringList batch;
+    for (auto change: changes)
+      batch.append(describe(change._old_item)+">"
+                   +describe(change._new_item));
+    batches.append(batch.join(' '));
+  });
+  // state of the repository, then signals received since last call
+  auto report = [&]() {
+    QStringList items;
+    for (auto item: dm.itemsByQualifier("generic"_u8))
+      items.append(describe(item));
+    items.sort();
+    qDebug() << items.join(',') << singleChanges << batches;
+    singleChanges = 0;
+    batches.clear();
+  };
+  QString errorString;
+  // create then updates are merged into a create
+  SharedUiItemDocumentTransaction t1(&dm);
+  t1.changeItem(item("a", 1), {}, "generic"_u8, &errorString);
+  t1.changeItem(item("a", 2), item("a", 1), "generic"_u8, &errorString);
+  t1.changeItem(item("a", 3), item("a", 2), "generic"_u8, &errorString);
+  t1.changeItem(item("b", 1), {}, "generic"_u8, &errorString);
+  qDebug() << t1.childCount() << t1.text();
+  t1.redo();
+  report();
+  t1.undo();
+  report();
+  t1.redo();
+  report();
+  // update then delete is merged into a delete, create then delete into
+  // nothing
+  SharedUiItemDocumentTransaction t2(&dm);
+  t2.changeItem(item("a", 4), item("a", 3), "generic"_u8, &errorString);
+  t2.changeItem({}, item("a", 4), "generic"_u8, &errorString);
+  t2.changeItem(item("c", 1), {}, "generic"_u8, &errorString);
+  t2.changeItem({}, item("c", 1), "generic"_u8, &errorString);
+  qDebug() << t2.childCount() << t2.text();
+  t2.redo();
+  report();
+  t2.undo();
+  report();
+  // a rename is never merged into previous change, but following updates
+  // are merged into it
+  SharedUiItemDocumentTransaction t3(&dm);
+  t3.changeItem(item("b", 2), item("b", 1), "generic"_u8, &errorString);
+  t3.changeItem(item("d", 2), item("b", 2), "generic"_u8, &errorString);
+  t3.changeItem(item("d", 3), item("d", 2), "generic"_u8, &errorString);
+  t3.changeItem(item("b", 5), {}, "generic"_u8, &errorString);
+  qDebug() << t3.childCount() << t3.text();
+  t3.redo();
+  report();
+  t3.undo();
+  report();
+  t3.redo();
+  report();
+  // changes outside explicit transactions are batched too
+  dm.changeItem(item("e", 1), {}, "generic"_u8);
+  report();
+  // reverse indexes vs full scans, after changes and within a transaction
+  InMemorySharedUiItemDocumentManager colors_dm;
+  SharedUiItemDocumentTransaction probe(&colors_dm);
+  colors_dm.changeItem(colored("a", "red"), {}, "colored"_u8);
+  colors_dm.changeItem(colored("b", "green"), {}, "colored"_u8);
+  qDebug() << colors(probe);
+  colors_dm.changeItem(colored("b", "red"), colored("b", "green"),
+                       "colored"_u8);
+  qDebug() << colors(probe);
+  colors_dm.changeItem(colored("c", "red"), colored("a", "red"), "colored"_u8);
+  qDebug() << colors(probe);
+  colors_dm.changeItem({}, colored("b", "red"), "colored"_u8);
+  qDebug() << colors(probe);
+  SharedUiItemDocumentTransaction t4(&colors_dm);
+  t4.changeItem(colored("d", "blue"), {}, "colored"_u8, &errorString);
+  t4.changeItem(colored("c", "green"), colored("c", "red"), "colored"_u8,
+                &errorString);
+  qDebug() << colors(t4) << colors(probe);
+  t4.redo();
+  qDebug() << colors(probe);
+  t4.undo();
+  qDebug() << colors(probe);
+  return 0;
+}
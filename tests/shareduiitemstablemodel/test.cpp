@@ -0,0 +1,103 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "modelview/shareduiitemstablemodel.h"
+#include "modelview/genericshareduiitem.h"
+#include "log/log.h"
+#include <QCoreApplication>
+#include <QtDebug>
+
+static GenericSharedUiItem item(const char *id) {
+  return GenericSharedUiItem("generic"_u8, Utf8String(id));
+}
+
+static SharedUiItemList items(std::initializer_list<const char *> ids) {
+  SharedUiItemList items;
+  for (auto id: ids)
+    items.append(item(id));
+  return items;
+}
+
+// @return ids by row, and whether indexOf() agrees with a full scan for
+// every id in the model (first row winning) and for a removed one
+static QString check(const SharedUiItemsTableModel &model) {
+  QStringList ids;
+  QHash<Utf8String,int> firstRows;
+  for (int row = model.rowCount()-1; row >= 0; --row) {
+    auto item = model.itemAt(row);
+    firstRows.insert(item.qualifiedId(), row);
+    ids.prepend(item.id().toString());
+  }
+  auto result = ids.join(',')+" ";
+  for (auto [id, row]: firstRows.asKeyValueRange())
+    if (model.indexOf(id).row() != row)
+      return result+"mismatch on "+id.toString();
+  if (model.indexOf("generic:removed"_u8).isValid())
+    return result+"mismatch on removed";
+  return result+"ok";
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  SharedUiItemsTableModel model(
+        GenericSharedUiItem("generic"_u8, "template"_u8, { "id" }, { "id" }));
+  // inserts, at end then at first row (index shifting)
+  for (auto id: { "a", "b", "c" })
+    model.changeItem(item(id), {}, "generic"_u8);
+  qDebug() << check(model);
+  model.setDefaultInsertionPoint(SharedUiItemsTableModel::FirstItem);
+  for (auto id: { "d", "e" })
+    model.changeItem(item(id), {}, "generic"_u8);
+  qDebug() << check(model);
+  model.insertItemAt(item("f"), 2);
+  qDebug() << check(model);
+  // truncation, of last rows then of first ones
+  model.setMaxrows(4);
+  model.changeItem(item("g"), {}, "generic"_u8);
+  qDebug() << check(model);
+  model.setDefaultInsertionPoint(SharedUiItemsTableModel::LastItem);
+  model.changeItem(item("h"), {}, "generic"_u8);
+  model.changeItem(item("i"), {}, "generic"_u8);
+  qDebug() << check(model);
+  model.setItems(items({ "a", "b", "c", "d", "e" }));
+  qDebug() << check(model);
+  // removals, of first, last, middle rows, and through changeItem()
+  model.setMaxrows(INT_MAX);
+  model.removeItems(0, 0);
+  qDebug() << check(model);
+  model.removeItems(2, 3);
+  qDebug() << check(model);
+  model.changeItems({ { item("x"), {}, "generic"_u8 },
+                      { item("y"), {}, "generic"_u8 } });
+  model.changeItem({}, item("c"), "generic"_u8);
+  qDebug() << check(model);
+  // renames, including to an already existing id
+  model.changeItem(item("z"), item("b"), "generic"_u8);
+  qDebug() << check(model);
+  model.changeItem(item("x"), item("y"), "generic"_u8);
+  qDebug() << check(model);
+  // duplicated ids: removing or renaming the first one must index the next
+  model.setItems(items({ "a", "b", "a", "c", "a" }));
+  qDebug() << check(model);
+  model.removeItems(0, 0);
+  qDebug() << check(model);
+  model.removeItems(3, 3);
+  qDebug() << check(model);
+  model.changeItem(item("d"), item("a"), "generic"_u8);
+  qDebug() << check(model);
+  model.changeItem({}, item("b"), "generic"_u8);
+  qDebug() << check(model);
+  return 0;
+}
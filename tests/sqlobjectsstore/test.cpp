@@ -0,0 +1,105 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ostore/sqlobjectsstore.h"
+#include "ostore/objectslistmodel.h"
+#include "log/log.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QPointer>
+#include <QSqlQuery>
+#include <QtDebug>
+
+class Item : public QObject {
+  Q_OBJECT
+  Q_PROPERTY(int id MEMBER _id NOTIFY idChanged)
+  Q_PROPERTY(QString name MEMBER _name NOTIFY nameChanged)
+  Q_PROPERTY(int count MEMBER _count NOTIFY countChanged)
+  int _id = 0, _count = 0;
+  QString _name;
+
+public:
+  Q_INVOKABLE Item(QObject *parent) : QObject(parent) { }
+
+signals:
+  void idChanged();
+  void nameChanged();
+  void countChanged();
+};
+
+static void dump(QSqlDatabase db) {
+  QSqlQuery query("select id, name, count from items order by id", db);
+  while (query.next())
+    qDebug() << query.value(0).toInt() << query.value(1).toString()
+             << query.value(2).toInt();
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  QTemporaryDir dir;
+  auto db = QSqlDatabase::addDatabase("QSQLITE");
+  db.setDatabaseName(dir.filePath("test.db"));
+  db.open();
+  QSqlQuery(db).exec("create table items (id integer primary key, name text, "
+                     "count integer)");
+  SqlObjectsStore store(&Item::staticMetaObject, db);
+  QList<QObject*> items;
+  for (int i = 0; i < 3; ++i)
+    items.append(store.create({ { "name", "item"+QString::number(i) },
+                                { "count", 0 } }).object());
+  // several changes in the same loop iteration are written once
+  for (int i = 0; i < 3; ++i) {
+    items[i]->setProperty("count", i);
+    items[i]->setProperty("count", i*10);
+  }
+  items[2]->setProperty("name", "renamed");
+  dump(db);
+  QCoreApplication::processEvents();
+  dump(db);
+  items[0]->setProperty("count", 42);
+  qDebug() << store.persistAll().success();
+  QCoreApplication::processEvents();
+  dump(db);
+  // paged access, with a window smaller than the table
+  SqlObjectsStore pagedStore(&Item::staticMetaObject, db);
+  pagedStore.setPageSize(2);
+  ObjectsListModel model(&Item::staticMetaObject);
+  model.setStore(&pagedStore);
+  model.setWindowSize(2);
+  while (model.canFetchMore({}))
+    model.fetchMore({});
+  QStringList names;
+  for (int i = 0; i < model.rowCount(); ++i)
+    names << model.data(model.index(i), Qt::UserRole+2).toString();
+  qDebug() << model.rowCount() << names;
+  // reading a row releases objects more than half the window away from it
+  QList<QPointer<QObject>> loaded;
+  for (int i = 0; i < model.rowCount(); ++i)
+    loaded << model.data(model.index(i), Qt::UserRole).value<QObject*>();
+  auto released = [&loaded]() {
+    // released objects are deleted later
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    QList<bool> released;
+    for (const auto &object: loaded)
+      released << object.isNull();
+    return released;
+  };
+  qDebug() << released();
+  qDebug() << model.data(model.index(0), Qt::UserRole+2).toString()
+           << released();
+  return 0;
+}
+
+#include "test.moc"
@@ -1,2 +1,2 @@
 TEMPLATE = subdirs
-SUBDIRS = circularbuffer csvfile directorywatcher paramset paramsformula radixtree utf8string xlsxwriter pf stable_topological_sort
+SUBDIRS = circularbuffer csvfile directorywatcher paramset paramsformula radixtree utf8string xlsxwriter pf stable_topological_sort sqlobjectsstore world inmemoryrulesauthorizer inmemoryauthenticator readonlyresourcescache imagehttphandler shareduiitemstablemodel shareduiitemdocumentmanager datacache inmemorydatabasedocumentmanager basicauthhttphandler graphvizrendercache textformatters bench
@@ -0,0 +1,112 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "format/csvformatter.h"
+#include "format/htmltableformatter.h"
+#include "httpd/httpserver.h"
+#include "httpd/tableexporthttphandler.h"
+#include "modelview/genericshareduiitem.h"
+#include "log/log.h"
+#include <QCoreApplication>
+#include <QBuffer>
+#include <QTcpSocket>
+#include <QtDebug>
+
+static const QStringList cells {
+  "plain", "a,b;c", "say \"hi\"", "line1\nline2\r\nend",
+  QString::fromUtf8("é§€ \U0001f968 a§b"), "",
+  "back\\slash", "<b>&'</b>", "see http://x.org/?a=1&b=\"2\" now",
+  "no link: https:/x", QString(300, 'x'), QString(150, QChar(0xe9)),
+};
+
+// utf-8 row formatting gives the same bytes as utf-16 one, and so does
+// streamed table formatting
+static QList<bool> check(AbstractTextFormatter *formatter,
+                     const SharedUiItemList &items) {
+  bool same_cells = true;
+  for (const auto &cell: cells)
+    same_cells &= formatter->formatUtf8Cell(cell.toUtf8())
+        == formatter->formatCell(cell).toUtf8();
+  Utf8StringList utf8_cells;
+  for (const auto &cell: cells)
+    utf8_cells << cell.toUtf8();
+  bool same_row = formatter->formatUtf8Row(utf8_cells, "h1")
+      == formatter->formatRow(cells, "h1").toUtf8();
+  QBuffer buffer;
+  buffer.open(QIODevice::WriteOnly);
+  bool written = formatter->writeTable(&buffer, items);
+  bool same_table = buffer.data() == formatter->formatTable(items).toUtf8();
+  return { same_cells, same_row, written, same_table };
+}
+
+// @return body
+static QByteArray get(quint16 port, const QByteArray &path) {
+  QTcpSocket socket;
+  socket.connectToHost(QHostAddress::LocalHost, port);
+  if (!socket.waitForConnected(5000))
+    return "cannot connect";
+  socket.write("GET "+path+" HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  while (socket.state() == QAbstractSocket::ConnectedState)
+    socket.waitForReadyRead(5000);
+  auto response = socket.readAll();
+  return response.mid(response.indexOf("\r\n\r\n")+4);
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  SharedUiItemList items;
+  for (int i = 0; i+2 < cells.size(); ++i)
+    items << GenericSharedUiItem("cell"_u8, Utf8String::number(i),
+                                 { "id", "text", "next" },
+                                 { QString::number(i), cells[i], cells[i+1] });
+  SharedUiItemList many;
+  for (int i = 0; i < 20'000; ++i)
+    many << items[i%items.size()];
+  CsvFormatter csv; // special chars are removed
+  CsvFormatter quoted(';', "\r\n", '"', '\\');
+  CsvFormatter replaced(',', "\n", QChar(), QChar(), '_');
+  CsvFormatter unicode(QChar(0xa7), "\n", QChar(), '\\'); // non-ascii special
+  CsvFormatter elided(',', "\n", '"', '\\', QChar(), 10);
+  HtmlTableFormatter asis, escaped, links, elidedHtml(10);
+  asis.setTextConversion(HtmlTableFormatter::AsIs);
+  escaped.setTextConversion(HtmlTableFormatter::HtmlEscaping);
+  links.setTextConversion(HtmlTableFormatter::HtmlEscapingWithUrlAsLinks);
+  quoted.enableRowHeaders();
+  links.enableRowHeaders();
+  links.setTopLeftHeader("<top>");
+  replaced.enableColumnHeaders(false);
+  for (auto formatter: std::initializer_list<AbstractTextFormatter*>{
+       &csv, &quoted, &replaced, &unicode, &elided, &asis, &escaped, &links,
+       &elidedHtml })
+    qDebug() << check(formatter, items);
+  // several output blocks
+  qDebug() << check(&quoted, many) << check(&links, many);
+  qDebug().noquote() << quoted.formatUtf8Row({ "a;b", "x\"y", "e" })
+                        .trimmed()
+                     << links.formatUtf8Row({ "a<b", "http://x.org/?a=1&b=2" })
+                        .trimmed();
+  // table export handler streams the same bytes
+  auto server = new HttpServer(2);
+  auto handler = new TableExportHttpHandler(
+        "/export.csv", new CsvFormatter(';', "\r\n", '"', '\\'), "text/csv");
+  handler->setItems(many);
+  server->appendHandler(handler);
+  server->listen(QHostAddress::LocalHost);
+  CsvFormatter reference(';', "\r\n", '"', '\\');
+  auto body = get(server->serverPort(), "/export.csv");
+  qDebug() << (body.size() > 65536)
+           << (body == reference.formatTable(many).toUtf8());
+  return 0;
+}
@@ -1,4 +1,5 @@
 #include "util/paramset.h"
+#include "util/utf8stringview.h"
 #include <QtDebug>
 
 int main(void) {
@@ -104,5 +105,72 @@ int main(void) {
          "%{=coalesce:%{=rpn,}:ø}=ø " // empty list is invalid
          "%{=coalesce:%{=rpn,,}:ø}= "
          "%{=coalesce:%{=rpn,%empty}:ø}= "_u8 % ps;
+  // vectorized kernels vs scalar results
+  Utf8String long_ascii =
+      "The quick brown fox jumps over the lazy dog 0123456789 @[`{ "_u8
+      .repeated(40);
+  Utf8String long_mixed =
+      ("a\u00e9\u00c9b\u20ac\u00a2\u03c3 quick BROWN fox \xef\xbb\xbf"_u8)
+      .repeated(40);
+  qDebug() << (long_ascii.toUpper() == QByteArray(long_ascii).toUpper())
+           << (long_ascii.toLower() == QByteArray(long_ascii).toLower())
+           << (long_ascii.utf8size() == long_ascii.size())
+           << (long_mixed.utf8size() == 24*40)
+           << (long_mixed.cleaned().size() == long_mixed.size()-3*40)
+           << (long_mixed.toLower().toUpper() == long_mixed.cleaned().toUpper())
+           << (long_mixed.toUpper().utf8size() == 24*40);
+  // validation kernel vs strict decoder, also after ascii bytes to go
+  // through vectorized code
+  int agreements = 0, cases = 0, valid = 0;
+  for (auto sequence: { "\xc3\xa9", "\xc0\x80", "\xc1\xbf", "\xc2", "\x80",
+                        "\xe0\x80\x80", "\xe0\xa0\x80", "\xed\x9f\xbf",
+                        "\xed\xa0\x80", "\xef\xbf\xbd", "\xef\xbb\xbf", "\xe2\x82",
+                        "\xf0\x8f\xbf\xbf", "\xf0\x90\x80\x80",
+                        "\xf4\x8f\xbf\xbf", "\xf4\x90\x80\x80",
+                        "\xf5\x80\x80\x80", "\xf8\x88\x80\x80\x80", "\xff" }) {
+    for (const auto &prefix: { ""_u8, long_ascii.left(40) }) {
+      Utf8String s = prefix+sequence+"z";
+      auto end = s.constData()+s.size();
+      bool reference = Utf8String::cleaned<true, true, true>(
+            s.constData(), end) == s;
+      bool is_valid = p6::utf8::is_valid(s.constData(), end);
+      agreements += is_valid == reference;
+      valid += is_valid;
+      ++cases;
+    }
+  }
+  qDebug() << agreements << cases << valid
+           << (long_ascii.cleaned().constData() == long_ascii.constData())
+           << (long_mixed.cleaned().constData() == long_mixed.constData())
+           << (long_mixed.cleaned<true, false, true>() == long_mixed);
+  // bytes set search, sets larger than MaxBytesSetSize falling back to scalar
+  Utf8String haystack = long_ascii+";"+long_ascii;
+  auto prefix_size_not_in = [&haystack](QByteArrayView set) {
+    return p6::utf8::prefix_size_not_in(
+          haystack.constData(), haystack.constData()+haystack.size(), set);
+  };
+  qDebug() << prefix_size_not_in(";") << prefix_size_not_in("!#$%&*+;<>~")
+           << prefix_size_not_in("!#$%&*+;<>~T")
+           << (prefix_size_not_in("!#$%&*+<>~|") == haystack.size());
+  // unicode properties tables
+  qDebug() << (int)Utf8String::toUpper(U'\u03c3')
+           << (int)Utf8String::toLower(0x10400)
+           << (int)Utf8String::unicode_category(U'\u00e9')
+           << (int)Utf8String::unicode_category(0x4e01)
+           << (int)Utf8String::unicode_category(0x378)
+           << Utf8String::is_unicode_whitespace(0x3000)
+           << Utf8String::is_unicode_horizontal_whitespace(0x2028)
+           << Utf8String::is_unicode_whitespace(0x110000);
+  // views vs strings
+  Utf8String sv_source = " \u00a7foo\u00a7bar\u00a7baz\u00a7\u00a7 42k "_u8;
+  Utf8StringView sv(sv_source);
+  qDebug() << (sv.trimmed().toUtf8() == sv_source.trimmed())
+           << (sv.trimmed().utf8mid(4,3).toUtf8()
+               == sv_source.trimmed().utf8mid(4,3))
+           << (sv.trimmed().split_headed_list().size()
+               == sv_source.trimmed().split_headed_list().size())
+           << (sv.utf8left(2).toUtf8() == sv_source.utf8left(2))
+           << sv.split(' ', Qt::SkipEmptyParts).value(1).toInt()
+           << !Utf8StringView(Utf8String{});
   return 0;
 }
@@ -0,0 +1,119 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "eg/world.h"
+#include "util/utf8stringlist.h"
+#include "log/log.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtDebug>
+
+using namespace p6;
+
+static Utf8String names(const WorldView &wv, const EntityList &entities) {
+  Utf8StringList names;
+  for (auto e: entities)
+    names << e.n3(&wv);
+  return names.join(',');
+}
+
+int main() {
+  p6::log::init();
+  p6::log::add_console_logger(Log::Debug, false, stdout);
+  World world;
+  auto fruit = world.create_entity(), apple = world.create_entity(),
+      red = world.create_entity(), apple123 = world.create_entity(),
+      color = world.create_entity();
+  world.set_name(fruit, "fruit"_u8);
+  world.set_name(apple, "apple"_u8);
+  world.set_name(red, "red"_u8);
+  world.set_name(apple123, "apple123"_u8);
+  world.set_name(color, "color"_u8);
+  world.set_attribute(fruit, color, "green"_u8);
+  world.set_attribute(red, color, "red"_u8);
+  world.add(apple, Entity::KIND_OF, fruit);
+  world.add(apple, Entity::GRANTS_KIND, red);
+  auto wv = world.commit();
+  world.declare_kind_of(apple123, apple);
+  auto wv2 = world.commit();
+  qDebug() << wv.size() << wv2.size() << wv2.generation();
+  qDebug() << names(wv2, wv2.kinds(apple123))
+           << names(wv2, wv2.kinds(Entity::NAME));
+  qDebug() << wv2.find_first_attribute(apple123, color).as_utf8()
+           << wv2.find_first_attribute(apple, color).as_utf8();
+  qDebug() << (wv2.by_name("apple"_u8) == apple)
+           << EntityRef(apple123, &wv2).n3() << apple123.n3();
+  // older views are not affected by later commits
+  world.set_attribute(fruit, color, "yellow"_u8);
+  auto wv3 = world.commit();
+  qDebug() << wv.kinds(apple123).size()
+           << wv2.find_first_attribute(apple, color).as_utf8()
+           << wv3.find_first_attribute(apple, color).as_utf8();
+  world.remove(apple, Entity::GRANTS_KIND, red);
+  auto wv4 = world.commit();
+  qDebug() << wv4.contains(apple, Entity::GRANTS_KIND, red)
+           << wv3.contains(apple, Entity::GRANTS_KIND, red)
+           << wv4.subjects(color, "red"_u8).size();
+  // persistence: file written by open(), changes logged and replayed
+  QTemporaryDir dir;
+  auto path = dir.filePath("world");
+  world.open(path);
+  auto basket = world.create_entity();
+  world.set_name(basket, "basket"_u8);
+  world.add(basket, Entity::OWNS, std::vector<Entity>{ apple, apple123 });
+  world.commit();
+  {
+    World reopened;
+    auto ok = reopened.open(path);
+    auto rv = reopened.view();
+    auto owned = rv.attribute(basket, Entity::OWNS)
+        .as_entityvector({}, nullptr);
+    qDebug() << ok << rv.size() << EntityRef(basket, &rv).n3()
+             << owned.size() << owned.back().n3(&rv)
+             << rv.find_first_attribute(apple123, color).as_utf8();
+    reopened.set_attribute(basket, color, "brown"_u8);
+    reopened.commit();
+    ok = reopened.compact();
+    qDebug() << ok << QFileInfo(path+".log").size();
+  }
+  World compacted;
+  auto ok = compacted.open(path);
+  auto cv = compacted.view();
+  qDebug() << ok << cv.attribute(basket, color).as_utf8()
+           << names(cv, cv.kinds(apple123))
+           << (compacted.create_entity() > basket);
+  // invalid value offsets or sorted indexes are rejected when mapping, field
+  // being the header offset of the table to corrupt
+  auto corrupted = [&](qsizetype field, quint64 index, quint64 value) {
+    QFile file(path);
+    file.open(QIODevice::ReadOnly);
+    auto data = file.readAll();
+    quint64 table;
+    ::memcpy(&table, data.constData()+field, sizeof table);
+    ::memcpy(data.data()+table+index*sizeof value, &value, sizeof value);
+    auto corrupted_path = dir.filePath("corrupted");
+    QFile::remove(corrupted_path+".log");
+    QFile out(corrupted_path);
+    out.open(QIODevice::WriteOnly|QIODevice::Truncate);
+    out.write(data);
+    out.close();
+    World world;
+    return world.open(corrupted_path);
+  };
+  const qsizetype value_offsets = 64, value_sorted = 72;
+  qDebug() << corrupted(value_offsets, 0, 0)
+           << corrupted(value_offsets, 1, 1ULL << 40)
+           << corrupted(value_sorted, 0, 1ULL << 40);
+  return 0;
+}
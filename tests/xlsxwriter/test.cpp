@@ -18,9 +18,86 @@
 #include <string>
 #include "log/log.h"
 #include <unistd.h>
+#include <QCoreApplication>
+#include <QFile>
 #include <QDate>
+#include <cmath>
+#include <zlib.h>
 
-int main(int, char **) {
+// little endian integer of size bytes at pos
+static quint32 le(const QByteArray &data, qsizetype pos, int size) {
+  quint32 value = 0;
+  for (int i = size-1; i >= 0; --i)
+    value = value << 8 | quint8(data.at(pos+i));
+  return value;
+}
+
+// extract archive entry, found through ZIP central directory, null on error
+static QByteArray read_entry(const QString &archive, const QByteArray &entry) {
+  QFile file(archive);
+  if (!file.open(QIODevice::ReadOnly))
+    return {};
+  auto zip = file.readAll();
+  auto eocd = zip.lastIndexOf("PK\x05\x06");
+  if (eocd < 0 || eocd+22 > zip.size())
+    return {};
+  qsizetype pos = le(zip, eocd+16, 4);
+  for (auto count = le(zip, eocd+10, 2); count; --count) {
+    if (pos+46 > zip.size() || le(zip, pos, 4) != 0x02014b50)
+      return {};
+    auto method = le(zip, pos+10, 2), crc = le(zip, pos+16, 4);
+    qsizetype compressedSize = le(zip, pos+20, 4),
+        size = le(zip, pos+24, 4), nameSize = le(zip, pos+28, 2),
+        local = le(zip, pos+42, 4);
+    if (zip.mid(pos+46, nameSize) != entry) {
+      pos += 46+nameSize+le(zip, pos+30, 2)+le(zip, pos+32, 2);
+      continue;
+    }
+    if (local+30 > zip.size() || le(zip, local, 4) != 0x04034b50)
+      return {};
+    auto data = zip.mid(local+30+le(zip, local+26, 2)+le(zip, local+28, 2),
+                        compressedSize);
+    if (method == 8) {
+      QByteArray output(size, Qt::Uninitialized);
+      z_stream stream {};
+      stream.next_in = reinterpret_cast<Bytef*>(data.data());
+      stream.avail_in = data.size();
+      stream.next_out = reinterpret_cast<Bytef*>(output.data());
+      stream.avail_out = output.size();
+      // negative window bits: raw deflate stream, as in ZIP entries
+      if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return {};
+      auto status = inflate(&stream, Z_FINISH);
+      inflateEnd(&stream);
+      if (status != Z_STREAM_END || qsizetype(stream.total_out) != size)
+        return {};
+      data = output;
+    } else if (method != 0) {
+      return {};
+    }
+    if (data.size() != size
+        || ::crc32(0, reinterpret_cast<const Bytef*>(data.constData()),
+                   data.size()) != crc)
+      return {};
+    return data;
+  }
+  return {};
+}
+
+// print archive entry content, line by line
+static void dump_entry(const QString &archive, const QByteArray &entry) {
+  auto data = read_entry(archive, entry);
+  if (data.isNull()) {
+    qDebug() << "cannot read" << entry << "from" << archive;
+    return;
+  }
+  for (auto line: data.split('\n'))
+    if (!line.isEmpty())
+      qDebug().noquote() << line;
+}
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
   p6::log::init();
   p6::log::add_console_logger(p6::log::Debug, true, stdout);
   p6::log::debug() << "test";
@@ -48,6 +125,18 @@ int main(int, char **) {
   sw2.appendRow({"foo", "bar"}, sheet_title);
   qDebug() << "rowcount:" << sw2.rowCount(sheet_title) << "== 3";
   sw2.write("output2.xlsx");
+  XlsxWriter sw3("/tmp/xlsxwriter_test3", false);
+  sw3.setMaxSharedStrings(2);
+  sw3.appendColumns({ QList<qint64>{ 1, 2, 3 }, Utf8StringList{ "a", "b", "c" },
+                      XlsxWriter::InlineStrings{ "x y" },
+                      QList<double>{ 0.5, NAN, -1e-3 } }, "Columns");
+  sw3.appendRow({ "c", "d", 4 }, "Columns");
+  qDebug() << "rowcount:" << sw3.rowCount("Columns") << "== 4";
+  sw3.write("output3.xlsx");
+  // shared strings table is full after "a" and "b", further strings and
+  // InlineStrings columns are written inline
+  dump_entry("output3.xlsx", "sheet1.xml");
+  dump_entry("output3.xlsx", "strings.xml");
   ::usleep(1'000'000);
   return 0;
 }
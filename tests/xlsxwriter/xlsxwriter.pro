@@ -33,6 +33,7 @@ INCLUDEPATH += ../..
 LIBS += \
     -L../../../build-p6core-$$TARGET_OS/$$BUILD_TYPE
 LIBS += -lp6core
+LIBS += -lz
 
 exists(/usr/bin/ccache):QMAKE_CXX = ccache g++
 exists(/usr/bin/ccache):QMAKE_CXXFLAGS += -fdiagnostics-color=always
@@ -17,7 +17,8 @@
 TextTableView::TextTableView(QObject *parent, QString objectName,
                              int cachedRows, int rowsPerPage)
   : TextView(parent, objectName), _cachedRows(cachedRows),
-    _rowsPerPage(rowsPerPage) {
+    _rowsPerPage(rowsPerPage), _uncachedRowsRendering(false),
+    _modelRowsCount(0) {
 }
 
 void TextTableView::setEmptyPlaceholder(QString rawText) {
@@ -38,7 +39,9 @@ QString TextTableView::text(ParamsProvider *params, QString scope) const {
   QString v;
   auto locked_rows = _rows.constLockedData();
   const QStringList &rows = *locked_rows;
-  int rowsCount = rows.size();
+  int cachedRowsCount = rows.size(), rowsCount = cachedRowsCount;
+  if (_uncachedRowsRendering)
+    rowsCount = qMax(rowsCount, _modelRowsCount.loadRelaxed());
   QString pageVariableName =
       objectName().isEmpty() ? u"page"_s : objectName()+u"-page"_s;
   QString pageVariableValue;
@@ -52,7 +55,6 @@ QString TextTableView::text(ParamsProvider *params, QString scope) const {
     v = _emptyPlaceholder;
   else {
     int min, max;
-    // TODO read uncached data if needed
     if (_rowsPerPage > 0) {
       maxPage = rowsCount/_rowsPerPage
           + (rowsCount%_rowsPerPage || !rowsCount ? 1 : 0);
@@ -65,7 +67,10 @@ QString TextTableView::text(ParamsProvider *params, QString scope) const {
       max = rowsCount-1;
     }
     for (int row = min; row <= max; ++row)
-      v.append(rows.at(row));
+      v.append(row < cachedRowsCount
+               ? rows.at(row)
+                 // rowText() is not const only because it's used to fill cache
+               : const_cast<TextTableView*>(this)->rowText(row));
     if (maxPage > currentPage)
       v.append(_ellipsePlaceholder);
   }
@@ -88,6 +93,7 @@ void TextTableView::resetAll() {
   QAbstractItemModel *m = model();
   auto rows = _rows.lockedData();
   rows->clear();
+  _modelRowsCount = m ? m->rowCount() : 0;
   if (m) {
     auto size = m->rowCount();
     if (size)
@@ -137,6 +143,7 @@ void TextTableView::rowsRemoved(const QModelIndex &parent, int start, int end) {
   int size = rows->size(); // overflows if > 2G
   if (parent.isValid() || !m)
     return;
+  _modelRowsCount = m->rowCount();
   if (size <= 0 || start < 0 || start >= size || end < 0) {
     //qDebug() << "rowRemoved size <= 0 || start < 0 || start >= size || end < 0:"
     //         << start << end << size << typeid(this).name() << objectName();
@@ -153,6 +160,8 @@ void TextTableView::rowsRemoved(const QModelIndex &parent, int start, int end) {
 void TextTableView::rowsInserted (const QModelIndex &parent, int start,
                                   int end) {
   auto rows = _rows.lockedData();
+  if (!parent.isValid() && model())
+    _modelRowsCount = model()->rowCount();
   doRowsInserted(rows, parent, start, end);
 }
 
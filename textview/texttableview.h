@@ -16,6 +16,7 @@
 
 #include "textview.h"
 #include "thread/atomicvalue.h"
+#include <QAtomicInt>
 
 /** Base class for text table views.
  * @see HtmlTableView
@@ -28,6 +29,8 @@ class LIBP6CORESHARED_EXPORT TextTableView : public TextView {
   QList<int> _columnIndexes, _effectiveColumnIndexes;
   AtomicValue<QStringList> _rows;
   QString _emptyPlaceholder, _ellipsePlaceholder;
+  bool _uncachedRowsRendering;
+  QAtomicInt _modelRowsCount;
 
 public:
   const static int defaultCachedRows = 100, defaultRowsPerPage = 25;
@@ -54,6 +57,14 @@ public:
   void setCachedRows(int cachedRows) { _cachedRows = cachedRows; }
   /** @see setCachedRows() */
   int cachedRows() const { return _cachedRows; }
+  /** Render rows beyond cachedRows() on demand when they are displayed, so
+   * that paging reads only visible rows from the model, whatever its size.
+   * The model is then called by the thread calling text(), which requires a
+   * thread-safe model, such as a CsvFileModel on a lazy loading CsvFile.
+   * Default: false (rows beyond cachedRows() are not displayed) */
+  void enableUncachedRowsRendering(bool enabled = true) {
+    _uncachedRowsRendering = enabled; }
+  bool uncachedRowsRendering() const { return _uncachedRowsRendering; }
   /** Max number of rows to display on one page. Default is 25.
    * Use -1 to disable. */
   void setRowsPerPage(int rowsPerPage) {
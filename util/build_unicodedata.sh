@@ -1,30 +1,91 @@
 #!/bin/bash
 set -C -e -o pipefail
-shopt -s lastpipe
 D="$(dirname $0)"
 [[ "$D" =~ ^/ ]] || D="$(pwd)/$D"
 
 exec >| "$D/unicodedata.cpp"
 
-empty="{}"
-grep -v ';;;$' "$D/UnicodeData.txt" | \
-while IFS=';' read -r code_value character_name general_category canonical_combining_classes bidirectional_category character_decomposition_mapping decimal_digit_value digit_value numeric_value mirrored unicode_1_name iso_10646_comment uppercase_mapping lowercase_mapping titlecase_mapping remainning ; do
-  [ -z "$uppercase_mapping" ] && uppercase_mapping=$code_value
-  [ -z "$lowercase_mapping" ] && lowercase_mapping=$code_value
-  [ -z "$titlecase_mapping" ] && titlecase_mapping=$code_value
-  case_mapping[0x$code_value]="  { 0x$code_value, 0x$uppercase_mapping, 0x$lowercase_mapping, 0x$titlecase_mapping }, // $character_name $general_category"
-done
-
-cat <<EOF # header
-const std::vector<Utf8String::UnicodeCaseMapping> Utf8String::_case_mapping = {
-EOF
-
-#echo $code_values
-for code_value in ${!case_mapping[@]}; do
-  echo "${case_mapping[$code_value]}"
-done
-
-cat <<EOF # footer
-};
-EOF
-
+# two-stage table: _unicode_blocks[u >> 8] selects a 256 characters block in
+# _unicode_properties_indexes, which gives the index of the character record
+# in _unicode_properties (record 0 being unassigned characters)
+# identical blocks are stored only once, and so are identical records, since
+# case mappings are stored as deltas
+awk -F';' '
+function hex(s,  i, n) {
+  n = 0;
+  s = toupper(s);
+  for (i = 1; i <= length(s); ++i)
+    n = n*16 + index("0123456789ABCDEF", substr(s, i, 1)) - 1;
+  return n;
+}
+function delta(mapping, code) {
+  return mapping == "" ? 0 : hex(mapping) - code;
+}
+function record(key,  i) {
+  if (!(key in records)) {
+    records[key] = records_count;
+    records_list[records_count++] = key;
+  }
+  return records[key];
+}
+BEGIN {
+  records_count = 0;
+  record("0, 0, 0, Utf8String::UnicodeCn, false");
+}
+{
+  code = hex($1);
+  category = $3;
+  whitespace = category ~ /^Z/ || (code >= 9 && code <= 13) || code == 133 \
+      ? "true" : "false";
+  key = delta($13, code) ", " delta($14, code) ", " delta($15, code) \
+      ", Utf8String::Unicode" category ", " whitespace;
+  if ($2 ~ /, Last>$/) { # range, e.g. CJK ideographs
+    for (c = first+1; c <= code; ++c)
+      indexes[c] = record(key);
+    next;
+  }
+  indexes[code] = record(key);
+  first = code;
+}
+END {
+  print "// generated by build_unicodedata.sh from UnicodeData.txt, do not edit";
+  print "";
+  print "constexpr Utf8String::UnicodeProperties Utf8String::_unicode_properties[] = {";
+  for (i = 0; i < records_count; ++i)
+    print "  { " records_list[i] " },";
+  print "};";
+  print "";
+  blocks_count = 0;
+  for (b = 0; b < 4352; ++b) {
+    block = "";
+    for (c = b*256; c < (b+1)*256; ++c) {
+      block = block ((c % 16) ? " " : "\n  ") ((c in indexes) ? indexes[c] : 0) ",";
+    }
+    if (!(block in blocks)) {
+      blocks[block] = blocks_count;
+      blocks_list[blocks_count++] = block;
+    }
+    block_of[b] = blocks[block];
+  }
+  print "static_assert(std::size(Utf8String::_unicode_properties) <= 256);";
+  print "";
+  print "constexpr quint8 Utf8String::_unicode_properties_indexes[] = {";
+  for (i = 0; i < blocks_count; ++i)
+    print "  // block " i blocks_list[i];
+  print "};";
+  print "";
+  print "static_assert(std::size(Utf8String::_unicode_properties_indexes)";
+  print "              <= 256*256);";
+  print "";
+  print "constexpr quint8 Utf8String::_unicode_blocks[] = {";
+  line = "";
+  for (b = 0; b < 4352; ++b) {
+    line = line ((b % 16) ? " " : "  ") block_of[b] ",";
+    if (b % 16 == 15) {
+      print line;
+      line = "";
+    }
+  }
+  print "};";
+}
+' "$D/UnicodeData.txt"
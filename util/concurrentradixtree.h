@@ -0,0 +1,303 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CONCURRENTRADIXTREE_H
+#define CONCURRENTRADIXTREE_H
+
+#include "util/radixtree.h"
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+/** Thread-safe RadixTree variant for trees that are read concurrently by many
+ * threads and updated at runtime (e.g. functions or handlers registration).
+ *
+ * Same lookup semantics than RadixTree (exact and prefix keys, matchedLength).
+ *
+ * Read-copy-update: readers are wait-free, they only read an atomic pointer
+ * to the current immutable version of the tree and increment/decrement a
+ * readers counter. Readers counters are striped by thread (each one on its
+ * own cache line) so that concurrent readers do not contend on a shared
+ * counter.
+ * Writers are serialized by a mutex and publish a new version built by path
+ * copying: only the nodes on the path from root to the inserted key are
+ * copied, every other node is shared with previous version.
+ * Before freeing the previous version, writers wait for every reader that may
+ * still be reading it (a so-called grace period, detected by flipping between
+ * two sets of readers counters), so writes are much more expensive than reads
+ * and should stay unfrequent.
+ *
+ * Keys are expected to be encoded in utf-8.
+ *
+ * Not copyable.
+ */
+template<class T>
+class ConcurrentRadixTree {
+  using NodeType = typename RadixTree<T>::NodeType;
+  using SourceNode = typename RadixTree<T>::Node;
+
+  struct Node;
+  using NodePtr = QExplicitlySharedDataPointer<Node>;
+
+  struct Node : QSharedData {
+    QByteArray _fragment;
+    NodeType _nodetype;
+    T _value;
+    std::vector<NodePtr> _children; // sorted by (unsigned) first byte
+    Node(const char *fragment, T value, NodeType nodetype)
+      : _fragment(fragment), _nodetype(nodetype), _value(value) { }
+    Node(const Node &other) = default;
+    /** index of child starting with c, or of the place where it should be
+     * inserted if none */
+    size_t child_index(unsigned char c) const {
+      size_t i = 0;
+      for (; i < _children.size(); ++i)
+        if ((unsigned char)_children[i]->_fragment[0] >= c)
+          break;
+      return i;
+    }
+  };
+
+  struct Version {
+    NodePtr _root;
+    Utf8StringSet _keys;
+  };
+
+  static constexpr int ReadersStripes = 16;
+  struct alignas(64) ReadersCounter {
+    std::atomic<int> _count = 0;
+  };
+
+  std::atomic<const Version *> _current;
+  alignas(64) std::atomic<unsigned> _epoch = 0;
+  mutable ReadersCounter _readers[2][ReadersStripes];
+  alignas(64) QMutex _write_mutex;
+
+  /** stripe of readers counters used by current thread */
+  static int readers_stripe() {
+    static std::atomic<int> next = 0;
+    static thread_local const int stripe = next.fetch_add(1) % ReadersStripes;
+    return stripe;
+  }
+
+  /** RAII read-side critical section */
+  class ReadGuard {
+    std::atomic<int> *_count;
+  public:
+    const Version *_version;
+    ReadGuard(const ConcurrentRadixTree *tree)
+      : _count(&tree->_readers[tree->_epoch.load() & 1]
+               [readers_stripe()]._count) {
+      _count->fetch_add(1);
+      _version = tree->_current.load();
+    }
+    ~ReadGuard() {
+      _count->fetch_sub(1);
+    }
+  };
+
+public:
+  ConcurrentRadixTree() : _current(new Version) { }
+  explicit ConcurrentRadixTree(const RadixTree<T> &tree)
+    : _current(new Version) {
+    replace(tree);
+  }
+  ConcurrentRadixTree(std::initializer_list<RadixTreeInitializerHelper<T>> list)
+    : ConcurrentRadixTree(RadixTree<T>(list)) { }
+  ConcurrentRadixTree(const ConcurrentRadixTree &) = delete;
+  ConcurrentRadixTree &operator=(const ConcurrentRadixTree &) = delete;
+  ~ConcurrentRadixTree() {
+    delete _current.load();
+  }
+  /** assumes that key is UTF-8 (or of course ASCII)
+   * Thread-safe, blocks until previous version is no longer read. */
+  void insert(const char *key, T value, bool isPrefix = false) {
+    Q_ASSERT(key);
+    QMutexLocker locker(&_write_mutex);
+    auto old = _current.load();
+    auto version = new Version(*old);
+    version->_root = insert(old->_root, key, value, isPrefix);
+    version->_keys.insert(key);
+    publish(version);
+  }
+  void insert(const QString &key, T value, bool isPrefix = false) {
+    insert(key.toUtf8().constData(), value, isPrefix); }
+  void insert(const QByteArray &key, T value, bool isPrefix = false) {
+    insert(key.constData(), value, isPrefix); }
+  /** Replace the whole content with a copy of tree.
+   * Thread-safe, blocks until previous version is no longer read. */
+  void replace(const RadixTree<T> &tree) {
+    auto version = new Version;
+    version->_root = copy(tree.d->_root);
+    version->_keys = tree.keys();
+    QMutexLocker locker(&_write_mutex);
+    publish(version);
+  }
+  /** assumes that key is UTF-8 (or of course ASCII)
+   * Thread-safe and wait-free. */
+  const T value(const char *key, T defaultValue = T(),
+                int *matchedLength = 0) const {
+    Q_ASSERT(key);
+    int ignored_length;
+    if (!matchedLength)
+      matchedLength = &ignored_length;
+    ReadGuard guard(this);
+    auto node = lookup(guard._version->_root.constData(), key, matchedLength);
+    return node ? node->_value : defaultValue;
+  }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T value(const char *key, int *matchedLength) const {
+    return value(key, T(), matchedLength); }
+  const T value(const QString &key, T defaultValue = T(),
+                int *matchedLength = 0) const {
+    return value(key.toUtf8().constData(), defaultValue, matchedLength); }
+  const T value(const QString &key, int *matchedLength) const {
+    return value(key.toUtf8().constData(), T(), matchedLength); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T value(const QByteArray &key, T defaultValue = T(),
+                int *matchedLength = 0) const {
+    return value(key.constData(), defaultValue, matchedLength); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T value(const QByteArray &key, int *matchedLength) const {
+    return value(key.constData(), T(), matchedLength); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T operator[](const char *key) const { return value(key); }
+  const T operator[](const QString &key) const {
+    return value(key.toUtf8().constData()); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T operator[](const QByteArray &key) const {
+    return value(key.constData()); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  bool contains(const char *key) const {
+    int ignored_length;
+    ReadGuard guard(this);
+    return lookup(guard._version->_root.constData(), key, &ignored_length);
+  }
+  bool contains(const QString &key) const {
+    return contains(key.toUtf8().constData()); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  bool contains(const QByteArray &key) const {
+    return contains(key.constData()); }
+  Utf8StringSet keys() const {
+    ReadGuard guard(this);
+    return guard._version->_keys;
+  }
+
+private:
+  /** must be called with _write_mutex locked */
+  void publish(const Version *version) {
+    auto old = _current.exchange(version);
+    // grace period: wait for readers of both slots, flipping the epoch before
+    // each wait so that new readers use the other slot
+    for (int phase = 0; phase < 2; ++phase) {
+      unsigned slot = _epoch.fetch_add(1) & 1;
+      for (auto &counter: _readers[slot])
+        while (counter._count.load())
+          QThread::yieldCurrentThread();
+    }
+    delete old;
+  }
+  /** path copying insertion
+   * @return new version of node */
+  static NodePtr insert(const NodePtr &node, const char *key, T value,
+                        bool isPrefix) {
+    NodeType nodetype = isPrefix ? RadixTree<T>::Prefix : RadixTree<T>::Exact;
+    if (!node)
+      return NodePtr(new Node(key, value, nodetype));
+    const char *fragment = node->_fragment.constData();
+    int i = 0;
+    for (; key[i] == fragment[i] && key[i]; ++i)
+      ;
+    if (!fragment[i] && !key[i]) {
+      // exact match -> copy node with new value
+      NodePtr clone(new Node(*node));
+      clone->_value = value;
+      clone->_nodetype = nodetype;
+      return clone;
+    }
+    if (fragment[i]) {
+      // have to split -> new parent node with current node tail as a child
+      NodePtr tail(new Node(*node));
+      tail->_fragment = node->_fragment.mid(i);
+      NodePtr parent;
+      if (!key[i]) {
+        // inserted key shorter than this node key
+        parent.reset(new Node(QByteArray(fragment, i).constData(), value,
+                              nodetype));
+        parent->_children.push_back(tail);
+      } else {
+        // full fork
+        parent.reset(new Node(QByteArray(fragment, i).constData(), T(),
+                              RadixTree<T>::Empty));
+        NodePtr leaf(new Node(key+i, value, nodetype));
+        if ((unsigned char)key[i] < (unsigned char)fragment[i])
+          parent->_children = { leaf, tail };
+        else
+          parent->_children = { tail, leaf };
+      }
+      return parent;
+    }
+    // continue among children
+    NodePtr clone(new Node(*node)); // shallow: children are shared
+    size_t j = clone->child_index(key[i]);
+    if (j < clone->_children.size()
+        && clone->_children[j]->_fragment[0] == key[i])
+      clone->_children[j] = insert(clone->_children[j], key+i, value,
+                                   isPrefix);
+    else
+      clone->_children.insert(clone->_children.begin()+j,
+                              NodePtr(new Node(key+i, value, nodetype)));
+    return clone;
+  }
+  static NodePtr copy(const SourceNode *source) {
+    if (!source)
+      return {};
+    NodePtr node(new Node(source->_fragment, source->_value,
+                          source->_nodetype));
+    for (int i = 0; i < source->_childrenCount; ++i)
+      node->_children.push_back(copy(source->_children[i]));
+    return node;
+  }
+  /** iterative lookup, remembering the deepest prefix node on the way */
+  static const Node *lookup(const Node *node, const char *key,
+                            int *matchedLength) {
+    const Node *found = nullptr;
+    int i = 0;
+    *matchedLength = 0;
+    while (node) {
+      const char *fragment = node->_fragment.constData();
+      for (int j = 0; fragment[j]; ++j, ++i)
+        if (key[i] != fragment[j])
+          return found; // key shorter or different -> doesn't match
+      if (node->_nodetype == RadixTree<T>::Prefix) {
+        found = node;
+        *matchedLength = i;
+      }
+      if (!key[i]) { // end of key
+        if (node->_nodetype == RadixTree<T>::Exact) {
+          found = node;
+          *matchedLength = i;
+        }
+        return found;
+      }
+      size_t j = node->child_index(key[i]);
+      if (j >= node->_children.size()
+          || node->_children[j]->_fragment[0] != key[i])
+        return found;
+      node = node->_children[j].constData();
+    }
+    return found;
+  }
+};
+
+#endif // CONCURRENTRADIXTREE_H
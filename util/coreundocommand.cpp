@@ -23,8 +23,9 @@ void CoreUndoCommand::redo() {
 }
 
 void CoreUndoCommand::undo() {
-  for (auto child: _children)
-    child->undo();
+  // reverse order, like QUndoCommand
+  for (auto child = _children.crbegin(); child != _children.crend(); ++child)
+    (*child)->undo();
 }
 
 int	CoreUndoCommand::id() const {
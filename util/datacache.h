@@ -17,6 +17,9 @@
 #include "libp6core_global.h"
 #include <QCache>
 #include <QMutexLocker>
+#include <QWaitCondition>
+#include <QThread>
+#include <atomic>
 #include <functional>
 
 /** Non-thread-safe helper for QCache holding implicitly shared data objects.
@@ -24,7 +27,8 @@
  *  DataCache<int,MyData> cache;
  *  auto data = cache.get_or_create(key, [&](){ return MyData(whatever); });
  *
- *  For thread-safe cache, use either MultiThreadDataCache or DataCache with
+ *  For thread-safe cache, use either MultiThreadDataCache,
+ *  ShardedDataCache or DataCache with
  *  thread_local storage class which is lock-free but takes more memory and/or
  *  more compilation time depending of the kind of cached data types.
  */
@@ -77,4 +81,90 @@ public:
   }
 };
 
+/** Thread-safe helper for QCache holding implicitly shared data objects,
+ *  globally across all threads, with less contention than
+ *  MultiThreadDataCache.
+ *  Keys are spread by qHash() over Shards independent QCache, each with its
+ *  own mutex and maxCost/Shards capacity.
+ *  Concurrent misses on the same key are deduplicated: only one thread calls
+ *  creator(), others wait for its value.
+ *  Optional cost function gives each value its QCache cost (default: 1).
+ *  creator() is called without any lock held, so it may call get_or_create()
+ *  for other keys, but never for its own key: it would wait for itself
+ *  forever (this is asserted in debug builds).
+ *  usage:
+ *  ShardedDataCache<Utf8String,QRegularExpression> cache { 4096 };
+ *  auto re = cache.get_or_create(key, [&](){
+ *    return QRegularExpression(key); });
+ */
+template <typename K, typename T, int Shards = 16>
+class LIBP6CORESHARED_EXPORT ShardedDataCache {
+public:
+  using CostFunction = std::function<qsizetype(const T &)>;
+  struct Stats {
+    quint64 hits, misses, evictions;
+  };
+
+private:
+  struct alignas(64) Shard {
+    QCache<K,T> _cache;
+    QHash<K,Qt::HANDLE> _in_flight; // key -> thread calling creator()
+    QMutex _mutex;
+    QWaitCondition _created;
+  };
+  Shard _shards[Shards];
+  CostFunction _cost;
+  std::atomic<quint64> _hits = 0, _misses = 0, _evictions = 0;
+
+public:
+  inline ShardedDataCache(qsizetype maxCost = 100, CostFunction cost = {})
+    : _cost(cost) {
+    for (auto &shard: _shards)
+      shard._cache.setMaxCost(qMax<qsizetype>(maxCost/Shards, 1));
+  }
+  T get_or_create(K key, std::function<T()> creator) {
+    auto &shard = _shards[qHash(key) % Shards];
+    QMutexLocker locker(&shard._mutex);
+    while (true) {
+      auto ptr = shard._cache[key];
+      if (ptr) {
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        return T(*ptr);
+      }
+      auto creating_thread = shard._in_flight.value(key);
+      if (!creating_thread)
+        break;
+      Q_ASSERT_X(creating_thread != QThread::currentThreadId(),
+                 "ShardedDataCache::get_or_create",
+                 "creator() recursively asked for its own key");
+      shard._created.wait(&shard._mutex); // another thread is creating it
+    }
+    _misses.fetch_add(1, std::memory_order_relaxed);
+    shard._in_flight.insert(key, QThread::currentThreadId());
+    locker.unlock();
+    T value = creator();
+    auto cost = _cost ? _cost(value) : 1;
+    locker.relock();
+    shard._in_flight.remove(key);
+    auto size = shard._cache.size();
+    shard._cache.insert(key, new T(value), cost);
+    // one was inserted, any missing one has been evicted (or rejected)
+    _evictions.fetch_add(size+1-shard._cache.size(),
+                         std::memory_order_relaxed);
+    shard._created.wakeAll();
+    return value;
+  }
+  Stats stats() const {
+    return { _hits.load(std::memory_order_relaxed),
+             _misses.load(std::memory_order_relaxed),
+             _evictions.load(std::memory_order_relaxed) };
+  }
+  void clear() {
+    for (auto &shard: _shards) {
+      QMutexLocker locker(&shard._mutex);
+      shard._cache.clear();
+    }
+  }
+};
+
 #endif // DATACACHE_H
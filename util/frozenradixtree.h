@@ -0,0 +1,237 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FROZENRADIXTREE_H
+#define FROZENRADIXTREE_H
+
+#include "util/radixtree.h"
+#include <bit>
+#include <limits>
+#include <vector>
+
+/** Read-only, cache-friendly, compacted version of a RadixTree.
+ *
+ * Built once from a mutable RadixTree, it has the same lookup semantics
+ * (exact and prefix keys, matchedLength) but stores every node in a single
+ * contiguous array, in breadth-first order so that the children of a node are
+ * contiguous and sorted by their first byte.
+ * Each node is exactly one cache line (64 bytes) and holds:
+ * - a 256 bits bitmap of its children first bytes, the index of a child being
+ *   the index of the first child plus the rank (popcount) of its first byte in
+ *   the bitmap,
+ * - its key fragment, inline if short enough, otherwise as an offset in a
+ *   shared fragments heap,
+ * - an index in the values array.
+ * Therefore a lookup walks down the nodes array without any pointer chasing
+ * nor children scan.
+ *
+ * Usage:
+ * static FrozenRadixTree<int> foo { { "abc", 42, true }, { "xyz", -1 } };
+ * FrozenRadixTree<MessageHandler> handlers { mutable_tree };
+ *
+ * Keys are expected to be encoded in utf-8.
+ *
+ * This class implements Qt's implicit sharing pattern, since it's read-only
+ * it's also thread-safe.
+ */
+template<class T>
+class FrozenRadixTree {
+  using NodeType = typename RadixTree<T>::NodeType;
+  using SourceNode = typename RadixTree<T>::Node;
+  static constexpr int InlineFragmentSize = 20;
+
+  struct alignas(64) Node {
+    quint64 _children_map[4]; // bitmap of children first bytes
+    quint32 _first_child; // index of first child in _nodes
+    quint32 _value_index; // index in _values, meaningless if Empty
+    quint16 _fragment_length;
+    NodeType _nodetype;
+    union {
+      char _inline[InlineFragmentSize];
+      quint32 _offset; // offset in _fragments if not inline
+    };
+    bool has_child(unsigned char c) const {
+      return _children_map[c >> 6] & (1ULL << (c & 63));
+    }
+    /** index of child whose first byte is c, assuming has_child(c) */
+    quint32 child(unsigned char c) const {
+      int word = c >> 6;
+      quint32 rank = std::popcount(
+                       _children_map[word] & ((1ULL << (c & 63)) - 1));
+      for (int i = 0; i < word; ++i)
+        rank += std::popcount(_children_map[i]);
+      return _first_child + rank;
+    }
+    int children_count() const {
+      return std::popcount(_children_map[0]) + std::popcount(_children_map[1])
+          + std::popcount(_children_map[2]) + std::popcount(_children_map[3]);
+    }
+  };
+  static_assert(sizeof(Node) == 64);
+
+  struct FrozenRadixTreeData : QSharedData {
+    std::vector<Node> _nodes; // _nodes[0] is root
+    std::vector<T> _values;
+    QByteArray _fragments; // heap for fragments too long to be inlined
+    Utf8StringSet _keys;
+    const char *fragment(const Node &node) const {
+      return node._fragment_length <= InlineFragmentSize
+          ? node._inline : _fragments.constData() + node._offset;
+    }
+  };
+
+  QSharedDataPointer<FrozenRadixTreeData> d;
+
+public:
+  FrozenRadixTree() : d(new FrozenRadixTreeData) { }
+  explicit FrozenRadixTree(const RadixTree<T> &tree)
+    : d(new FrozenRadixTreeData) {
+    const SourceNode *root = tree.d->_root;
+    d->_keys = tree.keys();
+    if (!root)
+      return;
+    // breadth-first walk, so that every node's children are contiguous
+    std::vector<const SourceNode *> sources { root };
+    for (size_t i = 0; i < sources.size(); ++i) {
+      const SourceNode *source = sources[i];
+      Node node {};
+      auto length = strlen(source->_fragment);
+      Q_ASSERT(length <= std::numeric_limits<quint16>::max());
+      node._fragment_length = length;
+      if (length <= InlineFragmentSize) {
+        memcpy(node._inline, source->_fragment, length);
+      } else {
+        node._offset = d->_fragments.size();
+        d->_fragments.append(source->_fragment, length);
+      }
+      node._nodetype = source->_nodetype;
+      if (source->_nodetype != RadixTree<T>::Empty) {
+        node._value_index = d->_values.size();
+        d->_values.push_back(source->_value);
+      }
+      node._first_child = sources.size();
+      // children are sorted by fragment and have distinct first bytes
+      for (int j = 0; j < source->_childrenCount; ++j) {
+        const SourceNode *child = source->_children[j];
+        unsigned char c = child->_fragment[0];
+        node._children_map[c >> 6] |= 1ULL << (c & 63);
+        sources.push_back(child);
+      }
+      d->_nodes.push_back(node);
+    }
+  }
+  FrozenRadixTree(std::initializer_list<RadixTreeInitializerHelper<T>> list)
+    : FrozenRadixTree(RadixTree<T>(list)) { }
+  FrozenRadixTree(const FrozenRadixTree &other) : d(other.d) { }
+  FrozenRadixTree &operator=(const FrozenRadixTree &other) {
+    if (&other != this)
+      d = other.d;
+    return *this;
+  }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T value(const char *key, T defaultValue = T(),
+                int *matchedLength = 0) const {
+    int ignored_length;
+    if (!matchedLength)
+      matchedLength = &ignored_length;
+    int value_index = lookup(key, matchedLength);
+    return value_index < 0 ? defaultValue : d->_values[value_index];
+  }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T value(const char *key, int *matchedLength) const {
+    return value(key, T(), matchedLength); }
+  const T value(const QString &key, T defaultValue = T(),
+                int *matchedLength = 0) const {
+    return value(key.toUtf8().constData(), defaultValue, matchedLength); }
+  const T value(const QString &key, int *matchedLength) const {
+    return value(key.toUtf8().constData(), T(), matchedLength); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T value(const QByteArray &key, T defaultValue = T(),
+                int *matchedLength = 0) const {
+    return value(key.constData(), defaultValue, matchedLength); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T value(const QByteArray &key, int *matchedLength) const {
+    return value(key.constData(), T(), matchedLength); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T operator[](const char *key) const { return value(key); }
+  const T operator[](const QString &key) const {
+    return value(key.toUtf8().constData()); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  const T operator[](const QByteArray &key) const {
+    return value(key.constData()); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  bool contains(const char *key) const {
+    int ignored_length;
+    return lookup(key, &ignored_length) >= 0;
+  }
+  bool contains(const QString &key) const {
+    return contains(key.toUtf8().constData()); }
+  /** assumes that key is UTF-8 (or of course ASCII) */
+  bool contains(const QByteArray &key) const {
+    return contains(key.constData()); }
+  Utf8StringSet keys() const { return d->_keys; }
+  bool isEmpty() const { return d->_nodes.empty(); }
+  /** number of nodes, which is >= number of keys */
+  qsizetype nodesCount() const { return d->_nodes.size(); }
+  QString toDebugString() const {
+    QString s = "FrozenRadixTree 0x" + QString::number((quint64)this, 16)
+        + " " + QString::number(d->_nodes.size()) + " nodes "
+        + QString::number(d->_fragments.size()) + " heap bytes\n";
+    for (size_t i = 0; i < d->_nodes.size(); ++i) {
+      const Node &node = d->_nodes[i];
+      s += QString::number(i) + " \""
+          + QString::fromUtf8(d->fragment(node), node._fragment_length) + "\" "
+          + SourceNode::nodetypeToString(node._nodetype);
+      if (auto n = node.children_count())
+        s += " children: " + QString::number(node._first_child) + ".."
+            + QString::number(node._first_child+n-1);
+      s += '\n';
+    }
+    return s;
+  }
+
+private:
+  /** iterative lookup, remembering the deepest prefix node on the way
+   * @return index in _values or -1 if not found */
+  int lookup(const char *key, int *matchedLength) const {
+    Q_ASSERT(key);
+    const auto &nodes = d->_nodes;
+    int found = -1, i = 0;
+    *matchedLength = 0;
+    if (nodes.empty())
+      return -1;
+    for (const Node *node = nodes.data();;) {
+      const char *fragment = d->fragment(*node);
+      for (int j = 0; j < node->_fragment_length; ++j, ++i)
+        if (key[i] != fragment[j])
+          return found; // key shorter or different -> doesn't match
+      if (node->_nodetype == RadixTree<T>::Prefix) {
+        found = node->_value_index;
+        *matchedLength = i;
+      }
+      unsigned char c = key[i];
+      if (!c) { // end of key
+        if (node->_nodetype == RadixTree<T>::Exact) {
+          found = node->_value_index;
+          *matchedLength = i;
+        }
+        return found;
+      }
+      if (!node->has_child(c))
+        return found;
+      node = nodes.data() + node->child(c);
+    }
+  }
+};
+
+#endif // FROZENRADIXTREE_H
@@ -18,7 +18,7 @@
 #include "format/stringutils.h"
 #include "radixtree.h"
 #include "pf/pfnode.h"
-#include "csv/csvfile.h"
+#include "csv/csvreader.h"
 #include "util/utf8string.h"
 #include <QRegularExpression>
 #include <QFile>
@@ -466,15 +466,11 @@ ParamSetData *ParamSet::fromQIODevice(
   auto separator = options.value("separator"_u8).value(0,',');
   auto quote = options.value("quote"_u8).value(0,'"');
   auto escape = options.value("escape"_u8).value(0,'\\');
-  CsvFile csvfile;
-  csvfile.enableHeaders(false);
-  csvfile.setFieldSeparator(separator);
-  csvfile.setQuoteChar(quote);
-  csvfile.setEscapeChar(escape);
-  csvfile.openReadonly(input);
-  auto rows = csvfile.rows();
-  //qDebug() << "***password from csv" << rows << separator << quote << escape;
-  for (const auto &row: rows) {
+  CsvReader reader(input, separator, escape, quote);
+  Utf8StringList row;
+  bool atEnd = false;
+  while (!atEnd && reader.readRow(&row, &atEnd)) {
+    //qDebug() << "***password from csv" << row << separator << quote << escape;
     auto key = row.value(0);
     auto value = row.value(1);
     if (key.isEmpty())
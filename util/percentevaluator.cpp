@@ -15,7 +15,7 @@
 #include "paramsprovider.h"
 #include "paramset.h"
 #include "util/utf8stringset.h"
-#include "util/radixtree.h"
+#include "util/concurrentradixtree.h"
 #include "util/paramsformula.h"
 #include "util/regexpparamsprovider.h"
 #include "util/paramsprovidermerger.h"
@@ -49,20 +49,20 @@ static const auto _re_sub_opts =
     QRegularExpression::DotMatchesEverythingOption // can be canceled with (?-s)
     ;
 
-static RadixTree<PercentEvaluator::EvalFunction>
+static ConcurrentRadixTree<PercentEvaluator::EvalFunction>
 _functions {
 { "=date", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
   return TimeFormats::toMultifieldSpecifiedCustomTimestamp(
         QDateTime::currentDateTime(), key.mid(ml), context);
 }, true},
 { "=coarsetimeinterval", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto msecs = PercentEvaluator::eval_number<double>(
                  params.value(0), 0.0, context)*1000;
   return TimeFormats::toCoarseHumanReadableTimeInterval(msecs);
 }, true},
 { "=switch", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   if (params.size() < 1)
     [[unlikely]] return {};
   auto input = PercentEvaluator::eval(params.value(0), context);
@@ -81,7 +81,7 @@ _functions {
   return input;
 }, true},
 { "=match", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   if (params.size() < 1)
     [[unlikely]] return {};
   auto input = PercentEvaluator::eval(params.value(0), context);
@@ -171,22 +171,22 @@ _functions {
   return value;
 }, true},
 { "=uppercase", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto input = PercentEvaluator::eval_utf8(params.value(0), context);
   return input.toUpper();
 }, true},
 { "=lowercase", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto input = PercentEvaluator::eval_utf8(params.value(0), context);
   return input.toLower();
 }, true},
 { "=titlecase", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto input = PercentEvaluator::eval_utf8(params.value(0), context);
   return input.toTitle();
 }, true},
 { "=left", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto input = PercentEvaluator::eval_utf8(params.value(0), context);
   bool ok;
   int i = params.value(1).toInt(&ok);
@@ -200,7 +200,7 @@ _functions {
   return input;
 }, true},
 { "=right", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto input = PercentEvaluator::eval_utf8(params.value(0), context);
   bool ok;
   int i = params.value(1).toInt(&ok);
@@ -214,7 +214,7 @@ _functions {
   return input;
 }, true},
 { "=mid", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto input = PercentEvaluator::eval_utf8(params.value(0), context);
   bool ok;
   int i = params.value(1).toInt(&ok);
@@ -229,7 +229,7 @@ _functions {
   return input;
 }, true},
 { "=box", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto input = PercentEvaluator::eval_utf8(params.value(0), context);
   auto size = PercentEvaluator::eval_number<qsizetype>(params.value(1),context);
   auto flags = params.value(2);
@@ -260,32 +260,32 @@ _functions {
   return input;
 }, true},
 { "=trim", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto input = PercentEvaluator::eval_utf8(key.mid(ml+1), context);
+  auto input = PercentEvaluator::eval_utf8(Utf8StringView(key).mid(ml+1), context);
   return input.trimmed();
 }, true},
 { "=elideright", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto input = PercentEvaluator::eval_utf8(params.value(0), context);
   auto size = PercentEvaluator::eval_number<qsizetype>(params.value(1),context);
   auto ellipsis = PercentEvaluator::eval_utf8(params.value(2),context)|"..."_u8;
   return Utf8String::elide_right(input, size, ellipsis);
 }, true},
 { "=elideleft", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto input = PercentEvaluator::eval_utf8(params.value(0), context);
   auto size = PercentEvaluator::eval_number<qsizetype>(params.value(1),context);
   auto ellipsis = PercentEvaluator::eval_utf8(params.value(2),context)|"..."_u8;
   return Utf8String::elide_left(input, size, ellipsis);
 }, true},
 { "=elidemiddle", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto input = PercentEvaluator::eval_utf8(params.value(0), context);
   auto size = PercentEvaluator::eval_number<qsizetype>(params.value(1),context);
   auto ellipsis = PercentEvaluator::eval_utf8(params.value(2),context)|"..."_u8;
   return Utf8String::elide_middle(input, size, ellipsis);
 }, true},
 { "=htmlencode", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   if (params.size() < 1)
     return {};
   auto input = PercentEvaluator::eval_utf16(params.value(0), context);
@@ -295,7 +295,7 @@ _functions {
         flags.contains('n')); // newline as <br>
 }, true},
 { "=random", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto modulo = ::llabs(PercentEvaluator::eval_number<qlonglong>(
                           params.value(0), 0, context));
   auto shift = PercentEvaluator::eval_number<qlonglong>(
@@ -306,7 +306,7 @@ _functions {
   return i + shift;
 }, true},
 { "=env", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto env = ParamsProvider::environment();
   int i = 0;
   auto ppm = ParamsProviderMerger(env)(context);
@@ -342,33 +342,33 @@ _functions {
   return PercentEvaluator::eval(params.value(i), context);
 }, true},
 { "=sha1", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto value = PercentEvaluator::eval_utf8(key.mid(ml+1), context);
+  auto value = PercentEvaluator::eval_utf8(Utf8StringView(key).mid(ml+1), context);
   return Utf8String(QCryptographicHash::hash(
                       value, QCryptographicHash::Sha1).toHex());
 }, true},
 { "=sha256", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto value = PercentEvaluator::eval_utf8(key.mid(ml+1), context);
+  auto value = PercentEvaluator::eval_utf8(Utf8StringView(key).mid(ml+1), context);
   return Utf8String(QCryptographicHash::hash(
                       value, QCryptographicHash::Sha256).toHex());
 }, true},
 { "=md5", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto value = PercentEvaluator::eval_utf8(key.mid(ml+1), context);
+  auto value = PercentEvaluator::eval_utf8(Utf8StringView(key).mid(ml+1), context);
   return Utf8String(QCryptographicHash::hash(
                       value, QCryptographicHash::Md5).toHex());
 }, true},
 { "=hex", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto value = PercentEvaluator::eval_utf8(params.value(0), context);
   auto separator = params.value(1);
   return value.toHex(separator.value(0));
 }, true},
 { "=fromhex", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto value = PercentEvaluator::eval_utf8(params.value(0), context);
   return QByteArray::fromHex(value);
 }, true},
 { "=base64", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto value = PercentEvaluator::eval_utf8(params.value(0), context);
   auto flags = params.value(1);
   QByteArray::Base64Options options =
@@ -379,7 +379,7 @@ _functions {
   return value.toBase64(options);
 }, true},
 { "=frombase64", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   auto value = PercentEvaluator::eval_utf8(params.value(0), context);
   auto flags = params.value(1);
   QByteArray::Base64Options options =
@@ -399,7 +399,7 @@ _functions {
   return formula.eval(context);
 }, true},
 { "=int64", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   for (const auto &param: params) {
     bool ok;
     auto i = PercentEvaluator::eval_number<qint64>(param, context, &ok);
@@ -409,7 +409,7 @@ _functions {
   return {};
 }, true},
 { "=uint64", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   for (const auto &param: params) {
     bool ok;
     auto i = PercentEvaluator::eval_number<quint64>(param, context, &ok);
@@ -419,7 +419,7 @@ _functions {
   return {};
 }, true},
 { "=double", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   for (const auto &param: params) {
     bool ok;
     auto i = PercentEvaluator::eval_number<double>(param, context, &ok);
@@ -429,7 +429,7 @@ _functions {
   return {};
 }, true},
 { "=bool", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   for (const auto &param: params) {
     bool ok;
     auto i = PercentEvaluator::eval_number<bool>(param, context, &ok);
@@ -439,7 +439,7 @@ _functions {
   return {};
 }, true},
   { "=eval", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-    auto v = "%{"_u8+PercentEvaluator::eval_utf8(key.mid(ml+1), context)+'}';
+    auto v = "%{"_u8+PercentEvaluator::eval_utf8(Utf8StringView(key).mid(ml+1), context)+'}';
     return v % context;
   }, true},
   { "=rawvalue", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
@@ -464,7 +464,7 @@ _functions {
     return {};
   }, true},
 { "=default", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   for (const auto &param: params) {
     auto v = param % context;
     if (auto s = v.as_utf8(); !s.isEmpty())
@@ -473,7 +473,7 @@ _functions {
   return {};
 }, true},
 { "=utf8", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   for (const auto &param: params) {
     auto v = param % context;
     if (auto s = v.as_utf8(); !s.isEmpty())
@@ -482,7 +482,7 @@ _functions {
   return {};
 }, true},
 { "=utf16", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   for (const auto &param: params) {
     auto v = param % context;
     if (auto s = v.as_utf16(); !s.isEmpty())
@@ -491,14 +491,14 @@ _functions {
   return {};
 }, true},
 { "=coalesce", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   for (const auto &param: params)
     if (auto v = param % context; !!v)
       return v; // =default would test Utf8String(v) is not empty
   return {};
 }, true},
 { "=formatint64", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   bool ok;
   auto i = PercentEvaluator::eval_number<qint64>(params.value(0), context, &ok);
   if (!ok)
@@ -509,7 +509,7 @@ _functions {
   return padding.utf8left(padding.utf8size()-s.utf8size())+s;
 }, true},
 { "=formatuint64", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   bool ok;
   auto i = PercentEvaluator::eval_number<quint64>(params.value(0), context, &ok);
   if (!ok)
@@ -520,7 +520,7 @@ _functions {
   return padding.utf8left(padding.utf8size()-s.utf8size())+s;
 }, true},
 { "=formatdouble", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   bool ok;
   auto d = PercentEvaluator::eval_number<double>(params.value(0), context, &ok);
   char fmt = PercentEvaluator::eval_utf8(
@@ -530,7 +530,7 @@ _functions {
   return ok ? Utf8String::number(d, fmt, prec) : def;
 }, true},
 { "=formatboolean", [](const Utf8String &key, const EvalContext &context, int ml) STATIC_LAMBDA -> TypedValue {
-  auto params = key.split_headed_list(ml);
+  auto params = Utf8StringView(key).split_headed_list(ml);
   bool ok;
   auto b = PercentEvaluator::eval_number<bool>(params.value(0), context, &ok);
   // param 2 (format) is ignored
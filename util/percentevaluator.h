@@ -15,6 +15,7 @@
 #define PERCENTEVALUATOR_H
 
 #include "utf8stringset.h"
+#include "util/utf8stringview.h"
 #include "util/typedvalue.h"
 
 class ParamsProvider;
@@ -123,6 +124,14 @@ struct LIBP6CORESHARED_EXPORT PercentEvaluator {
     auto begin = expr.constData();
     return eval(begin, begin+expr.size(), context);
   }
+  /** Same with a view e.g. on a function param: expr is only copied when it's
+   *  returned as is (i.e. when it does not contain any %). */
+  [[nodiscard]] static inline TypedValue eval(
+      Utf8StringView expr, const EvalContext &context = {}) {
+    if (!expr.contains('%'))
+      return expr.toUtf8();
+    return eval(expr.begin(), expr.end(), context);
+  }
   /** Lower level version of the method with char* params. */
   [[nodiscard]] static TypedValue eval(
       const char *expr, const char *end, const EvalContext &context = {});
@@ -178,6 +187,17 @@ struct LIBP6CORESHARED_EXPORT PercentEvaluator {
   [[nodiscard]] inline static Utf8String eval_utf8(
       const Utf8String &expr, const EvalContext &context) {
     return eval(expr, context).as_utf8(); }
+  [[nodiscard]] inline static Utf8String eval_utf8(
+      Utf8StringView expr, const Utf8String &def = {},
+      const EvalContext &context = {}) {
+    auto v = eval(expr, context);
+    if (!!v)
+      return v.as_utf8();
+    return def;
+  }
+  [[nodiscard]] inline static Utf8String eval_utf8(
+      Utf8StringView expr, const EvalContext &context) {
+    return eval(expr, context).as_utf8(); }
   /** Evaluate and then convert result to utf16 text.
    *
    *  @param context is an evaluation context, can be empty (only contextless
@@ -191,6 +211,15 @@ struct LIBP6CORESHARED_EXPORT PercentEvaluator {
   [[nodiscard]] inline static QString eval_utf16(
       const Utf8String &expr, const EvalContext &context) {
     return eval_utf16(expr, {}, context); }
+  [[nodiscard]] inline static QString eval_utf16(
+      Utf8StringView expr, const QString &def = {},
+      const EvalContext &context = {}) {
+    auto v = eval(expr, context);
+    return !!v ? v.as_utf16() : def;
+  }
+  [[nodiscard]] inline static QString eval_utf16(
+      Utf8StringView expr, const EvalContext &context) {
+    return eval_utf16(expr, {}, context); }
   /** Evaluate and then convert result to number (i.e. floating, integer or
    *  boolean).
    *
@@ -213,6 +242,17 @@ struct LIBP6CORESHARED_EXPORT PercentEvaluator {
       const Utf8String &expr, const EvalContext &context, bool *ok = nullptr) {
     return eval(expr, context).as_number<T>({}, ok);
   }
+  template <p6::arithmetic T>
+  [[nodiscard]] inline static T eval_number(
+      Utf8StringView expr, const T &def = {},
+      const EvalContext &context = {}, bool *ok = nullptr)  {
+    return eval(expr, context).as_number<T>(def, ok);
+  }
+  template <p6::arithmetic T>
+  [[nodiscard]] inline static T eval_number(
+      Utf8StringView expr, const EvalContext &context, bool *ok = nullptr) {
+    return eval(expr, context).as_number<T>({}, ok);
+  }
 
   // escape and matching patterns
   /** Escape all characters in string so that they no longer have special
@@ -284,7 +324,8 @@ struct LIBP6CORESHARED_EXPORT PercentEvaluator {
   static void enable_variable_not_found_logging(bool enabled = true);
 
   // extension
-  /** Add a custom %= function. */
+  /** Add a custom %= function.
+   * Thread-safe, can be called while other threads are evaluating. */
   static void register_function(const char *key, EvalFunction function);
 };
 
@@ -312,6 +353,24 @@ inline TypedValue operator%(
   return PercentEvaluator::eval(expr, &params);
 }
 
+/** Syntaxic sugar to shorten PercentEvaluator::eval
+ *  for (auto param: Utf8StringView(key).split_headed_list(ml))
+ *    Utf8String value = param % context;
+ */
+inline TypedValue operator%(
+    Utf8StringView expr, const PercentEvaluator::EvalContext &context) {
+  return PercentEvaluator::eval(expr, context);
+}
+
+/** Syntaxic sugar to shorten PercentEvaluator::eval
+ *  for (auto param: Utf8StringView(key).split_headed_list(ml))
+ *    Utf8String value = param % params;
+ */
+inline TypedValue operator%(
+    Utf8StringView expr, const ParamsProvider &params) {
+  return PercentEvaluator::eval(expr, &params);
+}
+
 /** Syntaxic sugar to shorten PercentEvaluator::eval
  *  auto foo = "%foo"_u8;
  *  foo %= params;
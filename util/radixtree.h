@@ -25,6 +25,11 @@
  * };
  * keys are encoded in utf-8
  */
+template<class T>
+class FrozenRadixTree;
+template<class T>
+class ConcurrentRadixTree;
+
 template<class T>
 struct RadixTreeInitializerHelper {
   std::vector<const char *> _keys;
@@ -65,9 +70,16 @@ struct RadixTreeInitializerHelper {
  * Keys are expected to be encoded in utf-8.
  *
  * This class implements Qt's implicit sharing pattern.
+ *
+ * For read-mostly trees, FrozenRadixTree provides a compacted and faster
+ * read-only version.
+ * For trees read by several threads and updated at runtime,
+ * ConcurrentRadixTree provides a read-copy-update version.
  */
 template<class T>
 class RadixTree {
+  friend class FrozenRadixTree<T>;
+  friend class ConcurrentRadixTree<T>;
   enum NodeType : signed char { Empty = 0, Exact, Prefix };
   using Visitor = std::function<void(const QByteArray *, NodeType, T)>;
   using AbortableVisitor = std::function<bool(const QByteArray *, NodeType, T)>;
@@ -282,7 +294,9 @@ class RadixTree {
       if (childrenCount <= 0)
         return false;
       int middle = childrenCount >> 1;
-      int cmp = children[middle]->_fragment[0] - key[0];
+      // compare as unsigned, consistently with strcmp() used by addChild()
+      int cmp = (unsigned char)children[middle]->_fragment[0]
+                - (unsigned char)key[0];
       if (cmp > 0)
         return lookupAmongChildren(key, value, children, middle, matchedLength);
       if (cmp < 0)
@@ -0,0 +1,336 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "utf8kernels.h"
+#include <bit>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) \
+  && (defined(__GNUC__) || defined(__clang__))
+#define P6_UTF8_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace p6::utf8 {
+
+namespace {
+
+// scalar kernels, also used for tails shorter than a vector register
+
+const quint64 HighBits = 0x8080'8080'8080'8080ULL;
+
+inline qsizetype scalar_ascii_prefix_size(const char *s, const char *end) {
+  auto begin = s;
+  for (; s+8 <= end; s += 8) { // 8 bytes at a time
+    quint64 word;
+    ::memcpy(&word, s, 8);
+    if (word & HighBits)
+      break;
+  }
+  for (; s < end; ++s)
+    if (static_cast<unsigned char>(*s) >= 0x80)
+      break;
+  return s-begin;
+}
+
+/** is there a byte order mark starting at s ? */
+inline bool is_bom(const char *s, const char *end) {
+  auto c = reinterpret_cast<const unsigned char *>(s);
+  return c[0] == 0xef && s+3 <= end && c[1] == 0xbb && c[2] == 0xbf;
+}
+
+inline qsizetype scalar_chars_count(const char *s, const char *end) {
+  qsizetype count = 0;
+  for (; s < end; ++s) {
+    auto c = static_cast<unsigned char>(*s);
+    if ((c & 0b1100'0000) != 0b1000'0000)
+      ++count;
+    if (c == 0xef && is_bom(s, end))
+      --count;
+  }
+  return count;
+}
+
+inline qsizetype scalar_prefix_size_not_in(
+    const char *s, const char *end, QByteArrayView set) {
+  auto begin = s;
+  for (; s < end; ++s)
+    for (char c: set)
+      if (*s == c)
+        return s-begin;
+  return s-begin;
+}
+
+/** size of the valid non-ascii sequence starting at s, 0 if invalid */
+inline int valid_sequence_size(const char *s, const char *end) {
+  auto c = reinterpret_cast<const unsigned char *>(s);
+  auto is_continuation = [](unsigned char c) { return (c & 0xc0) == 0x80; };
+  if (c[0] < 0xc2) // out of sequence continuation byte or overlong 2 bytes
+    return 0;
+  if (c[0] < 0xe0)
+    return s+2 <= end && is_continuation(c[1]) ? 2 : 0;
+  if (c[0] < 0xf0) {
+    if (s+3 > end || !is_continuation(c[1]) || !is_continuation(c[2]))
+      return 0;
+    if ((c[0] == 0xe0 && c[1] < 0xa0) // overlong
+        || (c[0] == 0xed && c[1] >= 0xa0)) // surrogate halves
+      return 0;
+    return 3;
+  }
+  if (c[0] < 0xf5) {
+    if (s+4 > end || !is_continuation(c[1]) || !is_continuation(c[2])
+        || !is_continuation(c[3]))
+      return 0;
+    if ((c[0] == 0xf0 && c[1] < 0x90) // overlong
+        || (c[0] == 0xf4 && c[1] >= 0x90)) // > 0x10ffff
+      return 0;
+    return 4;
+  }
+  return 0; // > 0x10ffff or 5+ bytes sequence
+}
+
+/** valid prefix size, skipping ascii runs with ascii_prefix_size kernel */
+template <qsizetype (*ascii_prefix_size)(const char *, const char *)>
+inline qsizetype generic_valid_prefix_size(const char *s, const char *end) {
+  auto begin = s;
+  while (s < end) {
+    if (static_cast<unsigned char>(*s) < 0x80) {
+      s += ascii_prefix_size(s, end);
+      [[likely]] continue;
+    }
+    auto n = valid_sequence_size(s, end);
+    if (!n)
+      break;
+    s += n;
+  }
+  return s-begin;
+}
+
+template <char first, char last>
+inline void scalar_ascii_case(char *d, const char *s, qsizetype n) {
+  for (qsizetype i = 0; i < n; ++i) {
+    char c = s[i];
+    d[i] = c >= first && c <= last ? c ^ 0x20 : c;
+  }
+}
+
+#ifdef P6_UTF8_X86_KERNELS
+
+// SSE2 kernels, 16 bytes at a time, always available on x86_64
+
+inline qsizetype sse2_ascii_prefix_size(const char *s, const char *end) {
+  auto begin = s;
+  for (; s+16 <= end; s += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+    if (int mask = _mm_movemask_epi8(v); mask)
+      return s-begin+std::countr_zero(static_cast<unsigned>(mask));
+  }
+  return s-begin+scalar_ascii_prefix_size(s, end);
+}
+
+inline qsizetype sse2_chars_count(const char *s, const char *end) {
+  qsizetype count = 0;
+  const auto continuation = _mm_set1_epi8(-64); // < -64 <=> 0x80..0xbf
+  const auto bom = _mm_set1_epi8(static_cast<char>(0xef));
+  for (; s+16 <= end; s += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+    unsigned cont = _mm_movemask_epi8(_mm_cmplt_epi8(v, continuation));
+    count += 16-std::popcount(cont);
+    for (unsigned efs = _mm_movemask_epi8(_mm_cmpeq_epi8(v, bom)); efs;
+         efs &= efs-1)
+      if (is_bom(s+std::countr_zero(efs), end))
+        [[unlikely]] --count;
+  }
+  return count+scalar_chars_count(s, end);
+}
+
+inline qsizetype sse2_prefix_size_not_in(
+    const char *s, const char *end, QByteArrayView set) {
+  __m128i needles[MaxBytesSetSize];
+  auto n = set.size();
+  for (qsizetype i = 0; i < n; ++i)
+    needles[i] = _mm_set1_epi8(set[i]);
+  auto begin = s;
+  for (; s+16 <= end; s += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+    auto found = _mm_setzero_si128();
+    for (qsizetype i = 0; i < n; ++i)
+      found = _mm_or_si128(found, _mm_cmpeq_epi8(v, needles[i]));
+    if (int mask = _mm_movemask_epi8(found); mask)
+      return s-begin+std::countr_zero(static_cast<unsigned>(mask));
+  }
+  return s-begin+scalar_prefix_size_not_in(s, end, set);
+}
+
+template <char first, char last>
+inline void sse2_ascii_case(char *d, const char *s, qsizetype n) {
+  // non-ascii bytes are negative and therefore never in [first,last]
+  const auto lower_bound = _mm_set1_epi8(first-1);
+  const auto upper_bound = _mm_set1_epi8(last+1);
+  const auto flip = _mm_set1_epi8(0x20);
+  qsizetype i = 0;
+  for (; i+16 <= n; i += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s+i));
+    auto in_range = _mm_and_si128(_mm_cmpgt_epi8(v, lower_bound),
+                                  _mm_cmplt_epi8(v, upper_bound));
+    v = _mm_xor_si128(v, _mm_and_si128(in_range, flip));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(d+i), v);
+  }
+  scalar_ascii_case<first, last>(d+i, s+i, n-i);
+}
+
+// AVX2 kernels, 32 bytes at a time, selected at runtime
+
+[[gnu::target("avx2")]]
+qsizetype avx2_ascii_prefix_size(const char *s, const char *end) {
+  auto begin = s;
+  for (; s+32 <= end; s += 32) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+    if (unsigned mask = _mm256_movemask_epi8(v); mask)
+      return s-begin+std::countr_zero(mask);
+  }
+  return s-begin+sse2_ascii_prefix_size(s, end);
+}
+
+[[gnu::target("avx2")]]
+qsizetype avx2_chars_count(const char *s, const char *end) {
+  qsizetype count = 0;
+  const auto continuation = _mm256_set1_epi8(-64); // < -64 <=> 0x80..0xbf
+  const auto bom = _mm256_set1_epi8(static_cast<char>(0xef));
+  for (; s+32 <= end; s += 32) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+    // avx2 has no cmplt, hence cmpgt with swapped operands
+    unsigned cont = _mm256_movemask_epi8(_mm256_cmpgt_epi8(continuation, v));
+    count += 32-std::popcount(cont);
+    for (unsigned efs = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, bom)); efs;
+         efs &= efs-1)
+      if (is_bom(s+std::countr_zero(efs), end))
+        [[unlikely]] --count;
+  }
+  return count+sse2_chars_count(s, end);
+}
+
+[[gnu::target("avx2")]]
+qsizetype avx2_prefix_size_not_in(
+    const char *s, const char *end, QByteArrayView set) {
+  __m256i needles[MaxBytesSetSize];
+  auto n = set.size();
+  for (qsizetype i = 0; i < n; ++i)
+    needles[i] = _mm256_set1_epi8(set[i]);
+  auto begin = s;
+  for (; s+32 <= end; s += 32) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+    auto found = _mm256_setzero_si256();
+    for (qsizetype i = 0; i < n; ++i)
+      found = _mm256_or_si256(found, _mm256_cmpeq_epi8(v, needles[i]));
+    if (unsigned mask = _mm256_movemask_epi8(found); mask)
+      return s-begin+std::countr_zero(mask);
+  }
+  return s-begin+sse2_prefix_size_not_in(s, end, set);
+}
+
+template <char first, char last>
+[[gnu::target("avx2")]]
+void avx2_ascii_case(char *d, const char *s, qsizetype n) {
+  const auto lower_bound = _mm256_set1_epi8(first-1);
+  const auto upper_bound = _mm256_set1_epi8(last+1);
+  const auto flip = _mm256_set1_epi8(0x20);
+  qsizetype i = 0;
+  for (; i+32 <= n; i += 32) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s+i));
+    auto in_range = _mm256_and_si256(_mm256_cmpgt_epi8(v, lower_bound),
+                                     _mm256_cmpgt_epi8(upper_bound, v));
+    v = _mm256_xor_si256(v, _mm256_and_si256(in_range, flip));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(d+i), v);
+  }
+  sse2_ascii_case<first, last>(d+i, s+i, n-i);
+}
+
+/** checked once, thread-safe and usable during static initialization */
+inline bool has_avx2() {
+  static const bool avx2 = []() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+  }();
+  return avx2;
+}
+
+#endif // P6_UTF8_X86_KERNELS
+
+} // unnamed namespace
+
+qsizetype ascii_prefix_size(const char *s, const char *end) {
+#ifdef P6_UTF8_X86_KERNELS
+  if (end-s >= 32 && has_avx2())
+    return avx2_ascii_prefix_size(s, end);
+  return sse2_ascii_prefix_size(s, end);
+#else
+  return scalar_ascii_prefix_size(s, end);
+#endif
+}
+
+qsizetype valid_prefix_size(const char *s, const char *end) {
+#ifdef P6_UTF8_X86_KERNELS
+  if (end-s >= 32 && has_avx2())
+    return generic_valid_prefix_size<avx2_ascii_prefix_size>(s, end);
+  return generic_valid_prefix_size<sse2_ascii_prefix_size>(s, end);
+#else
+  return generic_valid_prefix_size<scalar_ascii_prefix_size>(s, end);
+#endif
+}
+
+qsizetype chars_count(const char *s, const char *end) {
+#ifdef P6_UTF8_X86_KERNELS
+  if (end-s >= 32 && has_avx2())
+    return avx2_chars_count(s, end);
+  return sse2_chars_count(s, end);
+#else
+  return scalar_chars_count(s, end);
+#endif
+}
+
+qsizetype prefix_size_not_in(
+    const char *s, const char *end, QByteArrayView set) {
+#ifdef P6_UTF8_X86_KERNELS
+  // vectorized kernels hold one register per set byte in a fixed size array
+  if (set.size() > MaxBytesSetSize) [[unlikely]]
+    return scalar_prefix_size_not_in(s, end, set);
+  if (end-s >= 32 && has_avx2())
+    return avx2_prefix_size_not_in(s, end, set);
+  return sse2_prefix_size_not_in(s, end, set);
+#else
+  return scalar_prefix_size_not_in(s, end, set);
+#endif
+}
+
+void ascii_to_upper(char *d, const char *s, qsizetype n) {
+#ifdef P6_UTF8_X86_KERNELS
+  if (n >= 32 && has_avx2())
+    return avx2_ascii_case<'a','z'>(d, s, n);
+  sse2_ascii_case<'a','z'>(d, s, n);
+#else
+  scalar_ascii_case<'a','z'>(d, s, n);
+#endif
+}
+
+void ascii_to_lower(char *d, const char *s, qsizetype n) {
+#ifdef P6_UTF8_X86_KERNELS
+  if (n >= 32 && has_avx2())
+    return avx2_ascii_case<'A','Z'>(d, s, n);
+  sse2_ascii_case<'A','Z'>(d, s, n);
+#else
+  scalar_ascii_case<'A','Z'>(d, s, n);
+#endif
+}
+
+} // namespace p6::utf8
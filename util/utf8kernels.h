@@ -0,0 +1,71 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UTF8KERNELS_H
+#define UTF8KERNELS_H
+
+#include "libp6core_global.h"
+#include <QByteArrayView>
+
+/** Low-level vectorized utf8 bytes processing kernels, used by Utf8String.
+ *
+ *  On x86 they process 16 (SSE2) or 32 (AVX2) bytes per iteration, AVX2 being
+ *  selected at runtime depending on cpu capabilities. On other architectures
+ *  they fall back to scalar (word at a time when possible) implementations.
+ *  Results are always the same whatever implementation is selected.
+ */
+namespace p6::utf8 {
+
+/** Return the number of ascii (< 0x80) bytes at the begining of [s,end). */
+[[nodiscard]] qsizetype LIBP6CORESHARED_EXPORT ascii_prefix_size(
+    const char *s, const char *end);
+/** Return true if [s,end) only contains ascii (< 0x80) bytes. */
+[[nodiscard]] inline bool is_ascii(const char *s, const char *end) {
+  return ascii_prefix_size(s, end) == end-s;
+}
+/** Return the number of bytes at the begining of [s,end) that form valid utf8
+ *  (RFC 3629) sequences, i.e. without overlong sequences, surrogate halves,
+ *  code points above 0x10ffff, out of sequence continuation bytes nor
+ *  incomplete sequence at end.
+ *  Ascii runs are skipped 16 or 32 bytes at a time, other sequences are
+ *  checked one at a time. */
+[[nodiscard]] qsizetype LIBP6CORESHARED_EXPORT valid_prefix_size(
+    const char *s, const char *end);
+/** Return true if [s,end) only contains valid utf8 (RFC 3629) sequences. */
+[[nodiscard]] inline bool is_valid(const char *s, const char *end) {
+  return valid_prefix_size(s, end) == end-s;
+}
+/** Count unicode characters, i.e. bytes that are not continuation bytes, but
+ *  byte order marks.
+ *  Same result than counting Utf8String::go_forward_to_utf8_char<true>()
+ *  steps, without decoding nor validating sequences. */
+[[nodiscard]] qsizetype LIBP6CORESHARED_EXPORT chars_count(
+    const char *s, const char *end);
+/** Convert n bytes from s to d to upper case, converting only ascii letters
+ *  and copying every other byte as is. d and s may be the same. */
+void LIBP6CORESHARED_EXPORT ascii_to_upper(char *d, const char *s, qsizetype n);
+/** Convert n bytes from s to d to lower case, converting only ascii letters
+ *  and copying every other byte as is. d and s may be the same. */
+void LIBP6CORESHARED_EXPORT ascii_to_lower(char *d, const char *s, qsizetype n);
+/** Max number of bytes in prefix_size_not_in() set for vectorized kernels. */
+inline constexpr qsizetype MaxBytesSetSize = 8;
+/** Return the number of bytes at the begining of [s,end) that are not one of
+ *  set bytes, i.e. the index of the first byte in set, or end-s if none.
+ *  Like strcspn() but not stopping on '\0'. Sets larger than MaxBytesSetSize
+ *  are supported but fall back to scalar code. */
+[[nodiscard]] qsizetype LIBP6CORESHARED_EXPORT prefix_size_not_in(
+    const char *s, const char *end, QByteArrayView set);
+
+} // namespace p6::utf8
+
+#endif // UTF8KERNELS_H
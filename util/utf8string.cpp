@@ -203,6 +203,30 @@ static inline Utf8String foldCase(
   return folded;
 }
 
+/** same as foldCase() but with a vectorized fast path for ascii runs, fold and
+ *  ascii_fold must be consistent for ascii chars */
+static inline Utf8String foldCaseAsciiFastPath(
+    const char *s, const char *end, char32_t (*fold)(char32_t),
+    void (*ascii_fold)(char *, const char *, qsizetype)) {
+  Utf8String folded;
+  if (s < end)
+    folded.reserve(end-s);
+  while (s < end) {
+    if (auto n = p6::utf8::ascii_prefix_size(s, end); n) {
+      auto size = folded.size();
+      folded.resize(size+n);
+      ascii_fold(folded.data()+size, s, n);
+      s += n;
+      [[likely]] continue;
+    }
+    if (!Utf8String::go_forward_to_utf8_char(&s, end))
+      break;
+    folded += fold(Utf8String::decode_utf8(s, end));
+    ++s;
+  }
+  return folded;
+}
+
 // TODO turn into template
 static inline Utf8String foldCaseWithHoles(
     const char *s, const char *end, std::function<char32_t(char32_t)> fold,
@@ -291,22 +315,25 @@ Utf8String Utf8String::toInternetHeaderCase() const {
 Utf8String Utf8String::toUpper() const {
   auto s = constData();
   auto end = s + size();
-  return foldCase(
-        s, end, static_cast<char32_t(*)(char32_t)>(&Utf8String::toUpper));
+  return foldCaseAsciiFastPath(
+        s, end, static_cast<char32_t(*)(char32_t)>(&Utf8String::toUpper),
+        &p6::utf8::ascii_to_upper);
 }
 
 Utf8String Utf8String::toLower() const {
   auto s = constData();
   auto end = s + size();
-  return foldCase(
-        s, end, static_cast<char32_t(*)(char32_t)>(&Utf8String::toLower));
+  return foldCaseAsciiFastPath(
+        s, end, static_cast<char32_t(*)(char32_t)>(&Utf8String::toLower),
+        &p6::utf8::ascii_to_lower);
 }
 
 Utf8String Utf8String::toTitle() const {
   auto s = constData();
   auto end = s + size();
-  return foldCase(
-        s, end, static_cast<char32_t(*)(char32_t)>(&Utf8String::toTitle));
+  return foldCaseAsciiFastPath(
+        s, end, static_cast<char32_t(*)(char32_t)>(&Utf8String::toTitle),
+        &p6::utf8::ascii_to_upper); // title case is upper case for ascii
 }
 
 bool Utf8String::isUpper() const {
@@ -16,6 +16,7 @@
 #define UTF8STRING_H
 
 #include "util/numberutils.h"
+#include "util/utf8kernels.h"
 #include <QVariant>
 
 using namespace Qt::Literals::StringLiterals;
@@ -39,6 +40,16 @@ public:
   const static int MetaTypeId;
   const static QList<char> AsciiWhitespace; // ' ', '\t', '\n'...
   const static QList<char32_t> UnicodeWhitespace; // same plus \u0084, \u2000...
+  /** Unicode general categories, as defined in UnicodeData.txt, e.g. Lu for
+   *  upper case letters or Zs for space separators.
+   *  Cn (unassigned) comes first so that it's the default value. */
+  enum UnicodeCategory : quint8 {
+    UnicodeCn = 0, UnicodeLu, UnicodeLl, UnicodeLt, UnicodeLm, UnicodeLo,
+    UnicodeMn, UnicodeMc, UnicodeMe, UnicodeNd, UnicodeNl, UnicodeNo,
+    UnicodePc, UnicodePd, UnicodePs, UnicodePe, UnicodePi, UnicodePf,
+    UnicodePo, UnicodeSm, UnicodeSc, UnicodeSk, UnicodeSo, UnicodeZs,
+    UnicodeZl, UnicodeZp, UnicodeCc, UnicodeCf, UnicodeCs, UnicodeCo,
+  };
   enum WellKnownUnicodeCharacters : char32_t {
     ReplacementCharacter = U'\ufffd',
     ByteOrderMark = U'\ufeff',
@@ -247,6 +258,9 @@ public:
    *  Return the input character itself if no change is needed e.g. E É #
    */
   [[nodiscard, gnu::const]] static inline char32_t toTitle(char32_t u);
+  /** Unicode general category of a character, e.g. UnicodeLu for É. */
+  [[nodiscard, gnu::const]] static inline UnicodeCategory unicode_category(
+      char32_t u);
   [[nodiscard]] Utf8String toUpper() const;
   [[nodiscard]] Utf8String toLower() const;
   [[nodiscard]] Utf8String toTitle() const;
@@ -298,6 +312,9 @@ public:
   template <bool strict = true, bool keep_replacement_chars = false,
             bool keep_bom = false>
   [[nodiscard]] inline Utf8String cleaned() const {
+    if (!isNull() && is_clean<keep_replacement_chars, keep_bom>(
+          constData(), constData()+size()))
+      return *this; // share data rather than copying it
     return cleaned<strict, keep_replacement_chars, keep_bom>(
           constData(), size()); }
   /** Return valid utf8 without invalid sequences. */
@@ -319,6 +336,11 @@ public:
   template <bool strict = true, bool keep_replacement_chars = false,
             bool keep_bom = false>
   inline static void clean(char *s, const char *end);
+  /** Return true if [s,end) is left unchanged by clean(), i.e. only contains
+   *  valid utf8 sequences, and neither replacement chars nor byte order marks
+   *  unless they are kept. */
+  template <bool keep_replacement_chars = false, bool keep_bom = false>
+  [[nodiscard]] inline static bool is_clean(const char *s, const char *end);
 
   // slicing: left right mid trimmed sliced chopped...
   /** Return leftmost len bytes. Empty if len < 0. */
@@ -1205,42 +1227,35 @@ public:
     }
     return false;
   }
-  /** Test if u is a unicode whitespace char: ascii plus \u0084, \u2000... */
+  /** Test if u is a unicode whitespace char: ascii plus \u0084, \u2000...
+   *  i.e. any of UnicodeWhitespace: Zs, Zl, Zp categories plus \t..\r, \u0085
+   */
   [[nodiscard]] inline static bool is_unicode_whitespace(char32_t u) {
-    switch (u) {
-      // horizontal whitespace
-      case ' ': case '\t': case 0xa0: case 0x1680:
-      case 0x2000: case 0x2001: case 0x2002: case 0x2003: case 0x2004:
-      case 0x2005: case 0x2006: case 0x2007: case 0x2008: case 0x2009:
-      case 0x200a: case 0x202f: case 0x205f: case 0x3000:
-      // line, page and section separators
-      case '\n': case '\r': case '\v': case '\f':
-      case 0x85: case 0x2028: case 0x2029:
-        return true;
-    }
-    return false;
+    return unicode_properties(u).whitespace;
   }
-  /** Test if u is a unicode whitespace char: ascii plus \u0084, \u2000... */
+  /** Test if u is a unicode horizontal whitespace char: Zs category plus \t */
   [[nodiscard]] inline static bool is_unicode_horizontal_whitespace(char32_t u){
-    switch (u) {
-      case ' ': case '\t':
-      case 0xa0: case 0x1680:
-      case 0x2000: case 0x2001: case 0x2002: case 0x2003: case 0x2004:
-      case 0x2005: case 0x2006: case 0x2007: case 0x2008: case 0x2009:
-      case 0x200a: case 0x202f: case 0x205f: case 0x3000:
-        return true;
-    }
-    return false;
+    return u == '\t' || unicode_properties(u).category == UnicodeZs;
   }
 
 private:
-  struct UnicodeCaseMapping {
-    char32_t utf32;
-    char32_t upper_utf32, lower_utf32, title_utf32;
-    // LATER add already encoded utf8 here as optimization
-    operator char32_t() const { return utf32; }
+  struct UnicodeProperties {
+    qint32 upper_delta, lower_delta, title_delta; // case mapping minus u
+    UnicodeCategory category;
+    bool whitespace;
   };
-  const static std::vector<UnicodeCaseMapping> _case_mapping;
+  // two-stage table generated by build_unicodedata.sh: u >> 8 selects a 256
+  // characters block (identical blocks are shared), u & 0xff an index in it
+  const static UnicodeProperties _unicode_properties[]; // [0] is unassigned
+  const static quint8 _unicode_properties_indexes[];
+  const static quint8 _unicode_blocks[0x110000 >> 8];
+  [[nodiscard, gnu::const]] static inline const UnicodeProperties &
+  unicode_properties(char32_t u) {
+    if (u > 0x10ffff) [[unlikely]]
+      return _unicode_properties[0];
+    return _unicode_properties[_unicode_properties_indexes[
+        (_unicode_blocks[u >> 8] << 8) | (u & 0xff)]];
+  }
   template<typename F, bool suffixes_enabled>
   [[nodiscard]] static inline F toFloating(
       QByteArray ba, bool *ok, F def,
@@ -1428,10 +1443,10 @@ char32_t Utf8String::decode_utf8_and_step_forward(
     [[unlikely]] return ReplacementCharacter;
   }
   // note: first byte mask intentionnaly keeps 0b0000'1000 bit so that a 5+ bytes
-  // sequence will be >= 0x10'ffff and discarded without specific test
+  // sequence will be > 0x10'ffff and discarded without specific test
   char32_t u = ((c[0] & 0b0000'1111) << 18) | ((c[1] & 0b0011'1111) << 12)
       | ((c[2] & 0b0011'1111) << 6) | (c[3] & 0b0011'1111);
-  if (u >= 0x10'ffff) // RFC 3629: > 0x10ffff are invalid
+  if (u > 0x10'ffff) // RFC 3629: > 0x10ffff are invalid
     [[unlikely]] return ReplacementCharacter;
   if (strict && u < 0x10000) // overlong sequence
     [[unlikely]] return ReplacementCharacter;
@@ -1503,10 +1518,32 @@ Utf8String Utf8String::encode_utf8(char32_t u) {
   return Utf8String(s, sizeof s);
 }
 
+template <bool keep_replacement_chars, bool keep_bom>
+bool Utf8String::is_clean(const char *s, const char *end) {
+  if (!p6::utf8::is_valid(s, end))
+    return false;
+  if (keep_replacement_chars && keep_bom)
+    return true;
+  // replacement chars (ef bf bd) and byte order marks (ef bb bf) both start
+  // with 0xef, which is uncommon enough to just look for it
+  return p6::utf8::prefix_size_not_in(s, end, "\xef") == end-s;
+}
+
 template <bool strict, bool keep_replacement_chars, bool keep_bom>
 void Utf8String::clean(char *s, const char *end) {
+  if (is_clean<keep_replacement_chars, keep_bom>(s, end))
+    return;
   char *d = s; // destination
   while (s < end) {
+    if (static_cast<unsigned char>(*s) < 0x80) {
+      // ascii bytes are always valid and kept as is
+      auto n = p6::utf8::ascii_prefix_size(s, end);
+      if (d != s)
+        ::memmove(d, s, n);
+      s += n;
+      d += n;
+      [[likely]] continue;
+    }
     auto c = decode_utf8_and_step_forward<strict>(
                const_cast<const char**>(&s), end);
     if (!keep_replacement_chars && c == ReplacementCharacter)
@@ -1519,8 +1556,20 @@ void Utf8String::clean(char *s, const char *end) {
 
 template <bool strict, bool keep_replacement_chars, bool keep_bom>
 Utf8String &Utf8String::clean() {
+  if (!isNull() && is_clean<keep_replacement_chars, keep_bom>(
+        constData(), constData()+size()))
+    return *this; // don't even detach
   char *s = data(), *d = s, *begin = s, *end = s+size();
   while (s < end) {
+    if (static_cast<unsigned char>(*s) < 0x80) {
+      // ascii bytes are always valid and kept as is
+      auto n = p6::utf8::ascii_prefix_size(s, end);
+      if (d != s)
+        ::memmove(d, s, n);
+      s += n;
+      d += n;
+      [[likely]] continue;
+    }
     auto c = decode_utf8_and_step_forward<strict>(
                const_cast<const char**>(&s), end);
     if (!keep_replacement_chars && c == ReplacementCharacter)
@@ -1538,6 +1587,14 @@ Utf8String Utf8String::cleaned(const char *s, const char *end) {
   QByteArray cleaned(end-s, Qt::Uninitialized);
   char *d = cleaned.data(), *begin = d; // destination
   while (s < end) {
+    if (static_cast<unsigned char>(*s) < 0x80) {
+      // ascii bytes are always valid and kept as is
+      auto n = p6::utf8::ascii_prefix_size(s, end);
+      ::memcpy(d, s, n);
+      s += n;
+      d += n;
+      [[likely]] continue;
+    }
     auto c = decode_utf8_and_step_forward<strict>(&s, end);
     if (!keep_replacement_chars && c == ReplacementCharacter)
       [[unlikely]] continue;
@@ -1605,26 +1662,29 @@ Utf8String Utf8String::utf8chopped(qsizetype len) const {
 
 qsizetype Utf8String::utf8size() const {
   auto s = constData();
-  auto end = s + size();
-  qsizetype i = 0;
-  for (; go_forward_to_utf8_char(&s, end); ++s)
-    ++i;
-  return i;
+  return p6::utf8::chars_count(s, s + size());
 }
 
 char32_t Utf8String::toUpper(char32_t u) {
-  auto cm = std::lower_bound(_case_mapping.cbegin(), _case_mapping.cend(), u);
-  return cm == _case_mapping.end() || cm->utf32 != u ? u : cm->upper_utf32;
+  if (u < 0x80) // ascii shortcut
+    [[likely]] return u >= 'a' && u <= 'z' ? u - 0x20 : u;
+  return u + unicode_properties(u).upper_delta;
 }
 
 char32_t Utf8String::toLower(char32_t u) {
-  auto cm = std::lower_bound(_case_mapping.cbegin(), _case_mapping.cend(), u);
-  return cm == _case_mapping.end() || cm->utf32 != u ? u : cm->lower_utf32;
+  if (u < 0x80) // ascii shortcut
+    [[likely]] return u >= 'A' && u <= 'Z' ? u + 0x20 : u;
+  return u + unicode_properties(u).lower_delta;
 }
 
 char32_t Utf8String::toTitle(char32_t u) {
-  auto cm = std::lower_bound(_case_mapping.cbegin(), _case_mapping.cend(), u);
-  return cm == _case_mapping.end() || cm->utf32 != u ? u : cm->title_utf32;
+  if (u < 0x80) // ascii shortcut, title case is upper case for ascii
+    [[likely]] return u >= 'a' && u <= 'z' ? u - 0x20 : u;
+  return u + unicode_properties(u).title_delta;
+}
+
+Utf8String::UnicodeCategory Utf8String::unicode_category(char32_t u) {
+  return unicode_properties(u).category;
 }
 
 [[nodiscard]] inline Utf8String Utf8String::number(bool b) {
@@ -0,0 +1,241 @@
+/* Copyright 2025 Gregoire Barbier and others.
+ * This file is part of libpumpkin, see <http://libpumpkin.g76r.eu/>.
+ * Libpumpkin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * Libpumpkin is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ * You should have received a copy of the GNU Affero General Public License
+ * along with libpumpkin.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UTF8STRINGVIEW_H
+#define UTF8STRINGVIEW_H
+
+#include "util/utf8string.h"
+#include <QDebug>
+
+/** Non-owning view on UTF-8 bytes, with the same utf8-aware methods than
+ * Utf8String (utf8size(), utf8mid(), trimmed(), split(), toNumber()...) but
+ * slicing and splitting to views instead of allocating new strings.
+ *
+ * Intended for parsers: substrings are only materialized (e.g. with toUtf8())
+ * when they are stored, e.g.:
+ * for (auto param: Utf8StringView(key).split_headed_list(ml))
+ *   eval(param, context);
+ *
+ * As any view, it must not outlive the viewed bytes, and unlike Utf8String
+ * the viewed bytes are not guaranteed to be followed by a '\0'.
+ * Null-ness is kept: a view on a null Utf8String is null and so is a
+ * Utf8String built from a null view.
+ * Only implicitly built from Utf8String, other sources (QByteArray, char *...)
+ * need an explicit constructor call, to avoid ambiguities with Utf8String
+ * overloads.
+ */
+class Utf8StringView : public QByteArrayView {
+public:
+  constexpr Utf8StringView() noexcept = default;
+  constexpr Utf8StringView(std::nullptr_t) noexcept { }
+  // QByteArray overload rather than generic container one, to keep null-ness
+  Utf8StringView(const Utf8String &s) noexcept
+    : QByteArrayView(static_cast<const QByteArray &>(s)) { }
+  explicit Utf8StringView(const QByteArray &ba) noexcept
+    : QByteArrayView(ba) { }
+  explicit constexpr Utf8StringView(QByteArrayView v) noexcept
+    : QByteArrayView(v) { }
+  explicit constexpr Utf8StringView(const char *s, qsizetype len)
+    : QByteArrayView(s, len) { }
+  explicit constexpr Utf8StringView(const char *begin, const char *end)
+    : QByteArrayView(begin, end) { }
+  explicit Utf8StringView(const char *s)
+    : QByteArrayView(s, s ? qstrlen(s) : 0) { }
+
+  /** Copy viewed bytes to an owning string. */
+  [[nodiscard]] inline Utf8String toUtf8() const {
+    return Utf8String(data(), size()); }
+  [[nodiscard]] inline QString toUtf16() const {
+    return QString::fromUtf8(*this); }
+  [[nodiscard]] inline bool operator!() const { return isNull(); }
+
+  /** Return ith byte, safe if i is out of range. */
+  [[nodiscard]] inline char value(qsizetype i, char def = 0) const {
+    return size() < i+1 || i < 0 ? def : at(i); }
+  [[nodiscard]] inline qsizetype utf8size() const {
+    return p6::utf8::chars_count(begin(), end()); }
+
+  // slicing, same semantics than Utf8String's but returning views
+  /** Return leftmost len bytes. Empty if len < 0. */
+  [[nodiscard]] inline Utf8StringView left(qsizetype len) const {
+    return Utf8StringView(data(), qBound<qsizetype>(0, len, size())); }
+  /** Return rightmost len bytes. Empty if len < 0. */
+  [[nodiscard]] inline Utf8StringView right(qsizetype len) const {
+    len = qBound<qsizetype>(0, len, size());
+    return Utf8StringView(data()+size()-len, len); }
+  /** Return len bytes starting at pos.
+   *  Everything after pos if len < 0 or pos+len > size(). */
+  [[nodiscard]] inline Utf8StringView mid(
+      qsizetype pos, qsizetype len = -1) const {
+    pos = qBound<qsizetype>(0, pos, size());
+    if (len < 0 || len > size()-pos)
+      len = size()-pos;
+    return Utf8StringView(data()+pos, len); }
+  /** like mid() but crashes if out of bound. */
+  [[nodiscard]] inline Utf8StringView sliced(qsizetype pos) const {
+    return Utf8StringView(QByteArrayView::sliced(pos)); }
+  /** like mid() but crashes if out of bound. */
+  [[nodiscard]] inline Utf8StringView sliced(
+      qsizetype pos, qsizetype n) const {
+    return Utf8StringView(QByteArrayView::sliced(pos, n)); }
+  /** like left() but crashes if out of bound. */
+  [[nodiscard]] inline Utf8StringView first(qsizetype n) const {
+    return Utf8StringView(QByteArrayView::first(n)); }
+  /** like right() but crashes if out of bound. */
+  [[nodiscard]] inline Utf8StringView last(qsizetype n) const {
+    return Utf8StringView(QByteArrayView::last(n)); }
+  [[nodiscard]] inline Utf8StringView chopped(qsizetype len) const {
+    return Utf8StringView(QByteArrayView::chopped(len)); }
+  /** Remove ascii whitespace on both sides. */
+  [[nodiscard]] inline Utf8StringView trimmed() const {
+    auto s = begin(), e = end();
+    for (; s < e && Utf8String::is_ascii_whitespace(*s); ++s)
+      ;
+    for (; e > s && Utf8String::is_ascii_whitespace(e[-1]); --e)
+      ;
+    return Utf8StringView(s, e);
+  }
+  /** Return leftmost len unicode characters. */
+  [[nodiscard]] inline Utf8StringView utf8left(qsizetype len) const {
+    auto s = begin(), e = end();
+    auto b = Utf8String::go_forward_to_utf8_char(&s, e);
+    if (!b)
+      return Utf8StringView(e, qsizetype(0));
+    for (qsizetype i = 0; i < len && Utf8String::go_forward_to_utf8_char(
+           &s, e); ++s, ++i)
+      ;
+    return Utf8StringView(b, s); }
+  /** Return rightmost len unicode characters. */
+  [[nodiscard]] inline Utf8StringView utf8right(qsizetype len) const {
+    auto b = begin(), e = end(), s = e;
+    for (qsizetype i = 0; i < len && Utf8String::go_backward_to_utf8_char(
+           &--s, b); ++i)
+      ;
+    if (s < b)
+      s = b;
+    return Utf8StringView(s, e); }
+  /** Return len unicode characters starting at pos.
+   *  Everything after pos if len < 0 or pos+len > size(). */
+  [[nodiscard]] inline Utf8StringView utf8mid(
+      qsizetype pos, qsizetype len = -1) const {
+    auto s = begin(), e = end();
+    for (qsizetype i = 0; i < pos && Utf8String::go_forward_to_utf8_char(
+           &s, e); ++s, ++i)
+      ;
+    if (len < 0)
+      return Utf8StringView(s, e);
+    auto b = s;
+    for (qsizetype i = 0; i < len && Utf8String::go_forward_to_utf8_char(
+           &s, e); ++s, ++i)
+      ;
+    return Utf8StringView(b, s); }
+  /** Return a view without last len unicode characters. */
+  [[nodiscard]] inline Utf8StringView utf8chopped(qsizetype len) const {
+    auto b = begin(), s = end();
+    for (qsizetype i = 0; i < len && Utf8String::go_backward_to_utf8_char(
+           &--s, b); ++i)
+      ;
+    return Utf8StringView(b, s < b ? b : s); }
+
+  // splitting, same semantics than Utf8String's but returning views
+  /** Splitting on utf8 or multi-char separator, starting at offset. */
+  [[nodiscard]] inline QList<Utf8StringView> split_after(
+      Utf8StringView sep, qsizetype offset = 0,
+      Qt::SplitBehavior behavior = Qt::KeepEmptyParts) const {
+    QList<Utf8StringView> list;
+    auto n = size(), w = sep.size();
+    if (offset < 0 || n == 0)
+      return {};
+    auto s = data();
+    qsizetype imax = n-w+1, i = offset, j = i;
+    while (i < n) {
+      if (w && i < imax && ::memcmp(s+i, sep.data(), w) == 0) {
+        if (i-j > 0 || behavior == Qt::KeepEmptyParts)
+          list += Utf8StringView(s+j, i-j);
+        i += w;
+        j = i;
+      } else {
+        ++i;
+      }
+    }
+    if (i-j > 0 || behavior == Qt::KeepEmptyParts)
+      list += Utf8StringView(s+j, i-j);
+    return list;
+  }
+  /** Splitting on ascii 7 separator, e.g. ' ' */
+  [[nodiscard]] inline QList<Utf8StringView> split(
+      const char sep, Qt::SplitBehavior behavior = Qt::KeepEmptyParts) const {
+    return split_after(Utf8StringView(&sep, 1), 0, behavior); }
+  /** Splitting on utf8 or multi-char separator, e.g. "-->", "🥨"_u8 */
+  [[nodiscard]] inline QList<Utf8StringView> split(
+      Utf8StringView sep,
+      Qt::SplitBehavior behavior = Qt::KeepEmptyParts) const {
+    return split_after(sep, 0, behavior); }
+  /** Split using first utf8 char as a delimiter.
+   *  e.g. "/foo/bar/g" -> { "foo", "bar", "g" }
+   *  @see Utf8String::split_headed_list() */
+  [[nodiscard]] inline QList<Utf8StringView> split_headed_list(
+      qsizetype offset = 0) const {
+    auto b = begin(), e = end();
+    auto s = b + offset;
+    auto sep = Utf8String::go_forward_to_utf8_char(&s, e);
+    if (!sep)
+      return {};
+    auto csv = Utf8String::go_forward_to_utf8_char(&++s, e);
+    if (!csv) // nothing after separator
+      return {};
+    auto eos = sep+1;
+    for (; eos < csv && (eos[0]&0b11000000) == 0b10000000; ++eos)
+      ; // go forward over continuation bytes
+    return split_after(Utf8StringView(sep, eos), csv-b);
+  }
+
+  // conversions to numbers, without copying the bytes
+  template <p6::arithmetic T, bool suffixes_enabled = true,
+            bool floating_point_enabled = true>
+  [[nodiscard]] inline T toNumber(bool *ok = nullptr, const T &def = {}) const {
+    return raw().toNumber<T, suffixes_enabled, floating_point_enabled>(
+          ok, def); }
+  template <p6::arithmetic T, bool suffixes_enabled = true,
+            bool floating_point_enabled = true>
+  [[nodiscard]] inline T toNumber(const T &def) const {
+    return raw().toNumber<T, suffixes_enabled, floating_point_enabled>(
+          nullptr, def); }
+  [[nodiscard]] inline double toDouble(
+      bool *ok = nullptr, double def = 0.0) const {
+    return raw().toDouble(ok, def); }
+  [[nodiscard]] inline qlonglong toLongLong(
+      bool *ok = nullptr, int base = 0, qlonglong def = 0) const {
+    return raw().toLongLong(ok, base, def); }
+  [[nodiscard]] inline qulonglong toULongLong(
+      bool *ok = nullptr, int base = 0, qulonglong def = 0) const {
+    return raw().toULongLong(ok, base, def); }
+  [[nodiscard]] inline int toInt(
+      bool *ok = nullptr, int base = 0, int def = 0) const {
+    return raw().toInt(ok, base, def); }
+  [[nodiscard]] inline bool toBool(bool *ok = nullptr, bool def = false) const {
+    return raw().toBool(ok, def); }
+
+private:
+  /** Utf8String sharing the viewed bytes, only for immediate use. */
+  [[nodiscard]] inline Utf8String raw() const {
+    return QByteArray::fromRawData(data(), size()); }
+};
+
+Q_DECLARE_TYPEINFO(Utf8StringView, Q_PRIMITIVE_TYPE);
+
+inline QDebug operator<<(QDebug dbg, Utf8StringView v) {
+  return dbg << v.toUtf16();
+}
+
+#endif // UTF8STRINGVIEW_H
@@ -94,10 +94,10 @@ first_byte:
   if (input->read(buf+1, 3) != 3)
     [[unlikely]] return {-1, Utf8String::ReplacementCharacter};
   // note: first byte mask intentionnaly keeps 0b0000'1000 bit so that 5+ bytes
-  // sequences will be >= 0x10'ffff and discarded without specific test
+  // sequences will be > 0x10'ffff and discarded without specific test
   char32_t u = ((c[0] & 0b0000'1111) << 18) | ((c[1] & 0b0011'1111) << 12)
       | ((c[2] & 0b0011'1111) << 6) | (c[3] & 0b0011'1111);
-  if (u >= 0x10'ffff) // RFC 3629: > 0x10ffff are invalid
+  if (u > 0x10'ffff) // RFC 3629: > 0x10ffff are invalid
     [[unlikely]] return {-1, Utf8String::ReplacementCharacter};
   if (strict && u < 0x10000) // overlong sequence
     [[unlikely]] return {-1, Utf8String::ReplacementCharacter};